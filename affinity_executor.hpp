@@ -0,0 +1,592 @@
+/**
+ * @file      affinity_executor.hpp
+ * @brief     依 NUMA 節點分組、把工作執行緒綁在核心上的執行緒池，工作可以指定要在哪個節點執行
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::affinity_executor ex;                                   // 每個核心一條執行緒，綁在該核心上
+ *     ex.post(std::bind(&Shard::Flush, shard));                    // 在呼叫端目前所在的節點執行
+ *     ex.post(std::bind(&Shard::Flush, shard), 1);                 // 指定在第1個節點執行
+ *     ex.post_near(std::bind(&Shard::Flush, shard), shard);        // 在shard這塊記憶體所在的節點執行
+ *
+ *     std::affinity_executor ex2(2, std::affinity_executor::pin_node);    // 每個節點兩條執行緒，可以在節點內的核心間移動
+ *
+ * 節點編號是 0 到 nodes()-1，不一定等於系統的節點編號，超出範圍的一律當成0
+ * 每個節點有自己的佇列，工作只會交給該節點的執行緒，不會被別的節點拿走
+ *
+ * 每個節點的佇列、鎖以及放工作的記憶體，都配置在該節點的記憶體上(mbind)
+ * function 的核心直接複製進節點上的工作記憶體，超過 task_capacity 個位元組的才退回 heap，由呼叫端所在的節點配置
+ * 工作執行緒一建立就綁在節點上，堆疊也就落在該節點
+ * 某個節點一條執行緒都建不起來時，送到那裡的工作改交給第一個有執行緒的節點，全部都建不起來時 post() 回傳 false
+ *
+ * 拓撲從 /sys/devices/system/node 讀取，只保留目前行程被允許使用的核心
+ * 讀不到時(沒有 NUMA、容器限制等等)就當成只有一個節點，numa() 回傳 false
+ * 直接使用系統呼叫，不需要 libnuma
+ *
+ * 工作不可以丟出例外，解構時會先把排隊中的工作做完
+ * 只支援 Linux
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_AFFINITY_EXECUTOR_HPP_
+#define _STD_AFFINITY_EXECUTOR_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif defined(__linux__)
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _affinity{
+
+enum
+{
+	mpol_preferred = 1,         // MPOL_PREFERRED
+	mpol_f_node    = 1<<0,      // MPOL_F_NODE
+	mpol_f_addr    = 1<<1,      // MPOL_F_ADDR
+	chunk_size     = 64*1024,   // 工作記憶體每次向節點要多少
+	task_capacity  = 96         // 工作裡放function核心的空間
+};
+
+// 解析 "0-3,8-11" 這種格式
+inline void parse_list(const char *s, std::vector<int> &out)
+{
+	while ( *s )
+	{
+		char *e;
+		long a = strtol(s, &e, 10);
+
+		if ( e==s ) break;
+
+		long b = a;
+		s = e;
+
+		if ( *s=='-' )
+		{
+			b = strtol(s+1, &e, 10);
+			s = e;
+		}
+
+		for ( long i=a ; i<=b ; i++ )
+		{
+			out.push_back(int(i));
+		}
+
+		if ( *s!=',' ) break;
+		s++;
+	}
+}
+
+inline bool read_list(const char *path, std::vector<int> &out)
+{
+	FILE *f = fopen(path, "r");
+
+	if ( !f ) return false;
+
+	char buf[4096];
+	bool ok = fgets(buf, sizeof(buf), f)!=0;
+	fclose(f);
+
+	if ( ok ) parse_list(buf, out);
+
+	return ok;
+}
+
+/// 每個節點有哪些核心可以用
+struct topology
+{
+	topology():numa(false)
+	{
+		cpu_set_t allowed;
+		bool limited = sched_getaffinity(0, sizeof(allowed), &allowed)==0;
+
+		std::vector<int> online;
+
+		if ( read_list("/sys/devices/system/node/online", online) )
+		{
+			for ( size_t i=0 ; i<online.size() ; i++ )
+			{
+				char path[64];
+				std::vector<int> list;
+				std::vector<int> usable;
+
+				sprintf(path, "/sys/devices/system/node/node%d/cpulist", online[i]);
+
+				if ( !read_list(path, list) ) continue;
+
+				for ( size_t k=0 ; k<list.size() ; k++ )
+				{
+					if ( list[k] < CPU_SETSIZE && ( !limited || CPU_ISSET(list[k], &allowed) ) )
+					{
+						usable.push_back(list[k]);
+					}
+				}
+
+				if ( usable.empty() ) continue;
+
+				cpus.push_back(usable);
+				ids.push_back(online[i]);
+			}
+
+			numa = !cpus.empty();
+		}
+
+		if ( !numa )
+		{
+			std::vector<int> all;
+			long n = sysconf(_SC_NPROCESSORS_CONF);
+
+			for ( long i=0 ; i<n && i<CPU_SETSIZE ; i++ )
+			{
+				if ( !limited || CPU_ISSET(i, &allowed) ) all.push_back(int(i));
+			}
+
+			if ( all.empty() ) all.push_back(0);
+
+			cpus.assign(1, all);
+			ids.assign(1, 0);
+		}
+	}
+
+	std::vector< std::vector<int> >     cpus;
+	std::vector<int>                    ids;    // 系統的節點編號
+	bool                                numa;
+};
+
+/// 向某個節點要記憶體，不支援時就是一般的匿名記憶體
+inline void* node_alloc(size_t bytes, int id, bool numa)
+{
+	void *p = mmap(0, bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+	if ( p==MAP_FAILED ) return 0;
+
+	if ( numa && id < int(sizeof(unsigned long)*8) )
+	{
+		unsigned long mask = 1UL << id;
+		syscall(SYS_mbind, p, bytes, int(mpol_preferred), &mask, sizeof(mask)*8, 0);    // 失敗也沒關係
+	}
+
+	return p;
+}
+
+/// 排隊中的工作，function的核心直接複製到自己身上，跟著task一起落在節點的記憶體上
+struct task
+{
+	typedef function<void()>::St            St;
+	typedef _functional::core_base<void,St> core;
+
+	explicit task(const function<void()> &f):next(0)
+	{
+		local = f.pCore->footprint() <= sizeof(store);
+		fn = local ? f.pCore->clone_to(&store) : f.pCore->clone();
+	}
+
+	~task()
+	{
+		if ( local )                              fn->~core();
+		else if ( fn!=function<void()>::empty() ) delete fn;
+	}
+
+	inline void operator()() const { fn->CallFunction(St()); }
+
+	union
+	{
+		_functional::max_align  align;
+		char                    buf[task_capacity];
+	}                   store;
+	core                *fn;
+	bool                local;      // fn在store裡，不是heap上
+	task                *next;
+
+	private:
+
+		task(const task&);
+		task& operator=(const task&);
+};
+
+/// 一個節點的佇列，整個物件本身也配置在該節點上
+class node
+{
+	public:
+
+		node(int id, bool numa):id_(id),numa_(numa),head_(0),tail_(0),free_(0),chunks_(0),carve_(0),left_(0),idle_(0),stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&wake_, 0);
+		}
+
+		~node()
+		{
+			while ( chunks_ )
+			{
+				void *next = *static_cast<void**>(chunks_);
+				munmap(chunks_, chunk_size);
+				chunks_ = next;
+			}
+
+			pthread_cond_destroy(&wake_);
+			pthread_mutex_destroy(&lock_);
+		}
+
+		/// 取得記憶體、建立工作、排進佇列都在同一次上鎖裡完成
+		bool push(const function<void()> &f)
+		{
+			pthread_mutex_lock(&lock_);
+
+			void *mem = allocate();
+
+			if ( !mem )
+			{
+				pthread_mutex_unlock(&lock_);
+				return false;
+			}
+
+			task *t = new (mem) task(f);
+
+			if ( tail_ ) tail_->next = t;
+			else         head_ = t;
+
+			tail_ = t;
+
+			if ( idle_ ) pthread_cond_signal(&wake_);
+
+			pthread_mutex_unlock(&lock_);
+			return true;
+		}
+
+		/// 工作執行緒的主迴圈，停止並且佇列清空才返回
+		void run()
+		{
+			task *done = 0;
+
+			pthread_mutex_lock(&lock_);
+
+			for (;;)
+			{
+				if ( done )
+				{
+					// 做完的工作在拿下一個的時候順便收回
+					done->~task();
+					done->next = free_;
+					free_ = done;
+					done = 0;
+				}
+
+				while ( !head_ && !stop_ )
+				{
+					idle_++;
+					pthread_cond_wait(&wake_, &lock_);
+					idle_--;
+				}
+
+				if ( !head_ ) break;
+
+				task *t = head_;
+				head_ = t->next;
+
+				if ( !head_ ) tail_ = 0;
+
+				pthread_mutex_unlock(&lock_);
+
+				(*t)();
+				done = t;
+
+				pthread_mutex_lock(&lock_);
+			}
+
+			pthread_mutex_unlock(&lock_);
+		}
+
+		void stop()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_broadcast(&wake_);
+			pthread_mutex_unlock(&lock_);
+		}
+
+	private:
+
+		node(const node&);
+		node& operator=(const node&);
+
+		// 先用收回來的，不夠再從節點上的大塊記憶體切
+		void* allocate()
+		{
+			if ( free_ )
+			{
+				task *t = free_;
+				free_ = t->next;
+				return t;
+			}
+
+			if ( left_ < sizeof(task) )
+			{
+				void *chunk = node_alloc(chunk_size, id_, numa_);
+
+				if ( !chunk ) return 0;
+
+				*static_cast<void**>(chunk) = chunks_;
+				chunks_ = chunk;
+
+				// 開頭留給串接用的指標，切的時候對齊到task
+				size_t head = (sizeof(void*) + sizeof(task) - 1) / sizeof(task) * sizeof(task);
+
+				carve_ = static_cast<char*>(chunk) + head;
+				left_  = chunk_size - head;
+			}
+
+			void *p = carve_;
+			carve_ += sizeof(task);
+			left_  -= sizeof(task);
+			return p;
+		}
+
+		int                 id_;
+		bool                numa_;
+		pthread_mutex_t     lock_;
+		pthread_cond_t      wake_;
+		task                *head_;
+		task                *tail_;
+		task                *free_;     // 執行完的工作記憶體
+		void                *chunks_;   // 向節點要來的大塊記憶體，串成串列
+		char                *carve_;
+		size_t              left_;
+		size_t              idle_;      // 正在等工作的執行緒
+		bool                stop_;
+};
+
+}//namespace _affinity
+
+
+/// 以NUMA節點分組的執行緒池
+class affinity_executor
+{
+	public:
+
+		enum pin_mode
+		{
+			pin_none,       // 不綁
+			pin_node,       // 綁在節點的所有核心上，節點內可以移動
+			pin_core        // 每條執行緒綁在一個核心上
+		};
+
+		/// threads_per_node為0時，每個節點的執行緒數量等於該節點可用的核心數量
+		explicit affinity_executor(size_t threads_per_node = 0, pin_mode pin = pin_core)
+		{
+			size_t count = topo_.cpus.size();
+
+			nodes_.resize(count);
+			mapped_.resize(count, true);
+			route_.resize(count, count);
+
+			for ( size_t i=0 ; i<count ; i++ )
+			{
+				void *mem = _affinity::node_alloc(sizeof(_affinity::node), topo_.ids[i], topo_.numa);
+
+				if ( !mem )
+				{
+					mem = ::operator new(sizeof(_affinity::node));
+					mapped_[i] = false;
+				}
+
+				nodes_[i] = new (mem) _affinity::node(topo_.ids[i], topo_.numa);
+			}
+
+			for ( size_t i=0 ; i<count ; i++ )
+			{
+				const std::vector<int> &cpus = topo_.cpus[i];
+
+				for ( size_t k=0 ; k<cpus.size() ; k++ )
+				{
+					if ( size_t(cpus[k]) >= cpu_node_.size() ) cpu_node_.resize(cpus[k]+1, 0);
+					cpu_node_[cpus[k]] = i;
+				}
+
+				size_t n = threads_per_node ? threads_per_node : cpus.size();
+				size_t before = threads_.size();
+
+				for ( size_t k=0 ; k<n ; k++ )
+				{
+					pthread_attr_t attr;
+					pthread_attr_init(&attr);
+
+					if ( pin!=pin_none )
+					{
+						// 建立時就綁好，堆疊第一次被碰到時已經在節點上了
+						cpu_set_t set;
+						CPU_ZERO(&set);
+
+						if ( pin==pin_core )
+						{
+							CPU_SET(cpus[k % cpus.size()], &set);
+						}
+						else
+						{
+							for ( size_t c=0 ; c<cpus.size() ; c++ ) CPU_SET(cpus[c], &set);
+						}
+
+						pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+					}
+
+					pthread_t th;
+
+					// 綁不上去(例如核心被cgroup拿走了)就不綁，總不能讓節點沒人做事
+					if ( pthread_create(&th, &attr, &affinity_executor::worker_main, nodes_[i])==0 ||
+					     pthread_create(&th, 0, &affinity_executor::worker_main, nodes_[i])==0 )
+					{
+						threads_.push_back(th);
+					}
+
+					pthread_attr_destroy(&attr);
+				}
+
+				if ( threads_.size() > before ) route_[i] = i;
+			}
+
+			// 沒有執行緒的節點，工作改交給第一個有執行緒的節點，不然排進去就永遠不會被執行
+			for ( size_t i=0 ; i<count ; i++ )
+			{
+				if ( route_[i] < count ) continue;
+
+				for ( size_t k=0 ; k<count ; k++ )
+				{
+					if ( route_[k]==k )
+					{
+						route_[i] = k;
+						break;
+					}
+				}
+			}
+		}
+
+		~affinity_executor()
+		{
+			for ( size_t i=0 ; i<nodes_.size() ; i++ )
+			{
+				nodes_[i]->stop();
+			}
+
+			for ( size_t i=0 ; i<threads_.size() ; i++ )
+			{
+				pthread_join(threads_[i], 0);
+			}
+
+			for ( size_t i=0 ; i<nodes_.size() ; i++ )
+			{
+				nodes_[i]->~node();
+
+				if ( mapped_[i] ) munmap(nodes_[i], sizeof(_affinity::node));
+				else              ::operator delete(nodes_[i]);
+			}
+		}
+
+		/// 在呼叫端目前所在的節點執行
+		inline bool post(const function<void()> &f)
+		{
+			return post(f, current_node());
+		}
+
+		/// 在指定的節點執行，記憶體不足或一條工作執行緒都沒有時回傳false
+		inline bool post(const function<void()> &f, size_t node)
+		{
+			if ( node >= nodes_.size() ) node = 0;
+
+			node = route_[node];
+
+			if ( node >= nodes_.size() ) return false;
+
+			return nodes_[node]->push(f);
+		}
+
+		/// 在data所在的節點執行，查不到就用呼叫端目前所在的節點
+		inline bool post_near(const function<void()> &f, const void *data)
+		{
+			return post(f, node_of(data));
+		}
+
+		/// 呼叫端目前在哪個節點上
+		size_t current_node() const
+		{
+			int cpu = sched_getcpu();
+
+			if ( cpu < 0 || size_t(cpu) >= cpu_node_.size() ) return 0;
+
+			return cpu_node_[cpu];
+		}
+
+		/// data這塊記憶體在哪個節點上，還沒被碰過的頁面會被當成呼叫端所在的節點
+		size_t node_of(const void *data) const
+		{
+			if ( topo_.numa )
+			{
+				int id = -1;
+
+				if ( syscall(SYS_get_mempolicy, &id, 0, 0, data, int(_affinity::mpol_f_node|_affinity::mpol_f_addr))==0 )
+				{
+					for ( size_t i=0 ; i<topo_.ids.size() ; i++ )
+					{
+						if ( topo_.ids[i]==id ) return i;
+					}
+				}
+			}
+
+			return current_node();
+		}
+
+		/// 節點數量
+		inline size_t nodes() const { return nodes_.size(); }
+
+		/// 某個節點可用的核心
+		inline const std::vector<int>& cpus(size_t node) const { return topo_.cpus[node]; }
+
+		/// 工作執行緒總數
+		inline size_t size() const { return threads_.size(); }
+
+		/// 拓撲是否從 /sys 讀到的
+		inline bool numa() const { return topo_.numa; }
+
+	private:
+
+		affinity_executor(const affinity_executor&);        // 不允許複製
+		affinity_executor& operator=(const affinity_executor&);
+
+		static void* worker_main(void *p)
+		{
+			static_cast<_affinity::node*>(p)->run();
+			return 0;
+		}
+
+		_affinity::topology             topo_;
+		std::vector<_affinity::node*>   nodes_;
+		std::vector<bool>               mapped_;    // 節點記憶體是mmap來的，失敗時退回operator new
+		std::vector<size_t>             cpu_node_;  // 核心編號對應到節點
+		std::vector<size_t>             route_;     // 工作實際交給哪個節點，沒有執行緒的節點會轉給別的節點
+		std::vector<pthread_t>          threads_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_AFFINITY_EXECUTOR_HPP_
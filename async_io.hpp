@@ -0,0 +1,455 @@
+/**
+ * @file      async_io.hpp
+ * @brief     用 io_uring 批次送出檔案讀寫，完成時呼叫對應的 callback
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::async_io io(256);
+ *     io.read(fd, buf, 4096, 0, std::bind(&Loader::OnRead, &loader, _1, chunk));
+ *     io.read(fd, buf2, 4096, 4096, &OnRead);
+ *     io.submit();             // 一次系統呼叫送出全部
+ *     io.wait(1);              // 至少等到一筆完成，並呼叫完成的callback
+ *
+ * callback 的簽名是 void(int res)，res 就是 read()/write() 的回傳值，失敗時是 -errno
+ * callback 以 inplace_function 的形式放在預先配置好的 slot 裡，每筆I/O都不會配置記憶體
+ * slot 用完時 read()/write() 回傳 false，errno 為 EBUSY，請先 poll()/wait() 收掉一些結果
+ * 送出之前 buf 必須一直有效，直到對應的 callback 被呼叫為止
+ *
+ * callback 裡可以再送出新的讀寫，但不要在 callback 裡呼叫 poll()/wait()
+ * callback 丟出的例外會從 poll()/wait() 傳出去，slot 照樣會還回來，其他結果留到下一次再收
+ * 解構時會取消還沒完成的請求並等到全部有結果，被取消的 callback 收到 -ECANCELED
+ * 真的等不到結果的話(io_uring_enter 出了無法重試的錯)，slot 跟 ring 會留著不釋放，免得核心寫到已經釋放的記憶體
+ *
+ * 直接使用系統呼叫，不需要 liburing，只支援 Linux 5.6 以後的核心
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_ASYNC_IO_HPP_
+#define _STD_ASYNC_IO_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif defined(__linux__)
+
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <inplace_function.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+/// 以io_uring為基礎的非同步檔案讀寫
+class async_io
+{
+	public:
+
+		enum
+		{
+			callback_capacity = 48      // 每個callback最多能佔用的位元組
+		};
+
+		typedef inplace_function<void(int), callback_capacity> callback;
+
+		/// entries是一次最多能排隊送出的數量，核心會調整成2的次方
+		explicit async_io(unsigned entries = 256)
+			:fd_(-1),sq_ptr_(0),cq_ptr_(0),sqes_(0),sq_len_(0),cq_len_(0),sqes_len_(0),
+			 slots_(0),slot_count_(0),free_(-1),queued_(0),inflight_(0),closing_(false)
+		{
+			io_uring_params p;
+			memset(&p, 0, sizeof(p));
+
+			fd_ = int(syscall(__NR_io_uring_setup, entries, &p));
+
+			if ( fd_<0 ) return;
+
+			if ( !map_rings(p) )
+			{
+				int e = errno;
+				unmap_rings();
+				close(fd_);
+				fd_ = -1;
+				errno = e;
+				return;
+			}
+
+			// 每個請求解構時最多再加上一筆取消，兩筆結果都要放得進完成佇列，所以slot只準備一半
+			slot_count_ = p.cq_entries / 2;
+			slots_ = new slot[slot_count_];
+
+			for ( unsigned i=0 ; i<slot_count_ ; i++ )
+			{
+				slots_[i].next = int(i+1<slot_count_ ? i+1 : -1);
+			}
+
+			free_ = 0;
+		}
+
+		~async_io()
+		{
+			if ( !drain() )
+			{
+				close(fd_);         // 核心自己會取消剩下的請求，只是結果已經沒人收了
+				return;
+			}
+
+			delete [] slots_;
+			unmap_rings();
+
+			if ( fd_>=0 ) close(fd_);
+		}
+
+		/// 建立io_uring失敗的話是false，原因留在errno
+		inline bool valid() const { return fd_>=0; }
+
+		/// 排一筆從fd的offset位置讀取len個位元組到buf的請求
+		template<typename T>
+		bool read(int fd, void *buf, unsigned len, uint64_t offset, const T &cb)
+		{
+			return queue(IORING_OP_READ, fd, buf, len, offset, cb);
+		}
+
+		/// 排一筆把buf的len個位元組寫到fd的offset位置的請求，offset填-1代表目前的檔案位置
+		template<typename T>
+		bool write(int fd, const void *buf, unsigned len, uint64_t offset, const T &cb)
+		{
+			return queue(IORING_OP_WRITE, fd, const_cast<void*>(buf), len, offset, cb);
+		}
+
+		/// 把排好的請求一次送進核心，回傳送出的數量，出錯時回傳-1
+		int submit()
+		{
+			return enter(0, 0);
+		}
+
+		/// 收下已經完成的結果並呼叫callback，不會等待，回傳呼叫了幾個callback
+		int poll()
+		{
+			return reap();
+		}
+
+		/// 送出排好的請求，並等到至少min_complete筆完成，回傳呼叫了幾個callback，出錯時回傳-1
+		int wait(unsigned min_complete)
+		{
+			if ( min_complete > inflight_ + queued_ ) min_complete = inflight_ + queued_;
+
+			if ( enter(min_complete, IORING_ENTER_GETEVENTS)<0 ) return -1;
+
+			return reap();
+		}
+
+		/// 還沒被呼叫callback的請求數量，包括還沒送出的
+		inline size_t pending() const { return inflight_ + queued_; }
+
+	private:
+
+		async_io(const async_io&);              // 不允許複製
+		async_io& operator=(const async_io&);
+
+		enum
+		{
+			cancel_tag = -1         // 取消請求本身的user_data，完成時沒有callback要呼叫
+		};
+
+		// 呼叫callback期間的記號，callback丟出例外也一定會把slot還回去
+		struct slot_guard
+		{
+			slot_guard(async_io *io, int i):owner(io),index(i){}
+			~slot_guard(){ owner->give_slot(index); }
+
+			async_io    *owner;
+			int         index;
+		};
+
+		struct slot
+		{
+			slot():next(-1),busy(false){}
+
+			callback    cb;
+			int         next;       // 下一個空的slot，只在閒置時有意義
+			bool        busy;       // 請求還沒有結果
+		};
+
+		//-----------------------------------排隊與送出-----------------------------------start
+
+		template<typename T>
+		bool queue(unsigned char op, int fd, void *buf, unsigned len, uint64_t offset, const T &cb)
+		{
+			int i = take_slot();
+
+			if ( i<0 ) return false;
+
+			slots_[i].cb = cb;
+			return push(op, fd, buf, len, offset, i);
+		}
+
+		bool queue(unsigned char op, int fd, void *buf, unsigned len, uint64_t offset, const function<void(int)> &cb)
+		{
+			int i = take_slot();
+
+			if ( i<0 ) return false;
+
+			slots_[i].cb.emplace< function<void(int)> >(cb);
+			return push(op, fd, buf, len, offset, i);
+		}
+
+		int take_slot()
+		{
+			if ( fd_<0 || closing_ )
+			{
+				errno = EBADF;
+				return -1;
+			}
+
+			if ( free_<0 )
+			{
+				errno = EBUSY;
+				return -1;
+			}
+
+			int i = free_;
+			free_ = slots_[i].next;
+			slots_[i].busy = true;
+			return i;
+		}
+
+		void give_slot(int i)
+		{
+			slots_[i].busy = false;
+			slots_[i].cb.reset();
+			slots_[i].next = free_;
+			free_ = i;
+		}
+
+		bool push(unsigned char op, int fd, void *buf, unsigned len, uint64_t offset, int i)
+		{
+			// 送出佇列滿了就先送一批進去
+			if ( queued_ >= *sq_entries_ && enter(0, 0)<0 )
+			{
+				if ( i!=cancel_tag ) give_slot(i);
+				return false;
+			}
+
+			unsigned tail = *sq_tail_;
+			unsigned idx  = tail & *sq_mask_;
+			io_uring_sqe *sqe = &sqes_[idx];
+
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode    = op;
+			sqe->fd        = fd;
+			sqe->addr      = uint64_t(uintptr_t(buf));
+			sqe->len       = len;
+			sqe->off       = offset;
+			sqe->user_data = uint64_t(i);
+
+			sq_array_[idx] = idx;
+			__atomic_store_n(sq_tail_, tail+1, __ATOMIC_RELEASE);     // 核心看到新的tail時，sqe必須已經寫好
+			queued_++;
+			return true;
+		}
+
+		int enter(unsigned min_complete, unsigned flags)
+		{
+			if ( fd_<0 )
+			{
+				errno = EBADF;
+				return -1;
+			}
+
+			int n;
+
+			do
+			{
+				n = int(syscall(__NR_io_uring_enter, fd_, queued_, min_complete, flags, (void*)0, size_t(0)));
+			}
+			while ( n<0 && errno==EINTR );
+
+			if ( n<0 ) return -1;
+
+			queued_   -= unsigned(n);
+			inflight_ += unsigned(n);
+			return n;
+		}
+
+		//-----------------------------------排隊與送出-----------------------------------end
+
+		// 把完成佇列裡的結果全部收下來
+		int reap()
+		{
+			int called = 0;
+			unsigned head = *cq_head_;
+
+			for (;;)
+			{
+				unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+				if ( head==tail ) break;
+
+				const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+				int i   = int(cqe.user_data);
+				int res = cqe.res;
+
+				head++;
+				__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);  // 先把位置還給核心，callback裡才能再送出新的請求
+				inflight_--;
+
+				if ( i==cancel_tag ) continue;
+
+				slot_guard guard(this, i);
+				called++;
+				slots_[i].cb(res);
+			}
+
+			return called;
+		}
+
+		// 送出排好的請求，等到至少min_complete筆完成並收下結果
+		// 核心暫時不收(EBUSY/EAGAIN)就先收掉已有的結果再試，其他錯誤回傳false
+		bool settle(unsigned min_complete)
+		{
+			if ( min_complete > inflight_ + queued_ ) min_complete = inflight_ + queued_;
+
+			while ( enter(min_complete, IORING_ENTER_GETEVENTS)<0 )
+			{
+				if ( errno!=EBUSY && errno!=EAGAIN ) return false;
+
+				if ( reap()==0 ) sched_yield();
+			}
+
+			reap();
+			return true;
+		}
+
+		// 核心可能還在寫ring跟buf，解構之前先取消所有請求並等到全部都有結果
+		// 已經開始執行而取消不了的就等它做完，callback照樣會被呼叫
+		// 收不到全部結果的話回傳false，這時候什麼都不能釋放
+		bool drain()
+		{
+			if ( fd_<0 ) return true;
+
+			closing_ = true;                        // callback裡不能再送出新的請求
+
+			if ( !settle(0) ) return false;         // 排好的先送進核心，才有辦法取消
+
+			for ( unsigned i=0 ; i<slot_count_ ; i++ )
+			{
+				if ( !slots_[i].busy ) continue;    // 前面收結果的時候可能已經完成了
+
+				// 每送一筆取消就收一次結果，完成佇列裡最多只有請求本身跟它的取消，不會滿出來
+				if ( !push(IORING_OP_ASYNC_CANCEL, -1, reinterpret_cast<void*>(uintptr_t(i)), 0, 0, cancel_tag) ) return false;
+				if ( !settle(0) ) return false;
+			}
+
+			while ( inflight_ + queued_ )
+			{
+				if ( !settle(1) ) return false;
+			}
+
+			return true;
+		}
+
+		//-----------------------------------映射ring-----------------------------------start
+
+		bool map_rings(const io_uring_params &p)
+		{
+			sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+			cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+			bool single = (p.features & IORING_FEAT_SINGLE_MMAP)!=0;
+
+			if ( single && cq_len_ > sq_len_ ) sq_len_ = cq_len_;
+
+			sq_ptr_ = mmap(0, sq_len_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+
+			if ( sq_ptr_==MAP_FAILED ) { sq_ptr_ = 0; return false; }
+
+			if ( single )
+			{
+				cq_ptr_ = sq_ptr_;
+			}
+			else
+			{
+				cq_ptr_ = mmap(0, cq_len_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+
+				if ( cq_ptr_==MAP_FAILED ) { cq_ptr_ = 0; return false; }
+			}
+
+			void *sqes = mmap(0, p.sq_entries * sizeof(io_uring_sqe), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQES);
+
+			if ( sqes==MAP_FAILED ) return false;
+
+			sqes_       = static_cast<io_uring_sqe*>(sqes);
+			sqes_len_   = p.sq_entries * sizeof(io_uring_sqe);
+
+			char *sq = static_cast<char*>(sq_ptr_);
+			char *cq = static_cast<char*>(cq_ptr_);
+
+			sq_tail_    = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+			sq_mask_    = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+			sq_entries_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_entries);
+			sq_array_   = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+
+			cq_head_    = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+			cq_tail_    = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+			cq_mask_    = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+			cqes_       = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+			return true;
+		}
+
+		void unmap_rings()
+		{
+			if ( sqes_ )                    munmap(sqes_, sqes_len_);
+			if ( cq_ptr_ && cq_ptr_!=sq_ptr_ ) munmap(cq_ptr_, cq_len_);
+			if ( sq_ptr_ )                  munmap(sq_ptr_, sq_len_);
+
+			sqes_ = 0;
+			cq_ptr_ = 0;
+			sq_ptr_ = 0;
+		}
+
+		//-----------------------------------映射ring-----------------------------------end
+
+		int             fd_;
+		void            *sq_ptr_;
+		void            *cq_ptr_;
+		io_uring_sqe    *sqes_;
+		size_t          sq_len_;
+		size_t          cq_len_;
+		size_t          sqes_len_;
+
+		unsigned        *sq_tail_;
+		unsigned        *sq_mask_;
+		unsigned        *sq_entries_;
+		unsigned        *sq_array_;
+		unsigned        *cq_head_;
+		unsigned        *cq_tail_;
+		unsigned        *cq_mask_;
+		io_uring_cqe    *cqes_;
+
+		slot            *slots_;        // 建構時一次配置好，之後不再配置
+		unsigned        slot_count_;
+		int             free_;          // 空slot串列的開頭，-1代表用完了
+		unsigned        queued_;        // 已經排好但還沒送進核心的數量
+		unsigned        inflight_;      // 已經送進核心但還沒收到結果的數量
+		bool            closing_;       // 正在解構，不再接受新的請求
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_ASYNC_IO_HPP_
@@ -0,0 +1,524 @@
+/**
+ * @file      async_logger.hpp
+ * @brief     熱路徑只複製參數，格式化與寫檔交給背景執行緒的非同步日誌
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::async_logger log(stderr);                           // 也可以給fopen()開好的檔案
+ *     log.write("order %d filled at %.2f\n", id, price);       // 只把id與price複製進這條執行緒的佇列
+ *     log.write("%s ready\n", name);                           // char name[16]，陣列會整個複製進去
+ *
+ *     if ( log.dropped() ) ...                                 // 佇列滿了被丟掉的筆數
+ *
+ * 每一筆紀錄就是格式字串加上一個 storageN 物件，跟 bind() 儲存參數的方式一樣
+ * 呼叫端只在自己的環狀佇列裡切一塊記憶體、把參數原封不動複製進去，不格式化、不上鎖、也不配置記憶體
+ * 背景執行緒輪流掃過每條執行緒的佇列，用 fprintf() 格式化並寫出
+ *
+ * 參數只能是整數、浮點數、指標、陣列這類可以直接交給 printf 的東西，最多九個
+ * 陣列(包括字串常數)會整份複製進紀錄，呼叫端之後改掉內容也沒關係，但越長的陣列越佔佇列空間
+ * 格式化是稍後才發生的，所以用指標(char*)傳進來的字串必須一直有效
+ * 同一條執行緒寫的紀錄保持順序，不同執行緒之間不保證
+ * 佇列滿了就直接丟掉，write() 回傳 false 並計入 dropped()，不會讓呼叫端等待
+ *
+ * 每條執行緒第一次寫入時配置自己的佇列，執行緒結束後佇列會留到 async_logger 解構為止
+ * 解構時會把所有佇列寫完才返回
+ * 背景執行緒建不起來時改成在呼叫端上鎖、當場格式化並寫出，紀錄不會遺失，只是變慢
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_ASYNC_LOGGER_HPP_
+#define _STD_ASYNC_LOGGER_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+#include <bind.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _log{
+
+enum
+{
+	align = 16      // 每筆紀錄的大小都對齊到這裡
+};
+
+/// 陣列整個複製進紀錄，呼叫端之後改掉內容也不影響這一筆< 元素type , 長度 >
+template<typename T, size_t N>
+struct array
+{
+	array(const T (&a)[N])
+	{
+		for ( size_t i=0 ; i<N ; i++ ) data[i] = a[i];
+	}
+
+	T   data[N];
+};
+
+// storage裡存的參數type，加上const才能直接收呼叫端的const參考，陣列(字串)複製一整份
+template<typename T>            struct arg                { typedef const T type; };
+template<typename T, size_t N>  struct arg<T[N]>          { typedef const array<T,N> type; };
+template<typename T, size_t N>  struct arg<const T[N]>    { typedef const array<T,N> type; };
+
+// 交給fprintf之前，複製進來的陣列換回指向紀錄裡那一份的指標
+template<typename T>
+inline const T& value(const T &a) { return a; }
+
+template<typename T, size_t N>
+inline const T* value(const array<T,N> &a) { return a.data; }
+
+/// 每筆紀錄開頭的固定欄位，format是0代表佇列尾端用來補空的
+struct header
+{
+	void        (*format)(header*, FILE*);
+	size_t      size;
+};
+
+/// 把storage裡的參數交給fprintf
+struct printer
+{
+	printer(FILE *o, const char *f):out(o),fmt(f){}
+
+	inline void operator()() const
+	{
+		fprintf(out, fmt, 0);   // 多給一個用不到的參數，免得編譯器警告格式字串不是常數
+	}
+	template<typename A1>
+	inline void operator()(const A1 &a1) const
+	{
+		fprintf(out, fmt, value(a1));
+	}
+	template<typename A1, typename A2>
+	inline void operator()(const A1 &a1, const A2 &a2) const
+	{
+		fprintf(out, fmt, value(a1), value(a2));
+	}
+	template<typename A1, typename A2, typename A3>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3));
+	}
+	template<typename A1, typename A2, typename A3, typename A4>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4), value(a5));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4), value(a5), value(a6));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4), value(a5), value(a6), value(a7));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4), value(a5), value(a6), value(a7), value(a8));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline void operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9) const
+	{
+		fprintf(out, fmt, value(a1), value(a2), value(a3), value(a4), value(a5), value(a6), value(a7), value(a8), value(a9));
+	}
+
+	FILE        *out;
+	const char  *fmt;
+};
+
+/// 一筆紀錄< 儲存參數的storage >
+template<typename S>
+struct record : header
+{
+	record(const char *f, const S &s):fmt(f),args(s)
+	{
+		format = &record::run;
+		size   = bytes;
+	}
+
+	static void run(header *h, FILE *out)
+	{
+		record *r = static_cast<record*>(h);
+		printer p(out, r->fmt);
+		r->args.Do(type<void>(), p);
+		r->~record();
+	}
+
+	enum { bytes = ( sizeof(header) + sizeof(const char*) + sizeof(S) + align - 1 ) / align * align };
+
+	const char  *fmt;
+	S           args;
+};
+
+/// 一條執行緒專用的環狀佇列，單一生產者單一消費者
+class ring
+{
+	public:
+
+		explicit ring(size_t capacity)
+			:cap_((capacity + align - 1) / align * align)
+			,buf_(new char[cap_ + align])
+			,head_(0)
+			,tail_(0)
+			,cached_(0)
+			,pending_(0)
+		{
+			// 對齊到align，紀錄裡有double之類的東西
+			data_ = buf_ + ( align - reinterpret_cast<size_t>(buf_) % align ) % align;
+		}
+
+		~ring(){ delete [] buf_; }
+
+		/// 生產端：切出n個位元組，放不下回傳0
+		void* reserve(size_t n)
+		{
+			size_t t    = tail_.load(memory_order_relaxed);
+			size_t off  = t % cap_;
+			size_t need = n;
+
+			if ( off + n > cap_ ) need += cap_ - off;       // 尾端不夠就補空，從頭開始
+
+			if ( need > cap_ ) return 0;
+
+			if ( t + need - cached_ > cap_ )
+			{
+				cached_ = head_.load(memory_order_acquire);
+
+				if ( t + need - cached_ > cap_ ) return 0;
+			}
+
+			if ( need!=n )
+			{
+				header *pad = reinterpret_cast<header*>(data_ + off);
+				pad->format = 0;
+				pad->size   = cap_ - off;
+			}
+
+			pending_ = need;
+
+			return data_ + ( t + need - n ) % cap_;
+		}
+
+		/// 生產端：把reserve()到的紀錄交出去
+		inline void commit()
+		{
+			tail_.store(tail_.load(memory_order_relaxed) + pending_, memory_order_release);
+		}
+
+		/// 消費端：格式化並寫出所有已交出的紀錄，回傳寫了幾筆
+		size_t drain(FILE *out)
+		{
+			size_t h = head_.load(memory_order_relaxed);
+			size_t t = tail_.load(memory_order_acquire);
+			size_t n = 0;
+
+			while ( h!=t )
+			{
+				header *r = reinterpret_cast<header*>(data_ + h % cap_);
+				size_t size = r->size;
+
+				if ( r->format )
+				{
+					r->format(r, out);
+					n++;
+				}
+
+				h += size;
+				head_.store(h, memory_order_release);
+			}
+
+			return n;
+		}
+
+	private:
+
+		ring(const ring&);
+		ring& operator=(const ring&);
+
+		size_t          cap_;
+		char            *buf_;
+		char            *data_;
+		atomic<size_t>  head_;      // 消費端讀到哪裡，只會一直增加
+		char            pad_[64];   // 生產端與消費端各自的欄位不要擠在同一條cache line
+		atomic<size_t>  tail_;      // 生產端寫到哪裡
+		size_t          cached_;    // 生產端上次看到的head_
+		size_t          pending_;
+};
+
+/// 每條執行緒記住上次用的佇列，換了logger才去查表
+struct cache
+{
+	unsigned long   owner;
+	ring            *r;
+};
+
+inline cache& local()
+{
+	static __thread cache c = { 0, 0 };
+	return c;
+}
+
+inline unsigned long next_id()
+{
+	static atomic<unsigned long> id(0);
+	return id.fetch_add(1) + 1;
+}
+
+}//namespace _log
+
+
+/// 非同步日誌，格式化延到背景執行緒
+class async_logger
+{
+	public:
+
+		/// 每條執行緒的佇列有ring_bytes個位元組
+		explicit async_logger(FILE *out, size_t ring_bytes = 64*1024)
+			:out_(out),ring_bytes_(ring_bytes),id_(_log::next_id()),dropped_(0),stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			started_ = pthread_create(&thread_, 0, &async_logger::thread_main, this)==0;
+		}
+
+		~async_logger()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_mutex_unlock(&lock_);
+
+			if ( started_ ) pthread_join(thread_, 0);
+
+			for ( size_t i=0 ; i<rings_.size() ; i++ )
+			{
+				delete rings_[i].r;
+			}
+
+			pthread_mutex_destroy(&lock_);
+		}
+
+		/// 佇列滿了被丟掉的筆數
+		inline long dropped() const { return dropped_.load(); }
+
+		inline bool write(const char *fmt)
+		{
+			return push(fmt, storage0());
+		}
+		template<typename A1>
+		inline bool write(const char *fmt, const A1 &a1)
+		{
+			return push(fmt, storage1<typename _log::arg<A1>::type>(a1));
+		}
+		template<typename A1, typename A2>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2)
+		{
+			return push(fmt, storage2<typename _log::arg<A1>::type, typename _log::arg<A2>::type>(a1, a2));
+		}
+		template<typename A1, typename A2, typename A3>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3)
+		{
+			return push(fmt, storage3<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type>(a1, a2, a3));
+		}
+		template<typename A1, typename A2, typename A3, typename A4>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4)
+		{
+			return push(fmt, storage4<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type>(a1, a2, a3, a4));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5)
+		{
+			return push(fmt, storage5<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type, typename _log::arg<A5>::type>(a1, a2, a3, a4, a5));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6)
+		{
+			return push(fmt, storage6<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type, typename _log::arg<A5>::type, typename _log::arg<A6>::type>(a1, a2, a3, a4, a5, a6));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7)
+		{
+			return push(fmt, storage7<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type, typename _log::arg<A5>::type, typename _log::arg<A6>::type, typename _log::arg<A7>::type>(a1, a2, a3, a4, a5, a6, a7));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8)
+		{
+			return push(fmt, storage8<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type, typename _log::arg<A5>::type, typename _log::arg<A6>::type, typename _log::arg<A7>::type, typename _log::arg<A8>::type>(a1, a2, a3, a4, a5, a6, a7, a8));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+		inline bool write(const char *fmt, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9)
+		{
+			return push(fmt, storage9<typename _log::arg<A1>::type, typename _log::arg<A2>::type, typename _log::arg<A3>::type, typename _log::arg<A4>::type, typename _log::arg<A5>::type, typename _log::arg<A6>::type, typename _log::arg<A7>::type, typename _log::arg<A8>::type, typename _log::arg<A9>::type>(a1, a2, a3, a4, a5, a6, a7, a8, a9));
+		}
+
+	private:
+
+		async_logger(const async_logger&);          // 不允許複製
+		async_logger& operator=(const async_logger&);
+
+		struct entry
+		{
+			pthread_t   thread;
+			_log::ring  *r;
+		};
+
+		template<typename S>
+		bool push(const char *fmt, const S &s)
+		{
+			typedef _log::record<S> R;
+
+			if ( !started_ ) return write_now<R>(fmt, s);
+
+			_log::ring *r = local_ring();
+			void *p = r ? r->reserve(R::bytes) : 0;
+
+			if ( !p )
+			{
+				dropped_.fetch_add(1);
+				return false;
+			}
+
+			new (p) R(fmt, s);
+			r->commit();
+			return true;
+		}
+
+		// 沒有背景執行緒，紀錄建在堆疊上，上鎖之後直接寫出去
+		template<typename R, typename S>
+		bool write_now(const char *fmt, const S &s)
+		{
+			union
+			{
+				long double ld;
+				void        *p;
+				char        c[R::bytes];
+			} buf;
+
+			_log::header *h = new (buf.c) R(fmt, s);
+
+			pthread_mutex_lock(&lock_);
+			h->format(h, out_);     // 會順便解構紀錄
+			fflush(out_);
+			pthread_mutex_unlock(&lock_);
+			return true;
+		}
+
+		// 目前執行緒的佇列，第一次寫入時才建立
+		_log::ring* local_ring()
+		{
+			_log::cache &c = _log::local();
+
+			if ( c.owner==id_ ) return c.r;
+
+			pthread_t self = pthread_self();
+			_log::ring *r = 0;
+
+			pthread_mutex_lock(&lock_);
+
+			for ( size_t i=0 ; i<rings_.size() ; i++ )
+			{
+				if ( pthread_equal(rings_[i].thread, self) )
+				{
+					r = rings_[i].r;
+					break;
+				}
+			}
+
+			if ( !r )
+			{
+				entry e;
+				e.thread = self;
+				e.r      = new _log::ring(ring_bytes_);
+				rings_.push_back(e);
+				r = e.r;
+			}
+
+			pthread_mutex_unlock(&lock_);
+
+			c.owner = id_;
+			c.r     = r;
+			return r;
+		}
+
+		static void* thread_main(void *p)
+		{
+			static_cast<async_logger*>(p)->loop();
+			return 0;
+		}
+
+		void loop()
+		{
+			std::vector<_log::ring*> rings;
+
+			for (;;)
+			{
+				pthread_mutex_lock(&lock_);
+
+				bool stop = stop_;
+
+				// 佇列只會增加，補上新來的就好
+				for ( size_t i=rings.size() ; i<rings_.size() ; i++ )
+				{
+					rings.push_back(rings_[i].r);
+				}
+
+				pthread_mutex_unlock(&lock_);
+
+				size_t n = 0;
+
+				for ( size_t i=0 ; i<rings.size() ; i++ )
+				{
+					n += rings[i]->drain(out_);
+				}
+
+				if ( n ) fflush(out_);
+
+				if ( stop ) break;      // 看到stop之後又清過一輪了
+
+				// 沒東西就睡一下，日誌晚一毫秒寫出去沒有關係，不必讓寫入端去叫醒誰
+				if ( !n )
+				{
+					timespec t = { 0, 1000000 };
+					nanosleep(&t, 0);
+				}
+			}
+		}
+
+		FILE                    *out_;
+		size_t                  ring_bytes_;
+		unsigned long           id_;        // 讓執行緒的快取分辨是哪個logger
+		atomic<long>            dropped_;
+		pthread_mutex_t         lock_;
+		pthread_t               thread_;
+		bool                    started_;   // 背景執行緒有建起來，沒有的話write()直接寫出去
+		std::vector<entry>      rings_;
+		bool                    stop_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_ASYNC_LOGGER_HPP_
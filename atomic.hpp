@@ -0,0 +1,210 @@
+/**
+ * @file      atomic.hpp
+ * @brief     實作 std::atomic 的簡易版
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 只支援整數與指標這類能放進一個機器字組的type
+ * memory_order 參數可以照填，但實作一律採用完整的記憶體屏障
+ * GCC 相容的編譯器用 __sync 系列內建函式，Windows 則用 Interlocked 系列
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_ATOMIC_HPP_
+#define _STD_ATOMIC_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧
+#if __cplusplus > 201100L
+
+#include <atomic>
+
+// 強制使用本函式庫的時候，其他工具會在functional這個namespace裡找atomic
+#if defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+namespace functional{
+	using std::atomic; using std::memory_order; using std::atomic_thread_fence;
+	using std::memory_order_relaxed; using std::memory_order_consume; using std::memory_order_acquire;
+	using std::memory_order_release; using std::memory_order_acq_rel; using std::memory_order_seq_cst;
+}
+#endif
+
+#else
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+namespace std{
+
+enum memory_order
+{
+	memory_order_relaxed,
+	memory_order_consume,
+	memory_order_acquire,
+	memory_order_release,
+	memory_order_acq_rel,
+	memory_order_seq_cst
+};
+
+namespace _atomic{
+
+#if defined(_MSC_VER)
+
+// 依照type的大小挑選對應的Interlocked函式
+template<int N> struct ops{};
+
+template<> struct ops<4>
+{
+	template<typename T>
+	static inline T cas(volatile T *p, T expected, T desired)
+	{
+		return (T)InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)expected);
+	}
+};
+
+template<> struct ops<8>
+{
+	template<typename T>
+	static inline T cas(volatile T *p, T expected, T desired)
+	{
+		return (T)InterlockedCompareExchange64((volatile LONGLONG*)p, (LONGLONG)desired, (LONGLONG)expected);
+	}
+};
+
+// 比較p的內容是否為expected，是的話改成desired，並回傳原本的值
+template<typename T>
+inline T cas(volatile T *p, T expected, T desired)
+{
+	return ops<sizeof(T)>::cas(p, expected, desired);
+}
+
+template<typename T>
+inline T fetch_add(volatile T *p, T v)
+{
+	T old = *p;
+	T now;
+	while ( (now = cas(p, old, T(old + v))) != old ) old = now;
+	return old;
+}
+
+inline void fence() { MemoryBarrier(); }
+
+#else
+
+template<typename T>
+inline T cas(volatile T *p, T expected, T desired)
+{
+	return __sync_val_compare_and_swap(p, expected, desired);
+}
+
+template<typename T>
+inline T fetch_add(volatile T *p, T v)
+{
+	return __sync_fetch_and_add(p, v);
+}
+
+inline void fence() { __sync_synchronize(); }
+
+#endif
+
+}//namespace _atomic
+
+inline void atomic_thread_fence(memory_order) { _atomic::fence(); }
+
+/// 指標與整數共用的部份
+template<typename T>
+struct atomic_base
+{
+	atomic_base():v_(){}
+	atomic_base(T v):v_(v){}
+
+	inline T load(memory_order = memory_order_seq_cst) const
+	{
+		T v = v_;
+		_atomic::fence();
+		return v;
+	}
+
+	inline void store(T v, memory_order = memory_order_seq_cst)
+	{
+		_atomic::fence();
+		v_ = v;
+		_atomic::fence();
+	}
+
+	inline T exchange(T v, memory_order = memory_order_seq_cst)
+	{
+		T old = v_;
+		T now;
+		while ( (now = _atomic::cas(&v_, old, v)) != old ) old = now;
+		return old;
+	}
+
+	// 失敗時會把目前的值寫回expected
+	inline bool compare_exchange_strong(T &expected, T desired, memory_order = memory_order_seq_cst)
+	{
+		T old = _atomic::cas(&v_, expected, desired);
+
+		if ( old == expected )
+		{
+			return true;
+		}
+
+		expected = old;
+		return false;
+	}
+
+	inline bool compare_exchange_weak(T &expected, T desired, memory_order o = memory_order_seq_cst)
+	{
+		return compare_exchange_strong(expected, desired, o);
+	}
+
+	inline operator T () const { return load(); }
+
+	volatile T  v_;
+
+	private:
+
+		atomic_base(const atomic_base&);
+		atomic_base& operator=(const atomic_base&);
+};
+
+/// 整數版本，多了加減法
+template<typename T>
+struct atomic : atomic_base<T>
+{
+	typedef atomic_base<T> base;
+
+	atomic(){}
+	atomic(T v):base(v){}
+
+	inline T fetch_add(T v, memory_order = memory_order_seq_cst) { return _atomic::fetch_add(&this->v_, v); }
+	inline T fetch_sub(T v, memory_order = memory_order_seq_cst) { return _atomic::fetch_add(&this->v_, T(0-v)); }
+
+	inline T operator++ ()    { return fetch_add(1)+1; }
+	inline T operator-- ()    { return fetch_sub(1)-1; }
+	inline T operator++ (int) { return fetch_add(1); }
+	inline T operator-- (int) { return fetch_sub(1); }
+
+	inline T operator= (T v)  { this->store(v); return v; }
+};
+
+/// 指標版本，只支援讀寫與交換
+template<typename T>
+struct atomic<T*> : atomic_base<T*>
+{
+	typedef atomic_base<T*> base;
+
+	atomic(){}
+	atomic(T *v):base(v){}
+
+	inline T* operator= (T *v) { this->store(v); return v; }
+};
+
+}//namespace std
+
+
+#endif//__cplusplus > 201100L
+#endif//_STD_ATOMIC_HPP_
@@ -18,14 +18,27 @@
 #ifndef _STD_BIND_HPP_
 #define _STD_BIND_HPP_
 
-// 判斷編譯器是否為C++11，是就改用標準庫吧
-#if __cplusplus > 201100L
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
 
 #include <functional>
 
+// 讓使用者可以一律寫成functional::function，不必管現在用的是哪一套
+namespace functional = std;
+
 #else
 
-namespace std{
+// C++11以後仍然堅持使用本函式庫的話，改放進functional這個namespace以免跟標準庫撞名
+#if __cplusplus > 201100L
+#define _STD_FUNCTIONAL_CXX11
+#define _STD_FUNCTIONAL_NS functional
+#include <utility>
+#include <type_traits>
+#else
+#define _STD_FUNCTIONAL_NS std
+#endif
+
+namespace _STD_FUNCTIONAL_NS{
 
 
 // 將一個type裝成變數來傳遞，用處是藉變數將type傳達進去
@@ -61,6 +74,9 @@ template<typename T> inline T* get_pointer(T &o){ return &o; }
 // 不管對象是不是參考都化為原本type
 template<typename T> struct untie_ref{ typedef T type; };
 template<typename T> struct untie_ref<T&> : untie_ref<T>{};
+#ifdef _STD_FUNCTIONAL_CXX11
+template<typename T> struct untie_ref<T&&> : untie_ref<T>{};
+#endif
 
 // 不管對象是不是參考都化為原本type的參考
 template<typename T> struct param_traits
@@ -70,6 +86,128 @@ template<typename T> struct param_traits
 
 //------------------實現param_traits------------------end
 
+#ifdef _STD_FUNCTIONAL_CXX11
+struct storage_base_tag{};
+#endif
+
+namespace _bind{
+
+// storage把自己的成員交出去時使用，只有右值參考成員需要轉回右值，其餘照舊以左值交出去< 成員的type >
+template<typename A> struct forwarder
+{
+	template<typename U>
+	static inline U& get(U &u) { return u; }
+};
+
+#ifdef _STD_FUNCTIONAL_CXX11
+template<typename T> struct forwarder<T&&>
+{
+	template<typename U>
+	static inline T&& get(U &u) { return static_cast<T&&>(u); }
+};
+#endif
+
+
+//------------------把結果交給呼叫端準備的物件------------------start
+// 給eval_into()與function::invoke_into()使用
+// 回傳值先直接建構在暫存物件上，再把內容交出去，大型的回傳值就不必整個複製一次
+
+// 去掉const，out必須是可以寫入的物件
+template<typename T> struct untie_const{ typedef T type; };
+template<typename T> struct untie_const<const T>{ typedef T type; };
+
+// 判斷T有沒有"void swap(T&)"這個成員，vector、string、map之類的容器都有
+template<typename T>
+struct has_swap
+{
+	template<typename U, void (U::*)(U&)> struct sig{};
+	template<typename U> static char test(sig<U, &U::swap>*);
+	template<typename U> static long test(...);
+
+	enum{ value = sizeof(test<T>(0))==1 };
+};
+
+// 沒有swap()的type在C++98只能複製一次，跟out = f()一樣，這種type要改用function::construct_into()
+template<bool> struct give_by
+{
+	template<typename T, typename U>
+	static inline void Do(T &out, U &tmp) { out = tmp; }
+};
+
+template<> struct give_by<true>
+{
+	template<typename T>
+	static inline void Do(T &out, T &tmp) { out.swap(tmp); }
+};
+
+// R是一般的值，暫存物件用完就丟，內容可以直接拿走< 回傳值type >
+template<typename R> struct give
+{
+	template<typename T>
+	static inline void Do(T &out, R &tmp)
+	{
+	#ifdef _STD_FUNCTIONAL_CXX11
+		out = std::move(tmp);
+	#else
+		give_by<has_swap<R>::value>::Do(out, tmp);
+	#endif
+	}
+};
+
+// 回傳的是參考就只能複製，不能動到別人的物件
+template<typename R> struct give<R&>
+{
+	template<typename T>
+	static inline void Do(T &out, R &tmp) { out = tmp; }
+};
+
+//------------------把結果交給呼叫端準備的物件------------------end
+
+
+//------------------就地建構用的工具------------------start
+// function::emplace_bind()用來把參數直接建構進核心裡的bind_t，不必先做出一個bind_t再整個複製過去
+
+// 用來分辨"就地建構"與一般建構子的標籤
+struct emplace_tag{};
+
+#ifndef _STD_FUNCTIONAL_CXX11
+
+// 參數最後在storage裡的type，就跟bind()用傳值收參數的結果一樣
+template<typename T> struct decay{ typedef T type; };
+template<typename T, int N> struct decay<T[N]>{ typedef const T* type; };
+template<int I> struct decay<Argc<I>()>{ typedef Argc<I>(*type)(); };
+
+// 把收到的const參考轉成storage建構子要的參考，storage只會從它複製，不會修改內容
+// placeholder與陣列必須先轉成指標，所以那邊存的是值
+template<typename T> struct hold
+{
+	typedef T& type;
+	static inline T& get(const T &t) { return const_cast<T&>(t); }
+};
+template<typename T, int N> struct hold<T[N]>
+{
+	typedef const T* type;
+	static inline const T* get(const T *t) { return t; }
+};
+template<int I> struct hold<Argc<I>()>
+{
+	typedef Argc<I>(*type)();
+	static inline type get(type t) { return t; }
+};
+
+#endif//_STD_FUNCTIONAL_CXX11
+
+//------------------就地建構用的工具------------------end
+
+
+#ifdef _STD_FUNCTIONAL_CXX11
+// 只收一個參數的轉發建構子必須避開storage自己，否則會搶走複製建構子的工作
+template<typename U> struct if_not_storage
+	: std::enable_if<!std::is_base_of<storage_base_tag, typename std::decay<U>::type>::value>{};
+#endif
+
+}//namespace _bind
+
 
 //------------------實現result_traits------------------start
 
@@ -108,15 +246,15 @@ inline reference_wrapper<T const> cref(const T &t)
 */
 namespace placeholders{
 
-static inline Argc<1> _1() { return std::Argc<1>(); }
-static inline Argc<2> _2() { return std::Argc<2>(); }
-static inline Argc<3> _3() { return std::Argc<3>(); }
-static inline Argc<4> _4() { return std::Argc<4>(); }
-static inline Argc<5> _5() { return std::Argc<5>(); }
-static inline Argc<6> _6() { return std::Argc<6>(); }
-static inline Argc<7> _7() { return std::Argc<7>(); }
-static inline Argc<8> _8() { return std::Argc<8>(); }
-static inline Argc<9> _9() { return std::Argc<9>(); }
+static inline Argc<1> _1() { return Argc<1>(); }
+static inline Argc<2> _2() { return Argc<2>(); }
+static inline Argc<3> _3() { return Argc<3>(); }
+static inline Argc<4> _4() { return Argc<4>(); }
+static inline Argc<5> _5() { return Argc<5>(); }
+static inline Argc<6> _6() { return Argc<6>(); }
+static inline Argc<7> _7() { return Argc<7>(); }
+static inline Argc<8> _8() { return Argc<8>(); }
+static inline Argc<9> _9() { return Argc<9>(); }
 
 }
 
@@ -126,6 +264,9 @@ static inline Argc<9> _9() { return std::Argc<9>(); }
 
 // 所有storage系列的最底層基底類別
 struct storage_base
+#ifdef _STD_FUNCTIONAL_CXX11
+	: storage_base_tag
+#endif
 {
 	// T並非"Argc<1>(*)()"才會執行本method將這參數傳回
 	// 另一個版本負責接收"Argc<1>(*)()"然後傳回自己攜帶的參數
@@ -191,19 +332,24 @@ struct storage1 : storage1_base<storage1<A1> >
 	typedef typename param_traits<A1>::type P1;
 	typedef typename result_traits<A1>::type result_type;
 
-	storage1(P1 p1) : a1_(p1){}     // 將綁定的參數儲存起來
+	storage1(P1 p1) : a1_(_bind::forwarder<A1>::get(p1)){}     // 將綁定的參數儲存起來
+#ifdef _STD_FUNCTIONAL_CXX11
+	// 右值可以直接搬進來，不必再複製一次
+	template<typename U1, typename = typename _bind::if_not_storage<U1>::type>
+	storage1(U1 &&u1) : a1_(std::forward<U1>(u1)){}
+#endif
 
 	// 丟進[]的外部參數若非"Argc<1>(*)()"類型則直接回傳外部參數，自己帶的成員參數"a1_"則沒有用到
 	using base::operator[];
 
 	// 丟進[]的外部參數若是Argc這型的函式指標時，會回傳本物件自己帶的成員參數"a1_"
-	inline result_type operator[](Argc<1>(*)()) const { return a1_; }
+	inline result_type operator[](Argc<1>(*)()) const { return _bind::forwarder<A1>::get(a1_); }
 
 	// 得到外部輸入的函式位址並呼叫函式
 	template<typename R, typename F>
 	inline R Do(type<R>, F &f) const
 	{
-		return f(a1_);
+		return f(_bind::forwarder<A1>::get(a1_));
 	}
 
 	A1 a1_;     // 此物件儲存的參數
@@ -216,8 +362,14 @@ struct storage1<Argc<I>(*)()> : storage1_base<storage1<Argc<I>(*)()> >
 	typedef typename param_traits<Argc<I>(*)()>::type P1;
 
 	storage1(P1){}          // 建構子允許丟參數進來，但是根本不會去用，因為那只是個placeholder
-
-	Argc<I> (*a1_)(void);   // 這指標不需要指向何處，重點在於type，Argc<I>的"I"會讓編譯器去找到相呼應的operator[]
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename = typename _bind::if_not_storage<U1>::type>
+	storage1(U1 &&){}
+#endif
+
+	// 不佔空間的placeholder，重點只在於type，Argc<I>的"I"會讓編譯器去找到相呼應的operator[]
+	// 用靜態函式而不是指標成員，整個storage才會是空的，當作基底類別時就能被編譯器壓掉
+	static inline Argc<I> a1_(void) { return Argc<I>(); }
 };
 //-----------------------------一個參數的storage-----------------------------end
 
@@ -229,6 +381,10 @@ struct storage2_base : storage1<A1>
 	using base::operator[];
 
 	storage2_base(typename base::P1 p1) : base(p1){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename = typename _bind::if_not_storage<U1>::type>
+	storage2_base(U1 &&u1) : base(std::forward<U1>(u1)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -244,13 +400,17 @@ struct storage2 : storage2_base<storage2<A1, A2>, A1>
 	typedef typename param_traits<A2>::type P2;
 	typedef typename result_traits<A2>::type result_type;
 
-	storage2(typename base::P1 p1, P2 p2) : base(p1), a2_(p2) {}
+	storage2(typename base::P1 p1, P2 p2) : base(p1), a2_(_bind::forwarder<A2>::get(p2)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2>
+	storage2(U1 &&u1, U2 &&u2) : base(std::forward<U1>(u1)), a2_(std::forward<U2>(u2)) {}
+#endif
 
 	using base::operator[];
-	inline result_type operator[](Argc<2> (*)()) const { return a2_; }
+	inline result_type operator[](Argc<2>(*)()) const { return _bind::forwarder<A2>::get(a2_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,a2_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(a2_));}
 
 	A2 a2_;
 };
@@ -261,8 +421,12 @@ struct storage2<A1, Argc<I>(*)()> : storage2_base<storage2<A1, Argc<I>(*)()>, A1
 	typedef typename param_traits<Argc<I>(*)()>::type P2;
 
 	storage2(typename base::P1 p1, P2) : base(p1){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2>
+	storage2(U1 &&u1, U2 &&) : base(std::forward<U1>(u1)) {}
+#endif
 
-	Argc<I> (*a2_)(void);
+	static inline Argc<I> a2_(void) { return Argc<I>(); }
 };
 //-----------------------------兩個參數的storage-----------------------------end
 
@@ -274,6 +438,10 @@ struct storage3_base : storage2<A1, A2>
 	using base::operator[];
 
 	storage3_base(typename base::P1 p1, typename base::P2 p2) : base(p1, p2) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2>
+	storage3_base(U1 &&u1, U2 &&u2) : base(std::forward<U1>(u1), std::forward<U2>(u2)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -289,13 +457,17 @@ struct storage3 : storage3_base<storage3<A1, A2, A3>, A1, A2>
 	typedef typename param_traits<A3>::type P3;
 	typedef typename result_traits<A3>::type result_type;
 
-	storage3(typename base::P1 p1, typename base::P2 p2, P3 p3) : base(p1, p2), a3_(p3) {}
+	storage3(typename base::P1 p1, typename base::P2 p2, P3 p3) : base(p1, p2), a3_(_bind::forwarder<A3>::get(p3)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3>
+	storage3(U1 &&u1, U2 &&u2, U3 &&u3) : base(std::forward<U1>(u1), std::forward<U2>(u2)), a3_(std::forward<U3>(u3)) {}
+#endif
 
 	using base::operator[];
-	inline result_type operator[](Argc<3> (*)()) const { return a3_; }
+	inline result_type operator[](Argc<3>(*)()) const { return _bind::forwarder<A3>::get(a3_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,a3_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(a3_));}
 
 	A3 a3_;
 };
@@ -306,7 +478,11 @@ struct storage3<A1, A2, Argc<I>(*)()> : storage3_base<storage3<A1, A2, Argc<I>(*
 	typedef typename param_traits<Argc<I>(*)()>::type P3;
 
 	storage3(typename base::P1 p1, typename base::P2 p2, P3) : base(p1, p2) {}
-	Argc<I> (*a3_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3>
+	storage3(U1 &&u1, U2 &&u2, U3 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2)) {}
+#endif
+	static inline Argc<I> a3_(void) { return Argc<I>(); }
 };
 //-----------------------------三個參數的storage-----------------------------end
 
@@ -318,6 +494,10 @@ struct storage4_base : storage3<A1, A2, A3>
 	using base::operator[];
 
 	storage4_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3) : base(p1, p2, p3){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3>
+	storage4_base(U1 &&u1, U2 &&u2, U3 &&u3) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -335,12 +515,16 @@ struct storage4 : storage4_base<storage4<A1, A2, A3, A4>, A1, A2, A3>
 
 	using base::operator[];
 
-	storage4(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, P4 p4) : base(p1, p2, p3), a4_(p4) {}
+	storage4(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, P4 p4) : base(p1, p2, p3), a4_(_bind::forwarder<A4>::get(p4)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4>
+	storage4(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3)), a4_(std::forward<U4>(u4)) {}
+#endif
 
-	inline result_type operator[](Argc<4>(*)()) const { return a4_; }
+	inline result_type operator[](Argc<4>(*)()) const { return _bind::forwarder<A4>::get(a4_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,a4_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(a4_));}
 
 	A4 a4_;
 };
@@ -351,7 +535,11 @@ struct storage4<A1, A2, A3, Argc<I>(*)()> : storage4_base<storage4<A1, A2, A3, A
 	typedef typename param_traits<Argc<I>(*)()>::type P4;
 
 	storage4(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, P4) : base(p1, p2, p3) {}
-	Argc<I> (*a4_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4>
+	storage4(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3)) {}
+#endif
+	static inline Argc<I> a4_(void) { return Argc<I>(); }
 };
 //-----------------------------四個參數的storage-----------------------------end
 
@@ -363,6 +551,10 @@ struct storage5_base : storage4<A1, A2, A3, A4>
 	using base::operator[];
 
 	storage5_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4) : base(p1, p2, p3, p4){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4>
+	storage5_base(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -380,12 +572,16 @@ struct storage5 : storage5_base<storage5<A1, A2, A3, A4, A5>, A1, A2, A3, A4>
 
 	using base::operator[];
 
-	storage5(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, P5 p5) : base(p1, p2, p3, p4), a5_(p5) {}
+	storage5(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, P5 p5) : base(p1, p2, p3, p4), a5_(_bind::forwarder<A5>::get(p5)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5>
+	storage5(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4)), a5_(std::forward<U5>(u5)) {}
+#endif
 
-	inline result_type operator[](Argc<5>(*)()) const { return a5_; }
+	inline result_type operator[](Argc<5>(*)()) const { return _bind::forwarder<A5>::get(a5_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,this->a4_,a5_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(this->a4_), _bind::forwarder<A5>::get(a5_));}
 
 	A5 a5_;
 };
@@ -396,7 +592,11 @@ struct storage5<A1, A2, A3, A4, Argc<I>(*)()> : storage5_base<storage5<A1, A2, A
 	typedef typename param_traits<Argc<I>(*)()>::type P5;
 
 	storage5(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, P5) : base(p1, p2, p3, p4) {}
-	Argc<I> (*a5_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5>
+	storage5(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4)) {}
+#endif
+	static inline Argc<I> a5_(void) { return Argc<I>(); }
 };
 //-----------------------------五個參數的storage-----------------------------end
 
@@ -408,6 +608,10 @@ struct storage6_base : storage5<A1, A2, A3, A4, A5>
 	using base::operator[];
 
 	storage6_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5) : base(p1, p2, p3, p4, p5){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5>
+	storage6_base(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -425,12 +629,16 @@ struct storage6 : storage6_base<storage6<A1, A2, A3, A4, A5, A6>, A1, A2, A3, A4
 
 	using base::operator[];
 
-	storage6(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, P6 p6) : base(p1, p2, p3, p4, p5), a6_(p6) {}
+	storage6(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, P6 p6) : base(p1, p2, p3, p4, p5), a6_(_bind::forwarder<A6>::get(p6)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6>
+	storage6(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5)), a6_(std::forward<U6>(u6)) {}
+#endif
 
-	inline result_type operator[](Argc<6>(*)()) const { return a6_; }
+	inline result_type operator[](Argc<6>(*)()) const { return _bind::forwarder<A6>::get(a6_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,this->a4_,this->a5_,a6_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(this->a4_), _bind::forwarder<A5>::get(this->a5_), _bind::forwarder<A6>::get(a6_));}
 
 	A6 a6_;
 };
@@ -441,7 +649,11 @@ struct storage6<A1, A2, A3, A4, A5, Argc<I>(*)()> : storage6_base<storage6<A1, A
 	typedef typename param_traits<Argc<I>(*)()>::type P6;
 
 	storage6(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, P6) : base(p1, p2, p3, p4, p5) {}
-	Argc<I> (*a6_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6>
+	storage6(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5)) {}
+#endif
+	static inline Argc<I> a6_(void) { return Argc<I>(); }
 };
 //-----------------------------六個參數的storage-----------------------------end
 
@@ -453,6 +665,10 @@ struct storage7_base : storage6<A1, A2, A3, A4, A5, A6>
 	using base::operator[];
 
 	storage7_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6) : base(p1, p2, p3, p4, p5, p6){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6>
+	storage7_base(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -470,12 +686,16 @@ struct storage7 : storage7_base<storage7<A1, A2, A3, A4, A5, A6, A7>, A1, A2, A3
 
 	using base::operator[];
 
-	storage7(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, P7 p7) : base(p1, p2, p3, p4, p5, p6), a7_(p7) {}
+	storage7(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, P7 p7) : base(p1, p2, p3, p4, p5, p6), a7_(_bind::forwarder<A7>::get(p7)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7>
+	storage7(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6)), a7_(std::forward<U7>(u7)) {}
+#endif
 
-	inline result_type operator[](Argc<7>(*)()) const { return a7_; }
+	inline result_type operator[](Argc<7>(*)()) const { return _bind::forwarder<A7>::get(a7_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,this->a4_,this->a5_,this->a6_,a7_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(this->a4_), _bind::forwarder<A5>::get(this->a5_), _bind::forwarder<A6>::get(this->a6_), _bind::forwarder<A7>::get(a7_));}
 
 	A7 a7_;
 };
@@ -486,7 +706,11 @@ struct storage7<A1, A2, A3, A4, A5, A6, Argc<I>(*)()> : storage7_base<storage7<A
 	typedef typename param_traits<Argc<I>(*)()>::type P7;
 
 	storage7(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, P7) : base(p1, p2, p3, p4, p5, p6) {}
-	Argc<I> (*a7_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7>
+	storage7(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6)) {}
+#endif
+	static inline Argc<I> a7_(void) { return Argc<I>(); }
 };
 //-----------------------------七個參數的storage-----------------------------end
 
@@ -498,6 +722,10 @@ struct storage8_base : storage7<A1, A2, A3, A4, A5, A6, A7>
 	using base::operator[];
 
 	storage8_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7) : base(p1, p2, p3, p4, p5, p6, p7){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7>
+	storage8_base(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -515,12 +743,16 @@ struct storage8 : storage8_base<storage8<A1, A2, A3, A4, A5, A6, A7, A8>, A1, A2
 
 	using base::operator[];
 
-	storage8(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, P8 p8) : base(p1, p2, p3, p4, p5, p6, p7), a8_(p8) {}
+	storage8(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, P8 p8) : base(p1, p2, p3, p4, p5, p6, p7), a8_(_bind::forwarder<A8>::get(p8)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7, typename U8>
+	storage8(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7, U8 &&u8) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7)), a8_(std::forward<U8>(u8)) {}
+#endif
 
-	inline result_type operator[](Argc<8>(*)()) const { return a8_; }
+	inline result_type operator[](Argc<8>(*)()) const { return _bind::forwarder<A8>::get(a8_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,this->a4_,this->a5_,this->a6_,this->a7_,a8_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(this->a4_), _bind::forwarder<A5>::get(this->a5_), _bind::forwarder<A6>::get(this->a6_), _bind::forwarder<A7>::get(this->a7_), _bind::forwarder<A8>::get(a8_));}
 
 	A8 a8_;
 };
@@ -531,7 +763,11 @@ struct storage8<A1, A2, A3, A4, A5, A6, A7, Argc<I>(*)()> : storage8_base<storag
 	typedef typename param_traits<Argc<I>(*)()>::type P8;
 
 	storage8(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, P8) : base(p1, p2, p3, p4, p5, p6, p7) {}
-	Argc<I> (*a8_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7, typename U8>
+	storage8(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7, U8 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7)) {}
+#endif
+	static inline Argc<I> a8_(void) { return Argc<I>(); }
 };
 //-----------------------------八個參數的storage-----------------------------end
 
@@ -543,6 +779,10 @@ struct storage9_base : storage8<A1, A2, A3, A4, A5, A6, A7, A8>
 	using base::operator[];
 
 	storage9_base(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, typename base::P8 p8) : base(p1, p2, p3, p4, p5, p6, p7, p8){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7, typename U8>
+	storage9_base(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7, U8 &&u8) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7), std::forward<U8>(u8)){}
+#endif
 
 	template<typename R, typename F, typename S>
 	inline R operator()(type<R>, F &f, const S &s) const
@@ -560,12 +800,16 @@ struct storage9 : storage9_base<storage9<A1, A2, A3, A4, A5, A6, A7, A8, A9>, A1
 
 	using base::operator[];
 
-	storage9(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, typename base::P8 p8, P9 p9) : base(p1, p2, p3, p4, p5, p6, p7, p8), a9_(p9) {}
+	storage9(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, typename base::P8 p8, P9 p9) : base(p1, p2, p3, p4, p5, p6, p7, p8), a9_(_bind::forwarder<A9>::get(p9)) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7, typename U8, typename U9>
+	storage9(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7, U8 &&u8, U9 &&u9) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7), std::forward<U8>(u8)), a9_(std::forward<U9>(u9)) {}
+#endif
 
-	inline result_type operator[](Argc<9>(*)()) const { return a9_; }
+	inline result_type operator[](Argc<9>(*)()) const { return _bind::forwarder<A9>::get(a9_); }
 
 	template<typename R, typename F>
-	inline R Do(type<R>, F &f) const {return f(this->a1_,this->a2_,this->a3_,this->a4_,this->a5_,this->a6_,this->a7_,this->a8_,a9_);}
+	inline R Do(type<R>, F &f) const {return f(_bind::forwarder<A1>::get(this->a1_), _bind::forwarder<A2>::get(this->a2_), _bind::forwarder<A3>::get(this->a3_), _bind::forwarder<A4>::get(this->a4_), _bind::forwarder<A5>::get(this->a5_), _bind::forwarder<A6>::get(this->a6_), _bind::forwarder<A7>::get(this->a7_), _bind::forwarder<A8>::get(this->a8_), _bind::forwarder<A9>::get(a9_));}
 
 	A9 a9_;
 };
@@ -576,7 +820,11 @@ struct storage9<A1, A2, A3, A4, A5, A6, A7, A8, Argc<I>(*)()> : storage9_base<st
 	typedef typename param_traits<Argc<I>(*)()>::type P9;
 
 	storage9(typename base::P1 p1, typename base::P2 p2, typename base::P3 p3, typename base::P4 p4, typename base::P5 p5, typename base::P6 p6, typename base::P7 p7, typename base::P8 p8, P9) : base(p1, p2, p3, p4, p5, p6, p7, p8) {}
-	Argc<I> (*a9_)(void);
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename U1, typename U2, typename U3, typename U4, typename U5, typename U6, typename U7, typename U8, typename U9>
+	storage9(U1 &&u1, U2 &&u2, U3 &&u3, U4 &&u4, U5 &&u5, U6 &&u6, U7 &&u7, U8 &&u8, U9 &&) : base(std::forward<U1>(u1), std::forward<U2>(u2), std::forward<U3>(u3), std::forward<U4>(u4), std::forward<U5>(u5), std::forward<U6>(u6), std::forward<U7>(u7), std::forward<U8>(u8)) {}
+#endif
+	static inline Argc<I> a9_(void) { return Argc<I>(); }
 };
 //-----------------------------九個參數的storage-----------------------------end
 
@@ -783,10 +1031,81 @@ struct f_8 : f_b<R, F>
 	}
 };
 
+#ifdef _STD_FUNCTIONAL_CXX11
+
+// 依照成員函式的參數個數挑選對應的f_*()< 參數個數 , 函式回傳值 , 類別type , 成員函式的原型 >
+template<int N, typename R, typename C, typename F> struct member_of;
+template<typename R, typename C, typename F> struct member_of<0,R,C,F> { typedef f_0<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<1,R,C,F> { typedef f_1<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<2,R,C,F> { typedef f_2<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<3,R,C,F> { typedef f_3<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<4,R,C,F> { typedef f_4<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<5,R,C,F> { typedef f_5<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<6,R,C,F> { typedef f_6<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<7,R,C,F> { typedef f_7<R,C,F> type; };
+template<typename R, typename C, typename F> struct member_of<8,R,C,F> { typedef f_8<R,C,F> type; };
+
+#endif//_STD_FUNCTIONAL_CXX11
+
 //-------------------------------------_bind::f_*()系列-------------------------------------end
 
+// bind_t用來同時存放函式與storage< 函式type , storage type >
+// 把storage當成基底類別，全部都是placeholder的時候storage是空的，就不會佔任何空間
+template<typename F, typename S>
+struct packed : S
+{
+	packed(const F &f, const S &s) : S(s), f_(f) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+	packed(const F &f, S &&s) : S(std::move(s)), f_(f) {}
+
+	// 把參數直接交給storage的建構子
+	template<typename... A>
+	packed(emplace_tag, const F &f, A&&... a) : S(std::forward<A>(a)...), f_(f) {}
+#else
+	// 把參數直接交給storage的建構子
+	packed(emplace_tag, const F &f) : f_(f) {}
+	template<typename A1>
+	packed(emplace_tag, const F &f, A1 &a1) : S(a1), f_(f) {}
+	template<typename A1, typename A2>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2) : S(a1, a2), f_(f) {}
+	template<typename A1, typename A2, typename A3>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3) : S(a1, a2, a3), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4) : S(a1, a2, a3, a4), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5) : S(a1, a2, a3, a4, a5), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6) : S(a1, a2, a3, a4, a5, a6), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7) : S(a1, a2, a3, a4, a5, a6, a7), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8) : S(a1, a2, a3, a4, a5, a6, a7, a8), f_(f) {}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	packed(emplace_tag, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8, A9 &a9) : S(a1, a2, a3, a4, a5, a6, a7, a8, a9), f_(f) {}
+#endif
+
+	F f_;
+};
+
 }//namespace _bind
 
+#ifdef _STD_FUNCTIONAL_CXX11
+
+/// 依照參數個數挑選對應的storage
+template<typename... A> struct storage_of;
+template<> struct storage_of<> { typedef storage0 type; };
+template<typename A1> struct storage_of<A1> { typedef storage1<A1> type; };
+template<typename A1, typename A2> struct storage_of<A1, A2> { typedef storage2<A1, A2> type; };
+template<typename A1, typename A2, typename A3> struct storage_of<A1, A2, A3> { typedef storage3<A1, A2, A3> type; };
+template<typename A1, typename A2, typename A3, typename A4> struct storage_of<A1, A2, A3, A4> { typedef storage4<A1, A2, A3, A4> type; };
+template<typename A1, typename A2, typename A3, typename A4, typename A5> struct storage_of<A1, A2, A3, A4, A5> { typedef storage5<A1, A2, A3, A4, A5> type; };
+template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6> struct storage_of<A1, A2, A3, A4, A5, A6> { typedef storage6<A1, A2, A3, A4, A5, A6> type; };
+template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7> struct storage_of<A1, A2, A3, A4, A5, A6, A7> { typedef storage7<A1, A2, A3, A4, A5, A6, A7> type; };
+template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8> struct storage_of<A1, A2, A3, A4, A5, A6, A7, A8> { typedef storage8<A1, A2, A3, A4, A5, A6, A7, A8> type; };
+template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9> struct storage_of<A1, A2, A3, A4, A5, A6, A7, A8, A9> { typedef storage9<A1, A2, A3, A4, A5, A6, A7, A8, A9> type; };
+
+#endif//_STD_FUNCTIONAL_CXX11
+
 /// 這個是bind()的回傳值
 template<typename R, typename F, typename S> struct bind_t
 {
@@ -795,7 +1114,35 @@ template<typename R, typename F, typename S> struct bind_t
 		// result_traits對R做了解析並確保能得到真正的回傳值型態
 		typedef typename result_traits<R>::type result_type;
 
-		bind_t(const F &f, const S &s) : f_(f), s_(s) {}
+		bind_t(const F &f, const S &s) : s_(f, s) {}
+#ifdef _STD_FUNCTIONAL_CXX11
+		bind_t(const F &f, S &&s) : s_(f, std::move(s)) {}
+
+		// 不經過暫時的storage，直接用參數建構自己的storage
+		template<typename... A>
+		bind_t(_bind::emplace_tag t, const F &f, A&&... a) : s_(t, f, std::forward<A>(a)...) {}
+#else
+		// 不經過暫時的storage，直接用參數建構自己的storage
+		bind_t(_bind::emplace_tag t, const F &f) : s_(t, f) {}
+		template<typename A1>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1) : s_(t, f, a1) {}
+		template<typename A1, typename A2>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2) : s_(t, f, a1, a2) {}
+		template<typename A1, typename A2, typename A3>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3) : s_(t, f, a1, a2, a3) {}
+		template<typename A1, typename A2, typename A3, typename A4>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4) : s_(t, f, a1, a2, a3, a4) {}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5) : s_(t, f, a1, a2, a3, a4, a5) {}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6) : s_(t, f, a1, a2, a3, a4, a5, a6) {}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7) : s_(t, f, a1, a2, a3, a4, a5, a6, a7) {}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8) : s_(t, f, a1, a2, a3, a4, a5, a6, a7, a8) {}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+		bind_t(_bind::emplace_tag t, const F &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8, A9 &a9) : s_(t, f, a1, a2, a3, a4, a5, a6, a7, a8, a9) {}
+#endif
 
 
 		//----------------------eval----------------------start
@@ -806,27 +1153,63 @@ template<typename R, typename F, typename S> struct bind_t
 		template<typename A>
 		inline result_type eval(A &a)
 		{
-			return s_(type<result_type>(), f_, a);
+			return s_(type<result_type>(), s_.f_, a);
 		}
 		template<typename A>
 		inline result_type eval(A &a) const
 		{
-			return s_(type<result_type>(), f_, a);
+			return s_(type<result_type>(), s_.f_, a);
+		}
+
+		// 跟eval一樣，只是結果寫進呼叫端準備好的out，適合回傳大型物件的函式
+		template<typename O, typename A>
+		inline void eval_into(O &out, A &a)
+		{
+			result_type tmp(s_(type<result_type>(), s_.f_, a));
+			_bind::give<result_type>::Do(out, tmp);
+		}
+		template<typename O, typename A>
+		inline void eval_into(O &out, A &a) const
+		{
+			result_type tmp(s_(type<result_type>(), s_.f_, a));
+			_bind::give<result_type>::Do(out, tmp);
 		}
 
 		//----------------------eval----------------------end
 
+#ifdef _STD_FUNCTIONAL_CXX11
+
+		//-------------------C++11可以一次處理任意個參數-------------------start
+		// 參數以參考形式放進storage，右值會一路保持右值直到目標函式
+
+		template<typename... P>
+		inline result_type operator()(P&&... p)
+		{
+			typedef typename storage_of<P&&...>::type ll;
+			return s_(type<result_type>(), s_.f_, ll(p...));
+		}
+		template<typename... P>
+		inline result_type operator()(P&&... p) const
+		{
+			typedef typename storage_of<P&&...>::type ll;
+			return s_(type<result_type>(), s_.f_, ll(p...));
+		}
+
+		//-------------------C++11可以一次處理任意個參數-------------------end
+
+#else
+
 		//-------------------輸入零個參數時的情況-------------------start
 
 		inline result_type operator()()
 		{
 			typedef storage0 ll;
-			return s_(type<result_type>(), f_, ll());
+			return s_(type<result_type>(), s_.f_, ll());
 		}
 		inline result_type operator()() const
 		{
 			typedef storage0 ll;
-			return s_(type<result_type>(), f_, ll());
+			return s_(type<result_type>(), s_.f_, ll());
 		}
 		//-------------------輸入零個參數時的情況-------------------end
 
@@ -837,25 +1220,25 @@ template<typename R, typename F, typename S> struct bind_t
 		inline result_type operator()(P1 &p1)
 		{
 			typedef storage1<P1&> ll;
-			return l_(type<result_type>(), f_, ll(p1));
+			return s_(type<result_type>(), s_.f_, ll(p1));
 		}
 		template<typename P1>
 		inline result_type operator()(P1 &p1) const
 		{
 			typedef storage1<P1&> ll;
-			return l_(type<result_type>(), f_, ll(p1));
+			return s_(type<result_type>(), s_.f_, ll(p1));
 		}
 		template<typename P1>
 		inline result_type operator()(const P1 &p1)
 		{
 			typedef storage1<const P1&> ll;
-			return l_(type<result_type>(), f_, ll(p1));
+			return s_(type<result_type>(), s_.f_, ll(p1));
 		}
 		template<typename P1>
 		inline result_type operator()(const P1 &p1) const//--------這個足以應付大多數情況了
 		{
 			typedef storage1<const P1&> ll;
-			return l_(type<result_type>(), f_, ll(p1));
+			return s_(type<result_type>(), s_.f_, ll(p1));
 		}
 		//-------------------輸入一個參數時的情況-------------------end
 
@@ -866,64 +1249,329 @@ template<typename R, typename F, typename S> struct bind_t
 		inline result_type operator()(const P1 &p1, const P2 &p2) const
 		{
 			typedef storage2<const P1&, const P2&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2));
 		}
 		// 輸入三個參數時
 		template<typename P1, typename P2, typename P3>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3) const
 		{
 			typedef storage3<const P1&, const P2&, const P3&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3));
 		}
 		// 輸入四個參數時
 		template<typename P1, typename P2, typename P3, typename P4>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4) const
 		{
 			typedef storage4<const P1&, const P2&, const P3&, const P4&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4));
 		}
 		// 輸入五個參數時
 		template<typename P1, typename P2, typename P3, typename P4, typename P5>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4, const P5 &p5) const
 		{
 			typedef storage5<const P1&, const P2&, const P3&, const P4&, const P5&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4, p5));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4, p5));
 		}
 		// 輸入六個參數時
 		template<typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4, const P5 &p5, const P6 &p6) const
 		{
 			typedef storage6<const P1&, const P2&, const P3&, const P4&, const P5&, const P6&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4, p5, p6));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4, p5, p6));
 		}
 		// 輸入七個參數時
 		template<typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4, const P5 &p5, const P6 &p6, const P7 &p7) const
 		{
 			typedef storage7<const P1&, const P2&, const P3&, const P4&, const P5&, const P6&, const P7&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4, p5, p6, p7));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4, p5, p6, p7));
 		}
 		// 輸入八個參數時
 		template<typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4, const P5 &p5, const P6 &p6, const P7 &p7, const P8 &p8) const
 		{
 			typedef storage8<const P1&, const P2&, const P3&, const P4&, const P5&, const P6&, const P7&, const P8&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4, p5, p6, p7, p8));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4, p5, p6, p7, p8));
 		}
 		// 輸入九個參數時
 		template<typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
 		inline result_type operator()(const P1 &p1, const P2 &p2, const P3 &p3, const P4 &p4, const P5 &p5, const P6 &p6, const P7 &p7, const P8 &p8, const P9 &p9) const
 		{
 			typedef storage9<const P1&, const P2&, const P3&, const P4&, const P5&, const P6&, const P7&, const P8&, const P9&> ll;
-			return s_(type<result_type>(), f_, ll(p1, p2, p3, p4, p5, p6, p7, p8, p9));
+			return s_(type<result_type>(), s_.f_, ll(p1, p2, p3, p4, p5, p6, p7, p8, p9));
 		}
 
+#endif//_STD_FUNCTIONAL_CXX11
+
 	private:
 
-		F f_;
-		S s_;
+		_bind::packed<F,S> s_;  // 函式本身放在s_.f_
+};
+
+namespace _bind{
+
+/// 依照函式type算出bind()會傳回的bind_t< 函式type , storage type >
+/// wrap()把函式轉成bind_t實際存放的東西，成員函式會包成f_*()
+template<typename F, typename S> struct bind_type;
+
+// 一般函式
+template<typename R, typename S> struct bind_type<R (*)(), S>
+{
+	typedef R (*F)();
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename S> struct bind_type<R (*)(P1), S>
+{
+	typedef R (*F)(P1);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename S> struct bind_type<R (*)(P1, P2), S>
+{
+	typedef R (*F)(P1, P2);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename S> struct bind_type<R (*)(P1, P2, P3), S>
+{
+	typedef R (*F)(P1, P2, P3);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename S> struct bind_type<R (*)(P1, P2, P3, P4), S>
+{
+	typedef R (*F)(P1, P2, P3, P4);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename S> struct bind_type<R (*)(P1, P2, P3, P4, P5), S>
+{
+	typedef R (*F)(P1, P2, P3, P4, P5);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename S> struct bind_type<R (*)(P1, P2, P3, P4, P5, P6), S>
+{
+	typedef R (*F)(P1, P2, P3, P4, P5, P6);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename S> struct bind_type<R (*)(P1, P2, P3, P4, P5, P6, P7), S>
+{
+	typedef R (*F)(P1, P2, P3, P4, P5, P6, P7);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename S> struct bind_type<R (*)(P1, P2, P3, P4, P5, P6, P7, P8), S>
+{
+	typedef R (*F)(P1, P2, P3, P4, P5, P6, P7, P8);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename S> struct bind_type<R (*)(P1, P2, P3, P4, P5, P6, P7, P8, P9), S>
+{
+	typedef R (*F)(P1, P2, P3, P4, P5, P6, P7, P8, P9);
+	typedef bind_t<R, F, S> type;
+	static inline F wrap(F f) { return f; }
+};
+
+// 成員函式
+template<typename R, typename C, typename S> struct bind_type<R (C::*)(), S>
+{
+	typedef R (C::*F)();
+	typedef f_0<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename S> struct bind_type<R (C::*)(P1), S>
+{
+	typedef R (C::*F)(P1);
+	typedef f_1<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename S> struct bind_type<R (C::*)(P1, P2), S>
+{
+	typedef R (C::*F)(P1, P2);
+	typedef f_2<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename S> struct bind_type<R (C::*)(P1, P2, P3), S>
+{
+	typedef R (C::*F)(P1, P2, P3);
+	typedef f_3<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4), S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4);
+	typedef f_4<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5), S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5);
+	typedef f_5<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6), S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6);
+	typedef f_6<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6, P7), S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6, P7);
+	typedef f_7<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6, P7, P8), S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6, P7, P8);
+	typedef f_8<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+
+// const成員函式
+template<typename R, typename C, typename S> struct bind_type<R (C::*)() const, S>
+{
+	typedef R (C::*F)() const;
+	typedef f_0<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename S> struct bind_type<R (C::*)(P1) const, S>
+{
+	typedef R (C::*F)(P1) const;
+	typedef f_1<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename S> struct bind_type<R (C::*)(P1, P2) const, S>
+{
+	typedef R (C::*F)(P1, P2) const;
+	typedef f_2<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename S> struct bind_type<R (C::*)(P1, P2, P3) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3) const;
+	typedef f_3<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4) const;
+	typedef f_4<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5) const;
+	typedef f_5<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6) const;
+	typedef f_6<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6, P7) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6, P7) const;
+	typedef f_7<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+template<typename R, typename C, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename S> struct bind_type<R (C::*)(P1, P2, P3, P4, P5, P6, P7, P8) const, S>
+{
+	typedef R (C::*F)(P1, P2, P3, P4, P5, P6, P7, P8) const;
+	typedef f_8<R, C, F> W;
+	typedef bind_t<R, W, S> type;
+	static inline W wrap(F f) { return W(f); }
+};
+
+}//namespace _bind
+
+namespace _bind{
+
+// placeholder不該佔空間，若這裡編譯失敗，表示某個storage又替placeholder多留了欄位
+template<bool> struct placeholder_must_be_empty;
+template<> struct placeholder_must_be_empty<true>{ enum{ value=1 }; };
+
+typedef Argc<1>(*p1_t)();
+typedef Argc<2>(*p2_t)();
+typedef Argc<3>(*p3_t)();
+typedef void (*fn_t)();
+
+struct layout_check
+{
+	enum
+	{
+		// 全部都是placeholder的storage跟storage0一樣大
+		a = placeholder_must_be_empty<sizeof(storage3<p1_t, p2_t, p3_t>) == sizeof(storage0)>::value,
+		b = placeholder_must_be_empty<sizeof(storage9<p1_t, p2_t, p3_t, p1_t, p2_t, p3_t, p1_t, p2_t, p3_t>) == sizeof(storage0)>::value,
+
+		// 跟一般參數混在一起時只剩一般參數的大小
+		c = placeholder_must_be_empty<sizeof(storage3<p1_t, long, p2_t>) == sizeof(long)>::value,
+
+		// bind(&f,_1,_2,_3)只剩下函式指標本身
+		d = placeholder_must_be_empty<sizeof(bind_t<void, fn_t, storage3<p1_t, p2_t, p3_t> >) == sizeof(fn_t)>::value
+	};
 };
 
+}//namespace _bind
+
+#ifdef _STD_FUNCTIONAL_CXX11
+
+//----------------------------C++11用不定參數樣板處理----------------------------start
+// 綁定的參數用完美轉發直接搬進storage，右值只會被移動而不會被複製
+
+template<typename R, typename... P, typename... A>
+bind_t<R, R (*)(P...), typename storage_of<typename std::decay<A>::type...>::type> bind(R (*f)(P...), A&&... a)
+{
+	typedef R (*F)(P...);
+	typedef typename storage_of<typename std::decay<A>::type...>::type S;
+	return bind_t<R, F, S>(f, S(std::forward<A>(a)...));
+}
+
+template<typename R, typename C, typename... P, typename C1, typename... A>
+bind_t<R, typename _bind::member_of<sizeof...(P), R, C, R (C::*)(P...)>::type, typename storage_of<typename std::decay<C1>::type, typename std::decay<A>::type...>::type>
+bind(R (C::*f)(P...), C1 &&c1, A&&... a)
+{
+	typedef typename _bind::member_of<sizeof...(P), R, C, R (C::*)(P...)>::type F;
+	typedef typename storage_of<typename std::decay<C1>::type, typename std::decay<A>::type...>::type S;
+	return bind_t<R, F, S>(F(f), S(std::forward<C1>(c1), std::forward<A>(a)...));
+}
+
+template<typename R, typename C, typename... P, typename C1, typename... A>
+bind_t<R, typename _bind::member_of<sizeof...(P), R, C, R (C::*)(P...) const>::type, typename storage_of<typename std::decay<C1>::type, typename std::decay<A>::type...>::type>
+bind(R (C::*f)(P...) const, C1 &&c1, A&&... a)
+{
+	typedef typename _bind::member_of<sizeof...(P), R, C, R (C::*)(P...) const>::type F;
+	typedef typename storage_of<typename std::decay<C1>::type, typename std::decay<A>::type...>::type S;
+	return bind_t<R, F, S>(F(f), S(std::forward<C1>(c1), std::forward<A>(a)...));
+}
+
+//----------------------------C++11用不定參數樣板處理----------------------------end
+
+#else
+
 //----------------------------處理一般函式----------------------------start
 
 template<typename R>
@@ -1139,10 +1787,15 @@ bind_t<R, _bind::f_8<R, C, R (C::*)(A1,A2,A3,A4,A5,A6,A7,A8) const>, storage9<C1
 
 //----------------------------針對成員函式----------------------------end
 
-}//namespace std
+#endif//_STD_FUNCTIONAL_CXX11
+
+}//namespace _STD_FUNCTIONAL_NS
 
+#ifndef _STD_FUNCTIONAL_CXX11
+namespace functional = std;
+#endif
 
 
-#endif//__cplusplus > 201100L
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
 
 #endif//_STD_BIND_HPP_
@@ -0,0 +1,383 @@
+/**
+ * @file      callback_store.hpp
+ * @brief     依照目標的type分組存放callback，一次呼叫全部
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::callback_store<void(float)> tick;
+ *     tick.add(std::bind(&Unit::Update, &unit, _1));
+ *     tick.add(&UpdateParticles);
+ *     tick(0.016f);        // 呼叫全部的callback
+ *
+ * 同一種type的目標放在同一個連續的陣列裡，每個陣列各自用一個迴圈呼叫
+ * 迴圈裡的呼叫對象是靜態已知的type，編譯器能直接展開，不必每次都經過function的虛擬函式
+ * 虛擬呼叫只剩下每一組一次，N個callback就從N次難以預測的間接呼叫變成少數幾個好預測的迴圈
+ *
+ * 目標請直接放 bind() 的回傳值、函式指標或仿函式，放進 function 的話那一組仍然會逐一虛擬呼叫
+ * 同一組內照加入的順序呼叫，不同組之間則照各組第一次出現的順序，並不是全體的加入順序
+ * 所有callback拿到的都是同一份參數的左值參考，不會被前面的callback搬走
+ * callback裡面可以呼叫 add()，新加入的要等這一輪結束才放進去，下一次呼叫才會執行，但不可以呼叫 clear()
+ * 回傳值會被丟掉
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_CALLBACK_STORE_HPP_
+#define _STD_CALLBACK_STORE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <vector>
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+namespace _callback{
+
+//-----------------------依照目標的type決定呼叫方式-----------------------start
+
+// bind()的回傳值直接交給eval()
+template<typename R, typename S, typename A, typename B, typename C>
+inline void call(bind_t<A,B,C> &b, const S &s)
+{
+	b.eval(s);
+}
+
+// 一般函式指標或其他仿函式就讓storage把參數攤開
+template<typename R, typename S, typename T>
+inline void call(T &t, const S &s)
+{
+	s.Do(type<R>(), t);
+}
+
+//-----------------------依照目標的type決定呼叫方式-----------------------end
+
+/// 一組同樣type的callback< storage的種類 >
+template<typename S>
+struct bucket_base
+{
+	virtual ~bucket_base(){}
+	virtual void run(const S &s)=0;         // 依序呼叫這一組全部的callback
+	virtual void flush()=0;                 // 把呼叫期間加入的callback併進來
+	virtual size_t size() const=0;
+	virtual const void* key() const=0;      // 用來辨識這一組存的是哪種type
+};
+
+/// 實際存放callback的地方< 回傳值type , storage的種類 , 目標的type >
+template<typename R, typename S, typename T>
+struct bucket : bucket_base<S>
+{
+	static char id;                 // 只用它的位址，每種T各有一個
+	std::vector<T> items;
+	std::vector<T> later;           // 呼叫期間加入的，items在呼叫期間絕對不能被搬走
+
+	virtual void run(const S &s)
+	{
+		T *p = items.empty() ? 0 : &items[0];
+		T *end = p + items.size();
+
+		for ( ; p!=end ; ++p )
+		{
+			call<R>(*p, s);         // T是已知的type，這裡不會有虛擬呼叫
+		}
+	}
+
+	virtual void flush()
+	{
+		if ( later.empty() ) return;
+
+		items.insert(items.end(), later.begin(), later.end());
+		later.clear();
+	}
+
+	virtual size_t size() const
+	{
+		return items.size() + later.size();
+	}
+
+	virtual const void* key() const
+	{
+		return &id;
+	}
+};
+
+template<typename R, typename S, typename T>
+char bucket<R,S,T>::id = 0;
+
+/// 所有callback共用的參數，一律以左值參考存放< 函式簽名 >
+template<typename Sig> struct lvalue_storage;
+
+template<typename R> struct lvalue_storage<R()> { typedef storage0 type; };
+template<typename R, typename P1> struct lvalue_storage<R(P1)> { typedef storage1<typename param_traits<P1>::type> type; };
+template<typename R, typename P1, typename P2> struct lvalue_storage<R(P1, P2)> { typedef storage2<typename param_traits<P1>::type, typename param_traits<P2>::type> type; };
+template<typename R, typename P1, typename P2, typename P3> struct lvalue_storage<R(P1, P2, P3)> { typedef storage3<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4> struct lvalue_storage<R(P1, P2, P3, P4)> { typedef storage4<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5> struct lvalue_storage<R(P1, P2, P3, P4, P5)> { typedef storage5<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type, typename param_traits<P5>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> struct lvalue_storage<R(P1, P2, P3, P4, P5, P6)> { typedef storage6<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type, typename param_traits<P5>::type, typename param_traits<P6>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> struct lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7)> { typedef storage7<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type, typename param_traits<P5>::type, typename param_traits<P6>::type, typename param_traits<P7>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> struct lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)> { typedef storage8<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type, typename param_traits<P5>::type, typename param_traits<P6>::type, typename param_traits<P7>::type, typename param_traits<P8>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> struct lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> { typedef storage9<typename param_traits<P1>::type, typename param_traits<P2>::type, typename param_traits<P3>::type, typename param_traits<P4>::type, typename param_traits<P5>::type, typename param_traits<P6>::type, typename param_traits<P7>::type, typename param_traits<P8>::type, typename param_traits<P9>::type> type; };
+
+/// 依照函式簽名提供對應的operator()，樣板原型沒有用處< 衍生類別 , 函式簽名 >
+template<typename D, typename Sig> struct call_base{};
+
+/// 零個參數版本
+template<typename D, typename R>
+struct call_base<D, R()>
+{
+	typedef typename lvalue_storage<R()>::type St;
+
+	inline void operator()() const
+	{
+		static_cast<const D&>(*this).invoke(St());
+	}
+};
+
+/// 一個參數版本
+template<typename D, typename R, typename P1>
+struct call_base<D, R(P1)>
+{
+	typedef typename lvalue_storage<R(P1)>::type St;
+
+	inline void operator()(P1 p1) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1));
+	}
+};
+
+/// 兩個參數版本
+template<typename D, typename R, typename P1, typename P2>
+struct call_base<D, R(P1, P2)>
+{
+	typedef typename lvalue_storage<R(P1, P2)>::type St;
+
+	inline void operator()(P1 p1, P2 p2) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2));
+	}
+};
+
+/// 三個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3>
+struct call_base<D, R(P1, P2, P3)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3));
+	}
+};
+
+/// 四個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4>
+struct call_base<D, R(P1, P2, P3, P4)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4));
+	}
+};
+
+/// 五個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
+struct call_base<D, R(P1, P2, P3, P4, P5)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4, P5)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4, p5));
+	}
+};
+
+/// 六個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4, P5, P6)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4, p5, p6));
+	}
+};
+
+/// 七個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4, p5, p6, p7));
+	}
+};
+
+/// 八個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7, P8)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4, p5, p6, p7, p8));
+	}
+};
+
+/// 九個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>
+{
+	typedef typename lvalue_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>::type St;
+
+	inline void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+	{
+		static_cast<const D&>(*this).invoke(St(p1, p2, p3, p4, p5, p6, p7, p8, p9));
+	}
+};
+
+}//namespace _callback
+
+
+/// 依照目標type分組的callback容器< 函式簽名 >
+template<typename Sig>
+class callback_store : public _callback::call_base<callback_store<Sig>, Sig>
+{
+	public:
+
+		typedef typename _callback::call_base<callback_store<Sig>, Sig>::St St;
+		typedef typename function<Sig>::result_type R;
+
+		callback_store():depth_(0){}
+
+		~callback_store()
+		{
+			clear();
+		}
+
+		/// 加入一個callback，t可以是bind()的回傳值、函式指標或仿函式
+		/// 在callback裡面呼叫的話先放在一旁，這一輪呼叫完才併進去，下一輪才會被呼叫
+		template<typename T>
+		void add(const T &t)
+		{
+			_callback::bucket<R,St,T> *b = group<T>();
+
+			if ( depth_ ) b->later.push_back(t);
+			else          b->items.push_back(t);
+		}
+
+		/// 預先替某種type的callback保留空間，在callback裡面呼叫則沒有作用
+		template<typename T>
+		void reserve(size_t n)
+		{
+			if ( !depth_ ) group<T>()->items.reserve(n);
+		}
+
+		/// 目前總共有幾個callback
+		size_t size() const
+		{
+			size_t n = 0;
+
+			for ( size_t i=0 ; i<buckets_.size() ; i++ )
+			{
+				n += buckets_[i]->size();
+			}
+
+			return n;
+		}
+
+		/// 分成了幾組
+		size_t groups() const
+		{
+			return buckets_.size();
+		}
+
+		/// 不可以在callback裡面呼叫
+		void clear()
+		{
+			for ( size_t i=0 ; i<buckets_.size() ; i++ )
+			{
+				delete buckets_[i];
+			}
+
+			buckets_.clear();
+		}
+
+		/// 給call_base用的，每一組只有一次虛擬呼叫
+		void invoke(const St &s) const
+		{
+			dispatch_guard guard(this);
+
+			for ( size_t i=0 ; i<buckets_.size() ; i++ )
+			{
+				buckets_[i]->run(s);
+			}
+		}
+
+	private:
+
+		// 記錄正在呼叫的層數，最外層結束時(包括callback丟出例外)才把期間加入的併進去
+		struct dispatch_guard
+		{
+			explicit dispatch_guard(const callback_store *s):st(s) { st->depth_++; }
+
+			~dispatch_guard()
+			{
+				if ( --st->depth_ ) return;
+
+				for ( size_t i=0 ; i<st->buckets_.size() ; i++ )
+				{
+					st->buckets_[i]->flush();
+				}
+			}
+
+			const callback_store    *st;
+		};
+
+		callback_store(const callback_store&);              // 不允許複製
+		callback_store& operator=(const callback_store&);
+
+		// 找出T所屬的那一組，沒有的話就新增一組
+		template<typename T>
+		_callback::bucket<R,St,T>* group()
+		{
+			typedef _callback::bucket<R,St,T> B;
+
+			for ( size_t i=0 ; i<buckets_.size() ; i++ )
+			{
+				if ( buckets_[i]->key()==&B::id )
+				{
+					return static_cast<B*>(buckets_[i]);
+				}
+			}
+
+			B *b = new B;
+			buckets_.push_back(b);
+			return b;
+		}
+
+		std::vector<_callback::bucket_base<St>*>    buckets_;
+		mutable int                                 depth_;     // 正在呼叫的層數，callback裡面可能又呼叫一次
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_CALLBACK_STORE_HPP_
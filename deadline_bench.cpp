@@ -0,0 +1,150 @@
+// 量測deadline_executor在大量低優先權工作灌進來時，急件從投遞到開始執行的延遲
+// 同樣的流量跑兩次：急件放在最急的等級，以及急件跟一般工作排在同一個等級(等於普通的FIFO執行緒池)
+//
+// 用法: deadline_bench [工作執行緒數量] [急件數量]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+// C++11以後一樣要測這裡自己的實作，不要換成標準庫
+#if __cplusplus > 201100L
+#define FUNCTIONAL_OWN_IMPLEMENTATION
+#endif
+
+#include <functional.hpp>
+#include <deadline_executor.hpp>
+
+#ifndef _STD_FUNCTIONAL_CXX11
+namespace functional = std;
+#endif
+
+#if !defined(_WIN32)
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+
+static int64_t Now()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return int64_t(t.tv_sec)*1000000 + t.tv_nsec/1000;
+}
+
+static void Spin(int64_t us)
+{
+	int64_t end = Now() + us;
+	while ( Now() < end ) {}
+}
+
+// 一般工作，每個佔掉一點CPU時間
+static void Bulk()
+{
+	Spin(20);
+}
+
+// 急件，記下從投遞到開始執行等了多久
+static void Probe(int64_t *slot, int64_t posted)
+{
+	*slot = Now() - posted;
+}
+
+struct Flood
+{
+	functional::deadline_executor   *ex;
+	functional::atomic<int>         stop;
+};
+
+// 一直灌一般工作，讓佇列維持在一定的深度
+static void* FloodMain(void *p)
+{
+	Flood *f = static_cast<Flood*>(p);
+
+	while ( !f->stop.load() )
+	{
+		if ( f->ex->pending() < 4000 )
+		{
+			f->ex->post(functional::function<void()>(&Bulk));
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	return 0;
+}
+
+static int64_t Percentile(const std::vector<int64_t> &sorted, int p)
+{
+	return sorted[ ( sorted.size() - 1 ) * size_t(p) / 100 ];
+}
+
+static void Run(const char *name, size_t threads, size_t probes, bool urgent)
+{
+	std::vector<int64_t> latency(probes, 0);
+
+	{
+		functional::deadline_executor ex(threads, 2);
+
+		Flood f;
+		f.ex = &ex;
+		f.stop.store(0);
+
+		pthread_t flooder;
+		pthread_create(&flooder, 0, &FloodMain, &f);
+
+		while ( ex.pending() < 2000 ) sched_yield();      // 先把佇列灌滿再開始量
+
+		for ( size_t i=0 ; i<probes ; i++ )
+		{
+			int64_t posted = Now();
+			functional::function<void()> task = functional::bind(&Probe, &latency[i], posted);
+
+			if ( urgent ) ex.post(task, 0);
+			else          ex.post(task);                    // 跟一般工作一起排在最低等級
+
+			Spin(500);
+		}
+
+		f.stop.store(1);
+		pthread_join(flooder, 0);
+	}                                                       // 解構時會把剩下的工作做完
+
+	std::sort(latency.begin(), latency.end());
+
+	printf("%-10s p50=%8ldus  p99=%8ldus  max=%8ldus\n",
+	       name,
+	       long(Percentile(latency, 50)),
+	       long(Percentile(latency, 99)),
+	       long(latency.back()));
+}
+
+int main(int argc, char *argv[])
+{
+	size_t threads = argc > 1 ? size_t(atoi(argv[1])) : 2;
+	size_t probes  = argc > 2 ? size_t(atoi(argv[2])) : 2000;
+
+	if ( threads==0 ) threads = 1;
+	if ( probes==0 )  probes = 1;
+
+	printf("%lu worker thread(s), %lu urgent task(s), bulk queue kept near 4000\n", (unsigned long)threads, (unsigned long)probes);
+
+	Run("priority", threads, probes, true);
+	Run("fifo", threads, probes, false);
+
+	return 0;
+}
+
+#else
+
+int main()
+{
+	printf("deadline_executor needs pthread\n");
+	return 0;
+}
+
+#endif
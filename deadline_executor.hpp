@@ -0,0 +1,367 @@
+/**
+ * @file      deadline_executor.hpp
+ * @brief     依優先權與期限執行工作的執行緒池，急件不會被大量的一般工作卡住
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::deadline_executor ex(4, 3);                                 // 4條執行緒，3個優先權等級
+ *     ex.post(std::bind(&Control::OnHeartbeat, &ctl), 0, 2000);         // 最急，2毫秒內要開始執行
+ *     ex.post(std::bind(&Control::OnConfig, &ctl), 0);                  // 最急，沒有期限
+ *     ex.post(std::bind(&Bulk::Compress, &bulk, block));               // 沒指定就放最低等級
+ *
+ *     printf("missed %ld of %ld\n", ex.missed(), ex.executed());
+ *
+ * 優先權0最急，數字越大越不急，超出範圍的一律當成最低等級
+ * 每條執行緒拿工作時都從最急的等級找起，只要還有急件就不會去碰低等級的工作
+ * 同一個等級裡面期限最早的先執行(EDF)，沒有期限的排在有期限的後面，彼此之間維持投遞順序
+ *
+ * 投遞端只對該等級的無鎖串列做一次CAS，不會被執行緒池的鎖擋住
+ * 排序用的堆積只由當下取工作的那條執行緒整理，搶不到就從最急的等級重新找
+ * 開始執行時已經超過期限的工作照樣執行，但會計入 missed()
+ * 期限以微秒為單位，從投遞的那一刻開始算
+ *
+ * 可以當作 strand 的底層執行器
+ * 工作不可以丟出例外，解構時會先把排隊中的工作做完
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_DEADLINE_EXECUTOR_HPP_
+#define _STD_DEADLINE_EXECUTOR_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+#include <functional.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _deadline{
+
+/// 單調時鐘，單位是微秒
+inline int64_t now()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return int64_t(t.tv_sec)*1000000 + t.tv_nsec/1000;
+}
+
+struct node
+{
+	node(const function<void()> &f, int64_t d):task(f),deadline(d),seq(0),next(0){}
+
+	function<void()>    task;
+	int64_t             deadline;   // 沒有期限時是最大值
+	unsigned long       seq;        // 同樣期限時維持投遞順序
+	node                *next;
+};
+
+/// 給std::push_heap用，期限早的浮到最上面
+struct later
+{
+	inline bool operator()(const node *a, const node *b) const
+	{
+		return a->deadline!=b->deadline ? a->deadline > b->deadline : a->seq > b->seq;
+	}
+};
+
+/// 一個優先權等級
+class level
+{
+	public:
+
+		level():intake_(0),pending_(0),busy_(0),seq_(0){}
+
+		~level()
+		{
+			node *n = intake_.exchange(0);
+
+			while ( n )
+			{
+				node *next = n->next;
+				delete n;
+				n = next;
+			}
+
+			for ( size_t i=0 ; i<heap_.size() ; i++ )
+			{
+				delete heap_[i];
+			}
+		}
+
+		// 任何執行緒都可以呼叫
+		void push(node *n)
+		{
+			node *head = intake_.load(memory_order_relaxed);
+
+			do
+			{
+				n->next = head;
+			}
+			while ( !intake_.compare_exchange_weak(head, n, memory_order_release) );
+
+			pending_.fetch_add(1);
+		}
+
+		inline bool empty() const { return pending_.load()==0; }
+
+		/// 取出期限最早的工作，別的執行緒正在整理時設定contended並回傳0
+		node* take(bool &contended)
+		{
+			if ( busy_.exchange(1, memory_order_acquire) )
+			{
+				contended = true;
+				return 0;
+			}
+
+			// 串列是後進先出，反轉回投遞順序再編號
+			node *n = intake_.exchange(0, memory_order_acquire);
+			node *fifo = 0;
+
+			while ( n )
+			{
+				node *next = n->next;
+				n->next = fifo;
+				fifo = n;
+				n = next;
+			}
+
+			for ( ; fifo ; fifo = fifo->next )
+			{
+				fifo->seq = seq_++;
+				heap_.push_back(fifo);
+				std::push_heap(heap_.begin(), heap_.end(), later());
+			}
+
+			node *result = 0;
+
+			if ( !heap_.empty() )
+			{
+				std::pop_heap(heap_.begin(), heap_.end(), later());
+				result = heap_.back();
+				heap_.pop_back();
+			}
+
+			busy_.store(0, memory_order_release);
+
+			if ( result ) pending_.fetch_sub(1);
+
+			return result;
+		}
+
+	private:
+
+		level(const level&);
+		level& operator=(const level&);
+
+		atomic<node*>           intake_;    // 投遞端接上來的串列
+		atomic<long>            pending_;   // 串列加上堆積裡的工作數量
+		atomic<int>             busy_;      // 有執行緒正在整理堆積
+		std::vector<node*>      heap_;      // 只有拿到busy_的執行緒能碰
+		unsigned long           seq_;
+		char                    pad_[64];   // 別跟下一個等級擠在同一條cache line
+};
+
+}//namespace _deadline
+
+
+/// 依優先權與期限挑選工作的執行緒池
+class deadline_executor
+{
+	public:
+
+		static const int64_t no_deadline = int64_t(~uint64_t(0) >> 1);    // 排在所有有期限的工作後面
+
+		/// threads條工作執行緒，levels個優先權等級
+		deadline_executor(size_t threads, size_t levels = 2)
+			:levels_(new _deadline::level[levels ? levels : 1])
+			,count_(levels ? levels : 1)
+			,queued_(0)
+			,idle_(0)
+			,missed_(0)
+			,executed_(0)
+			,stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&wake_, 0);
+
+			if ( threads==0 ) threads = 1;
+
+			threads_.reserve(threads);
+
+			// 建不起來的就算了，解構時只join真的有在跑的
+			for ( size_t i=0 ; i<threads ; i++ )
+			{
+				pthread_t th;
+
+				if ( pthread_create(&th, 0, &deadline_executor::worker_main, this)==0 )
+				{
+					threads_.push_back(th);
+				}
+			}
+		}
+
+		~deadline_executor()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_broadcast(&wake_);
+			pthread_mutex_unlock(&lock_);
+
+			for ( size_t i=0 ; i<threads_.size() ; i++ )
+			{
+				pthread_join(threads_[i], 0);
+			}
+
+			pthread_cond_destroy(&wake_);
+			pthread_mutex_destroy(&lock_);
+
+			delete [] levels_;
+		}
+
+		/// 排進最低等級，沒有期限
+		inline void post(const function<void()> &f)
+		{
+			post(f, count_-1, -1);
+		}
+
+		/// within是從現在起算幾微秒內要開始執行，負數代表沒有期限
+		void post(const function<void()> &f, size_t priority, int64_t within = -1)
+		{
+			if ( priority >= count_ ) priority = count_-1;
+
+			int64_t d = within < 0 ? no_deadline : _deadline::now() + within;
+
+			levels_[priority].push(new _deadline::node(f, d));
+
+			queued_.fetch_add(1);
+
+			if ( idle_.load() )
+			{
+				pthread_mutex_lock(&lock_);
+				pthread_cond_signal(&wake_);
+				pthread_mutex_unlock(&lock_);
+			}
+		}
+
+		/// 開始執行時已經超過期限的工作數量
+		inline long missed() const { return missed_.load(); }
+
+		/// 已經執行完的工作數量
+		inline long executed() const { return executed_.load(); }
+
+		/// 還在排隊的工作數量，只能拿來參考
+		inline long pending() const { return queued_.load(); }
+
+		/// 實際建立成功的工作執行緒數量，可能比要求的少
+		inline size_t size() const { return threads_.size(); }
+
+		inline size_t levels() const { return count_; }
+
+	private:
+
+		deadline_executor(const deadline_executor&);        // 不允許複製
+		deadline_executor& operator=(const deadline_executor&);
+
+		static void* worker_main(void *p)
+		{
+			static_cast<deadline_executor*>(p)->worker();
+			return 0;
+		}
+
+		// 從最急的等級找起，被別人擋住時不往下找，免得先做了不急的
+		_deadline::node* next(bool &contended)
+		{
+			for ( size_t i=0 ; i<count_ ; i++ )
+			{
+				if ( levels_[i].empty() ) continue;
+
+				_deadline::node *n = levels_[i].take(contended);
+
+				if ( n || contended ) return n;
+			}
+
+			return 0;
+		}
+
+		void worker()
+		{
+			for (;;)
+			{
+				bool contended = false;
+				_deadline::node *n = next(contended);
+
+				if ( n )
+				{
+					queued_.fetch_sub(1);
+
+					if ( n->deadline!=no_deadline && _deadline::now() > n->deadline )
+					{
+						missed_.fetch_add(1);
+					}
+
+					n->task();
+					delete n;
+
+					executed_.fetch_add(1);
+					continue;
+				}
+
+				if ( contended )
+				{
+					sched_yield();
+					continue;
+				}
+
+				pthread_mutex_lock(&lock_);
+				idle_.fetch_add(1);
+
+				while ( queued_.load()==0 && !stop_ )
+				{
+					pthread_cond_wait(&wake_, &lock_);
+				}
+
+				idle_.fetch_sub(1);
+
+				bool done = stop_ && queued_.load()==0;
+
+				pthread_mutex_unlock(&lock_);
+
+				if ( done ) break;
+			}
+		}
+
+		_deadline::level            *levels_;
+		size_t                      count_;
+		atomic<long>                queued_;    // 所有等級排隊中的工作
+		atomic<long>                idle_;      // 正在睡覺的執行緒，沒人睡就不必碰鎖
+		atomic<long>                missed_;
+		atomic<long>                executed_;
+		pthread_mutex_t             lock_;
+		pthread_cond_t              wake_;
+		std::vector<pthread_t>      threads_;
+		bool                        stop_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_DEADLINE_EXECUTOR_HPP_
@@ -0,0 +1,511 @@
+/**
+ * @file      debounce.hpp
+ * @brief     把密集的呼叫合併成一次，只把最新(或累積起來)的參數交給真正的函式
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::function<void(int)> reload = &ReloadConfig;
+ *     std::function<void(int)> calm   = std::debounce(reload, 200);          // 安靜200毫秒之後才用最後一個參數執行
+ *     std::function<void(int)> merged = std::coalesce(reload);               // 執行期間進來的呼叫併成一次
+ *
+ *     std::function<void(double)> draw = std::bind(&Chart::Redraw, &chart, _1);
+ *     std::function<void(double)> ui   = std::coalesce(pool, draw);          // 交給執行器，排隊期間的呼叫併成一次
+ *     std::function<void(int)>    sum  = std::coalesce(pool, add, &Plus);    // 不取最新值，改用 int Plus(const int&, const int&) 累積
+ *
+ * coalesce: 沒有執行器時第一個呼叫的執行緒直接執行，執行期間別人的呼叫只更新參數，做完再由它補做一次
+ *           有執行器時第一個呼叫投遞一次，真正執行之前的呼叫都併進同一次
+ * debounce: 最後一次呼叫之後安靜了interval毫秒才執行，期間每次呼叫都會把時間往後推
+ *           預設在內部的計時執行緒上執行，有執行器時改成投遞到執行器
+ *           計時執行緒建不起來時不等待，呼叫的當下就執行(或投遞到執行器)，跟 coalesce 一樣
+ *
+ * 參數預設取最新的那一個，也可以傳入 V(const V&, const V&) 把新參數累積到舊的上面
+ * 同一個包裝出來的函式(包括它的複製品)保證不會同時執行
+ *
+ * 每次呼叫只是在鎖裡更新參數，本身不配置記憶體，但參數的type在複製時配置就沒辦法了
+ * 交給執行器時每一批只投遞一次，配置與否由執行器決定
+ * 包裝出來的函式全部消失時，還在等待的那一次照樣會執行
+ * 執行器必須比包裝出來的函式活得久
+ *
+ * 目前只支援 void() 與 void(P) 兩種簽名
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_DEBOUNCE_HPP_
+#define _STD_DEBOUNCE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <functional.hpp>
+#include <bind.hpp>
+#include <mutex.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _debounce{
+
+// 參數不管是不是參考或const，存起來的都是原本的type
+template<typename T> struct value_of           { typedef T type; };
+template<typename T> struct value_of<const T>  { typedef T type; };
+template<typename T> struct value_of<T&> : value_of<T>{};
+
+/// void()沒有參數，拿它佔位
+struct none{};
+
+/// 單調時鐘，單位是毫秒
+inline int64_t now()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return int64_t(t.tv_sec)*1000 + t.tv_nsec/1000000;
+}
+
+/// 共用狀態的基底，也是計時器串列的節點
+class core
+{
+	public:
+
+		core():refs_(1),due_(0),prev_(0),next_(0){}
+		virtual ~core(){}
+
+		inline void retain()  { refs_.fetch_add(1); }
+		inline void release() { if ( refs_.fetch_sub(1)==1 ) delete this; }
+
+		/// 計時到了，由計時執行緒呼叫，會用掉計時器持有的那份引用
+		virtual void fire() = 0;
+
+	private:
+
+		core(const core&);
+		core& operator=(const core&);
+
+		friend class timer;
+
+		atomic<long>    refs_;
+		int64_t         due_;       // 以下只有計時器會碰
+		core            *prev_;
+		core            *next_;
+};
+
+/// 所有debounce共用的計時執行緒，第一次用到才建立
+class timer
+{
+	public:
+
+		static timer& instance()
+		{
+			static timer t;
+			return t;
+		}
+
+		/// 呼叫端必須先替c保留一份引用，fire()時才放掉
+		/// 計時執行緒沒建起來時回傳false，引用還是呼叫端的
+		bool arm(core *c, int64_t due)
+		{
+			if ( !started_ ) return false;
+
+			pthread_mutex_lock(&lock_);
+
+			c->due_  = due;
+			c->prev_ = 0;
+			c->next_ = head_;
+
+			if ( head_ ) head_->prev_ = c;
+
+			head_ = c;
+
+			if ( due < earliest_ ) pthread_cond_signal(&wake_);     // 比目前在等的還早
+
+			pthread_mutex_unlock(&lock_);
+			return true;
+		}
+
+	private:
+
+		timer():head_(0),earliest_(0),stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&wake_, 0);
+			started_ = pthread_create(&thread_, 0, &timer::thread_main, this)==0;
+		}
+
+		~timer()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_signal(&wake_);
+			pthread_mutex_unlock(&lock_);
+
+			if ( started_ ) pthread_join(thread_, 0);
+
+			pthread_cond_destroy(&wake_);
+			pthread_mutex_destroy(&lock_);
+		}
+
+		timer(const timer&);
+		timer& operator=(const timer&);
+
+		static void* thread_main(void *p)
+		{
+			static_cast<timer*>(p)->loop();
+			return 0;
+		}
+
+		void unlink(core *c)
+		{
+			if ( c->prev_ ) c->prev_->next_ = c->next_;
+			else            head_ = c->next_;
+
+			if ( c->next_ ) c->next_->prev_ = c->prev_;
+		}
+
+		void loop()
+		{
+			pthread_mutex_lock(&lock_);
+
+			while ( !stop_ )
+			{
+				int64_t t = now();
+				core *expired = 0;
+
+				earliest_ = int64_t(~uint64_t(0) >> 1);
+
+				for ( core *c = head_ ; c ; )
+				{
+					core *next = c->next_;
+
+					if ( c->due_ <= t )
+					{
+						unlink(c);
+						c->next_ = expired;
+						expired = c;
+					}
+					else if ( c->due_ < earliest_ )
+					{
+						earliest_ = c->due_;
+					}
+
+					c = next;
+				}
+
+				if ( expired )
+				{
+					earliest_ = 0;      // 執行期間有人arm()就不必叫醒我們，回來會重新掃
+					pthread_mutex_unlock(&lock_);
+
+					while ( expired )
+					{
+						core *next = expired->next_;
+						expired->fire();
+						expired = next;
+					}
+
+					pthread_mutex_lock(&lock_);
+					continue;
+				}
+
+				if ( !head_ )
+				{
+					pthread_cond_wait(&wake_, &lock_);
+					continue;
+				}
+
+				// 條件變數用的是實際時間，把剩下的毫秒數換算過去
+				int64_t wait = earliest_ - t;
+				timespec abs;
+				clock_gettime(CLOCK_REALTIME, &abs);
+				abs.tv_sec  += time_t(wait / 1000);
+				abs.tv_nsec += long(wait % 1000) * 1000000;
+
+				if ( abs.tv_nsec >= 1000000000 )
+				{
+					abs.tv_sec++;
+					abs.tv_nsec -= 1000000000;
+				}
+
+				pthread_cond_timedwait(&wake_, &lock_, &abs);
+			}
+
+			pthread_mutex_unlock(&lock_);
+		}
+
+		pthread_mutex_t     lock_;
+		pthread_cond_t      wake_;
+		pthread_t           thread_;
+		bool                started_;   // 計時執行緒有建起來
+		core                *head_;     // 還沒到期的，沒有排序
+		int64_t             earliest_;  // 目前睡到什麼時候
+		bool                stop_;
+};
+
+/// 沒有執行器時直接在當下的執行緒執行
+struct inline_executor{};
+
+inline void call(const function<void()> &f, const none&) { f(); }
+
+template<typename P, typename V>
+inline void call(const function<void(P)> &f, const V &v) { f(v); }
+
+/// 一個包裝出來的函式背後的共用狀態< function的type , 參數的type , 執行器的type >
+template<typename Fn, typename V, typename E>
+class state : public core
+{
+	public:
+
+		typedef function<V(const V&, const V&)> reducer;
+
+		state(const Fn &f, long interval, E *ex, const reducer &r)
+			:f_(f),reduce_(r),ex_(ex),interval_(interval),last_(0),pending_(false),scheduled_(false)
+		{
+			if ( ex_ ) run_ = bind(&state::run, this);
+		}
+
+		/// 包裝出來的函式被呼叫
+		void call(const V &v)
+		{
+			bool start;
+			int64_t due = 0;
+
+			{
+				lock_guard<mutex> guard(lock_);
+
+				if ( pending_ && reduce_ ) value_ = reduce_(value_, v);
+				else                       value_ = v;
+
+				pending_ = true;
+
+				if ( interval_ )
+				{
+					last_ = now();
+					due   = last_ + interval_;
+				}
+
+				start = !scheduled_;
+				scheduled_ = true;
+			}
+
+			if ( !start ) return;      // 已經有一次在路上了
+
+			retain();
+
+			// 沒有計時執行緒就不等了，直接執行
+			if ( !interval_ || !timer::instance().arm(this, due) ) dispatch();
+		}
+
+		virtual void fire()
+		{
+			int64_t due;
+
+			{
+				lock_guard<mutex> guard(lock_);
+				due = last_ + interval_;
+			}
+
+			// 等待期間又被呼叫過，時間往後推
+			if ( now() >= due || !timer::instance().arm(this, due) ) dispatch();
+		}
+
+	private:
+
+		// 目前持有一份引用，交出去之後由run()放掉
+		inline void dispatch()
+		{
+			post(static_cast<E*>(0));
+		}
+
+		inline void post(inline_executor*) { run(); }
+
+		template<typename X>
+		inline void post(X*) { ex_->post(run_); }
+
+		void run()
+		{
+			for (;;)
+			{
+				V v;
+
+				{
+					lock_guard<mutex> guard(lock_);
+					v = value_;
+					pending_ = false;
+				}
+
+				_debounce::call(f_, v);
+
+				lock_guard<mutex> guard(lock_);
+
+				if ( !pending_ )
+				{
+					scheduled_ = false;
+					break;
+				}
+
+				// 執行期間又被呼叫了，coalesce馬上補做，debounce重新等安靜
+				if ( interval_ )
+				{
+					timer::instance().arm(this, last_ + interval_);
+					return;                 // 引用交給計時器
+				}
+			}
+
+			release();
+		}
+
+		Fn                  f_;
+		reducer             reduce_;
+		E                   *ex_;
+		function<void()>    run_;       // 事先綁好，投遞時不用再綁一次
+		long                interval_;  // 0代表coalesce
+		int64_t             last_;      // 最後一次被呼叫的時間
+		mutex               lock_;
+		V                   value_;
+		bool                pending_;   // value_還沒交出去
+		bool                scheduled_; // 已經排定或正在執行
+};
+
+/// 塞進bind_t裡的仿函式，複製時只會共用同一份狀態< 狀態的type >
+template<typename S>
+struct wrapper
+{
+	public:
+
+		typedef void result_type;
+
+		explicit wrapper(S *s):s_(s){}
+		wrapper(const wrapper &other):s_(other.s_){ s_->retain(); }
+		~wrapper(){ s_->release(); }
+
+		wrapper& operator=(const wrapper &other)
+		{
+			other.s_->retain();
+			s_->release();
+			s_ = other.s_;
+			return *this;
+		}
+
+		inline void operator()() const
+		{
+			s_->call(none());
+		}
+		template<typename A1>
+		inline void operator()(const A1 &a1) const
+		{
+			s_->call(a1);
+		}
+
+	private:
+
+		S   *s_;
+};
+
+template<typename E>
+inline function<void()> make(const function<void()> &f, long interval, E *ex)
+{
+	typedef state<function<void()>, none, E> S;
+	typedef wrapper<S> F;
+	return bind_t<void, F, storage0>(F(new S(f, interval, ex, typename S::reducer())), storage0());
+}
+template<typename P, typename E>
+inline function<void(P)> make(const function<void(P)> &f, long interval, E *ex, const function<typename value_of<P>::type(const typename value_of<P>::type&, const typename value_of<P>::type&)> &r)
+{
+	typedef state<function<void(P)>, typename value_of<P>::type, E> S;
+	typedef wrapper<S> F;
+	typedef storage1<Argc<1>(*)()> St;
+	Argc<1> (*a1)() = placeholders::_1;
+	return bind_t<void, F, St>(F(new S(f, interval, ex, r)), St(a1));
+}
+
+}//namespace _debounce
+
+//---------------------------coalesce---------------------------start
+
+// 回傳的function與原本的簽名相同，還沒執行到的呼叫會被併成一次
+
+inline function<void()> coalesce(const function<void()> &f)
+{
+	return _debounce::make(f, 0, static_cast<_debounce::inline_executor*>(0));
+}
+template<typename E>
+inline function<void()> coalesce(E &ex, const function<void()> &f)
+{
+	return _debounce::make(f, 0, &ex);
+}
+template<typename P>
+inline function<void(P)> coalesce(const function<void(P)> &f)
+{
+	return _debounce::make(f, 0, static_cast<_debounce::inline_executor*>(0), function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)>());
+}
+template<typename P>
+inline function<void(P)> coalesce(const function<void(P)> &f, const function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)> &reduce)
+{
+	return _debounce::make(f, 0, static_cast<_debounce::inline_executor*>(0), reduce);
+}
+template<typename E, typename P>
+inline function<void(P)> coalesce(E &ex, const function<void(P)> &f)
+{
+	return _debounce::make(f, 0, &ex, function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)>());
+}
+template<typename E, typename P>
+inline function<void(P)> coalesce(E &ex, const function<void(P)> &f, const function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)> &reduce)
+{
+	return _debounce::make(f, 0, &ex, reduce);
+}
+
+//---------------------------coalesce---------------------------end
+
+//---------------------------debounce---------------------------start
+
+// 回傳的function與原本的簽名相同，安靜interval毫秒之後才執行一次，interval至少是1
+
+inline function<void()> debounce(const function<void()> &f, long interval)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, static_cast<_debounce::inline_executor*>(0));
+}
+template<typename E>
+inline function<void()> debounce(E &ex, const function<void()> &f, long interval)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, &ex);
+}
+template<typename P>
+inline function<void(P)> debounce(const function<void(P)> &f, long interval)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, static_cast<_debounce::inline_executor*>(0), function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)>());
+}
+template<typename P>
+inline function<void(P)> debounce(const function<void(P)> &f, long interval, const function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)> &reduce)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, static_cast<_debounce::inline_executor*>(0), reduce);
+}
+template<typename E, typename P>
+inline function<void(P)> debounce(E &ex, const function<void(P)> &f, long interval)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, &ex, function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)>());
+}
+template<typename E, typename P>
+inline function<void(P)> debounce(E &ex, const function<void(P)> &f, long interval, const function<typename _debounce::value_of<P>::type(const typename _debounce::value_of<P>::type&, const typename _debounce::value_of<P>::type&)> &reduce)
+{
+	return _debounce::make(f, interval > 0 ? interval : 1, &ex, reduce);
+}
+
+//---------------------------debounce---------------------------end
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_DEBOUNCE_HPP_
@@ -0,0 +1,550 @@
+/**
+ * @file      fiber.hpp
+ * @brief     在使用者空間的堆疊上執行 function<void()>，由多個執行緒合作排程的 fiber
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::fiber_scheduler sched(4);                   // 4個工作執行緒
+ *     sched.spawn(std::bind(&Handler::Serve, &handler, request));
+ *     sched.wait();                                    // 等所有fiber都結束
+ *
+ *     // 在fiber裡面
+ *     std::this_fiber::yield();                        // 讓出執行緒給別的fiber
+ *     std::fiber_mutex m;  std::fiber_condition_variable cv;
+ *     m.lock(); while ( !ready ) cv.wait(m); m.unlock();
+ *
+ * M個fiber分散在N個工作執行緒上執行，每個fiber可以在不同執行緒上被喚醒(M:N)
+ * 切換只在yield()或等待fiber_mutex/fiber_condition_variable時發生，屬於合作式排程
+ * 等待時只會讓出執行緒給別的fiber，不會讓整個工作執行緒睡著
+ *
+ * 每個堆疊底下都有一頁無法存取的保護頁，堆疊溢位會直接當掉而不是默默地寫壞別人的資料
+ * 控制區塊就放在堆疊頂端，結束的fiber連同堆疊一起回收再利用，spawn()通常不必mmap
+ *
+ * fiber裡面不可以丟出例外，也不要呼叫會讓執行緒睡著的鎖或I/O，不然同一個執行緒上的fiber都會卡住
+ * fiber_mutex與fiber_condition_variable只能在fiber裡面使用
+ * 因為fiber會換執行緒，fiber裡不要持有thread local變數的位址
+ *
+ * 以ucontext實作，只支援 Linux
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_FIBER_HPP_
+#define _STD_FIBER_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif defined(__linux__)
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <ucontext.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <functional.hpp>
+#include <mutex.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+class fiber_scheduler;
+
+namespace _fiber{
+
+enum state
+{
+	running,
+	yielded,        // 還能繼續跑，排回佇列尾端
+	blocked,        // 等別人喚醒，切換完才釋放unlock_after
+	finished        // 執行完畢，回收堆疊
+};
+
+/// fiber的控制區塊，放在自己堆疊的頂端
+struct fiber
+{
+	ucontext_t          ctx;
+	function<void()>    entry;
+	fiber_scheduler     *sched;
+	fiber               *next;      // 串在執行佇列或等待串列上
+	char                *base;      // mmap回傳的位址，包含保護頁
+	size_t              bytes;
+	state               st;
+};
+
+/// 只經由next串起來的先進先出串列，fiber同一時間只會待在一個串列上
+struct fiber_list
+{
+	fiber_list():head(0),tail(0){}
+
+	inline bool empty() const { return head==0; }
+
+	inline void push(fiber *f)
+	{
+		f->next = 0;
+
+		if ( tail ) tail->next = f;
+		else        head = f;
+
+		tail = f;
+	}
+
+	inline fiber* pop()
+	{
+		fiber *f = head;
+
+		if ( f )
+		{
+			head = f->next;
+
+			if ( !head ) tail = 0;
+		}
+
+		return f;
+	}
+
+	fiber   *head;
+	fiber   *tail;
+};
+
+/// 每個工作執行緒的狀態
+struct worker
+{
+	worker():sched(0),current(0),unlock_after(0){}
+
+	ucontext_t          ctx;            // 排程迴圈自己的context
+	fiber_scheduler     *sched;
+	fiber               *current;
+	mutex               *unlock_after;  // fiber的context存好之後才能放開的鎖
+	pthread_t           thread;
+};
+
+// fiber會換執行緒，每次都要重新讀取thread local，不能讓編譯器把位址快取起來
+// 光是noinline還不夠，編譯器會推論出這是const函式而把呼叫合併，所以塞一段空的asm
+__attribute__((noinline)) inline worker*& this_worker()
+{
+	static __thread worker *w = 0;
+	__asm__ __volatile__("" ::: "memory");
+	return w;
+}
+
+// 把目前的fiber切回排程迴圈，回來的時候可能已經在別的執行緒上了
+inline void suspend(state st, mutex *unlock_after)
+{
+	worker *w = this_worker();
+	fiber  *f = w->current;
+
+	f->st = st;
+	w->unlock_after = unlock_after;
+	swapcontext(&f->ctx, &w->ctx);
+}
+
+inline fiber* current()
+{
+	worker *w = this_worker();
+	return w ? w->current : 0;
+}
+
+}//namespace _fiber
+
+
+/// 把fiber分散到數個工作執行緒上執行的排程器
+class fiber_scheduler
+{
+	public:
+
+		enum
+		{
+			default_stack_size = 64*1024
+		};
+
+		explicit fiber_scheduler(size_t threads, size_t stack_size = default_stack_size)
+			:live_(0),stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&work_, 0);
+			pthread_cond_init(&idle_, 0);
+
+			page_ = size_t(sysconf(_SC_PAGESIZE));
+			bytes_ = round_up(stack_size, page_) + round_up(sizeof(_fiber::fiber), page_) + page_;
+
+			if ( threads==0 ) threads = 1;
+
+			workers_.resize(threads);       // 執行緒拿著元素的位址，之後只能縮小不能變大
+
+			// 建不起來的就算了，成功的依序往前放，最後只留下真的有在跑的
+			size_t started = 0;
+
+			for ( size_t i=0 ; i<threads ; i++ )
+			{
+				_fiber::worker &w = workers_[started];
+				w.sched = this;
+
+				if ( pthread_create(&w.thread, 0, &fiber_scheduler::worker_main, &w)==0 ) started++;
+			}
+
+			workers_.resize(started);
+		}
+
+		/// 先等所有fiber結束才會停下工作執行緒
+		~fiber_scheduler()
+		{
+			wait();
+
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_broadcast(&work_);
+			pthread_mutex_unlock(&lock_);
+
+			for ( size_t i=0 ; i<workers_.size() ; i++ )
+			{
+				pthread_join(workers_[i].thread, 0);
+			}
+
+			for ( size_t i=0 ; i<stacks_.size() ; i++ )
+			{
+				destroy(stacks_[i]);
+			}
+
+			pthread_cond_destroy(&idle_);
+			pthread_cond_destroy(&work_);
+			pthread_mutex_destroy(&lock_);
+		}
+
+		/// 建立一個fiber來執行f，fiber裡面也可以呼叫，記憶體不足或沒有任何工作執行緒時回傳false
+		bool spawn(const function<void()> &f)
+		{
+			if ( workers_.empty() ) return false;
+
+			_fiber::fiber *fb = acquire();
+
+			if ( !fb ) return false;
+
+			fb->entry = f;
+			prepare(fb);
+
+			pthread_mutex_lock(&lock_);
+			live_++;
+			pthread_mutex_unlock(&lock_);
+
+			ready(fb);
+			return true;
+		}
+
+		/// 讓目前的OS執行緒等到所有fiber都結束，不可以在fiber裡面呼叫
+		void wait()
+		{
+			pthread_mutex_lock(&lock_);
+
+			while ( live_ )
+			{
+				pthread_cond_wait(&idle_, &lock_);
+			}
+
+			pthread_mutex_unlock(&lock_);
+		}
+
+		/// 實際建立成功的工作執行緒數量，可能比要求的少
+		inline size_t threads() const { return workers_.size(); }
+
+		/// 還沒結束的fiber數量，只能拿來參考
+		size_t size()
+		{
+			pthread_mutex_lock(&lock_);
+			size_t n = live_;
+			pthread_mutex_unlock(&lock_);
+			return n;
+		}
+
+		/// 把等待中的fiber排回執行佇列，給fiber_mutex這類工具使用
+		void ready(_fiber::fiber *f)
+		{
+			pthread_mutex_lock(&lock_);
+			f->st = _fiber::running;
+			queue_.push(f);
+			pthread_cond_signal(&work_);
+			pthread_mutex_unlock(&lock_);
+		}
+
+	private:
+
+		fiber_scheduler(const fiber_scheduler&);            // 不允許複製
+		fiber_scheduler& operator=(const fiber_scheduler&);
+
+		static inline size_t round_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+		//-----------------------------------堆疊池-----------------------------------start
+
+		_fiber::fiber* acquire()
+		{
+			pthread_mutex_lock(&lock_);
+
+			if ( !stacks_.empty() )
+			{
+				_fiber::fiber *f = stacks_.back();
+				stacks_.pop_back();
+				pthread_mutex_unlock(&lock_);
+				return f;
+			}
+
+			pthread_mutex_unlock(&lock_);
+
+			void *p = mmap(0, bytes_, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
+
+			if ( p==MAP_FAILED ) return 0;
+
+			char *base = static_cast<char*>(p);
+			mprotect(base, page_, PROT_NONE);      // 保護頁在最低的位址，堆疊往下長到這裡就會當掉
+
+			// 控制區塊放在最頂端那幾頁，堆疊從它底下開始
+			char *top = base + bytes_ - round_up(sizeof(_fiber::fiber), page_);
+			_fiber::fiber *f = new (top) _fiber::fiber();
+			f->sched = this;
+			f->base  = base;
+			f->bytes = bytes_;
+			return f;
+		}
+
+		static void destroy(_fiber::fiber *f)
+		{
+			char   *base  = f->base;
+			size_t bytes  = f->bytes;
+			f->~fiber();
+			munmap(base, bytes);
+		}
+
+		//-----------------------------------堆疊池-----------------------------------end
+
+		// getcontext()會返回兩次，放在spawn()裡面的話acquire()被inline進來時GCC會報-Wclobbered
+		__attribute__((noinline)) void prepare(_fiber::fiber *fb)
+		{
+			getcontext(&fb->ctx);
+			fb->ctx.uc_stack.ss_sp   = fb->base + page_;
+			fb->ctx.uc_stack.ss_size = reinterpret_cast<char*>(fb) - (fb->base + page_);
+			fb->ctx.uc_link          = 0;
+			makecontext(&fb->ctx, &fiber_scheduler::fiber_main, 0);
+		}
+
+		// 每個fiber的起點
+		static void fiber_main()
+		{
+			_fiber::fiber *f = _fiber::current();
+			f->entry();
+			f->entry = function<void()>();     // 綁定的物件在fiber自己的堆疊上解構，不必佔著排程器的鎖
+			_fiber::suspend(_fiber::finished, 0);
+			abort();        // 結束的fiber不會再被切回來
+		}
+
+		static void* worker_main(void *p)
+		{
+			_fiber::worker *w = static_cast<_fiber::worker*>(p);
+			_fiber::this_worker() = w;
+			w->sched->run(w);
+			return 0;
+		}
+
+		void run(_fiber::worker *w)
+		{
+			for (;;)
+			{
+				pthread_mutex_lock(&lock_);
+
+				while ( queue_.empty() && !stop_ )
+				{
+					pthread_cond_wait(&work_, &lock_);
+				}
+
+				_fiber::fiber *f = queue_.pop();
+				pthread_mutex_unlock(&lock_);
+
+				if ( !f ) return;
+
+				w->current = f;
+				swapcontext(&w->ctx, &f->ctx);
+				w->current = 0;
+
+				// fiber的context已經存好了，這時才能讓別人看到它
+				switch ( f->st )
+				{
+					case _fiber::yielded:
+						ready(f);
+						break;
+
+					case _fiber::blocked:
+						if ( w->unlock_after ) w->unlock_after->unlock();
+						w->unlock_after = 0;
+						break;
+
+					case _fiber::finished:
+						pthread_mutex_lock(&lock_);
+						stacks_.push_back(f);
+
+						if ( --live_==0 ) pthread_cond_broadcast(&idle_);
+
+						pthread_mutex_unlock(&lock_);
+						break;
+
+					default:
+						break;
+				}
+			}
+		}
+
+		pthread_mutex_t                 lock_;      // 保護執行佇列、堆疊池與計數
+		pthread_cond_t                  work_;      // 佇列有東西了
+		pthread_cond_t                  idle_;      // 所有fiber都結束了
+		_fiber::fiber_list              queue_;
+		std::vector<_fiber::fiber*>     stacks_;    // 可以再利用的堆疊
+		std::vector<_fiber::worker>     workers_;
+		size_t                          page_;
+		size_t                          bytes_;     // 每個堆疊實際mmap的大小
+		size_t                          live_;
+		bool                            stop_;
+};
+
+
+namespace this_fiber{
+
+/// 讓出目前的工作執行緒給其他fiber，不在fiber裡的話就讓出OS執行緒
+inline void yield()
+{
+	if ( _fiber::current() )
+	{
+		_fiber::suspend(_fiber::yielded, 0);
+	}
+	else
+	{
+		sched_yield();
+	}
+}
+
+}//namespace this_fiber
+
+
+/// 等待時只讓出工作執行緒的互斥鎖，解鎖時直接把擁有權交給排最前面的fiber
+class fiber_mutex
+{
+	public:
+
+		fiber_mutex():locked_(false){}
+
+		void lock()
+		{
+			guard_.lock();
+
+			if ( !locked_ )
+			{
+				locked_ = true;
+				guard_.unlock();
+				return;
+			}
+
+			waiters_.push(_fiber::current());
+			_fiber::suspend(_fiber::blocked, &guard_);     // 被喚醒時鎖已經是我們的了
+		}
+
+		bool try_lock()
+		{
+			lock_guard<mutex> g(guard_);
+
+			if ( locked_ ) return false;
+
+			locked_ = true;
+			return true;
+		}
+
+		void unlock()
+		{
+			lock_guard<mutex> g(guard_);
+			_fiber::fiber *f = waiters_.pop();
+
+			if ( f )
+			{
+				f->sched->ready(f);
+			}
+			else
+			{
+				locked_ = false;
+			}
+		}
+
+	private:
+
+		fiber_mutex(const fiber_mutex&);
+		fiber_mutex& operator=(const fiber_mutex&);
+
+		mutex               guard_;     // 只在改狀態的幾個指令之間持有
+		_fiber::fiber_list  waiters_;
+		bool                locked_;
+};
+
+
+/// 搭配fiber_mutex使用的條件變數
+class fiber_condition_variable
+{
+	public:
+
+		fiber_condition_variable(){}
+
+		/// 放開m並等待通知，返回前會重新鎖上m
+		void wait(fiber_mutex &m)
+		{
+			guard_.lock();
+			waiters_.push(_fiber::current());
+			m.unlock();
+			_fiber::suspend(_fiber::blocked, &guard_);
+			m.lock();
+		}
+
+		/// 等到pred()成立為止
+		template<typename P>
+		void wait(fiber_mutex &m, P pred)
+		{
+			while ( !pred() )
+			{
+				wait(m);
+			}
+		}
+
+		void notify_one()
+		{
+			lock_guard<mutex> g(guard_);
+			_fiber::fiber *f = waiters_.pop();
+
+			if ( f ) f->sched->ready(f);
+		}
+
+		void notify_all()
+		{
+			lock_guard<mutex> g(guard_);
+			_fiber::fiber *f;
+
+			while ( (f = waiters_.pop())!=0 )
+			{
+				f->sched->ready(f);
+			}
+		}
+
+	private:
+
+		fiber_condition_variable(const fiber_condition_variable&);
+		fiber_condition_variable& operator=(const fiber_condition_variable&);
+
+		mutex               guard_;
+		_fiber::fiber_list  waiters_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_FIBER_HPP_
@@ -0,0 +1,312 @@
+/**
+ * @file      frame_runner.hpp
+ * @brief     每個 frame 只花固定的時間推進背景工作，工作分很多次做完
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::frame_runner jobs;                                              // 輪流執行
+ *     size_t id = jobs.add(std::bind(&PathFinder::Step, &finder));         // bool Step() 做完回傳true
+ *     jobs.add(std::bind(&Storage::CompactSome, &storage, 64), 1);         // 優先權1
+ *
+ *     for (;;)                                                             // 遊戲主迴圈
+ *     {
+ *         Update();
+ *         jobs.tick(2000);                                                 // 這個frame最多給背景工作2毫秒
+ *         Render();
+ *     }
+ *
+ * 工作的簽名是 bool()，每次呼叫只做一小段，回傳true表示做完了，之後就會被拿掉
+ * 每次 tick() 會一直挑下一個工作來執行，直到用完 budget(微秒) 為止
+ * round_robin 模式從上次停下來的地方接著輪，by_priority 模式每次都挑優先權最高的
+ *
+ * 每個工作每次執行花多少時間會被記下來(指數平均)，預估放不進剩下的時間就先跳過，改挑放得進的
+ * 每次 tick() 的第一個工作一定會執行，所以再慢的工作也會有進展，但這一次就可能超過 budget
+ *
+ * 工作裡面可以呼叫 add() 或 remove()，包括拿掉自己
+ * 工作丟出的例外會從 tick() 傳出去，工作本身留著下次再執行，丟出之前拿掉了自己的話就直接釋放
+ * 不是執行緒安全的，請在同一條執行緒上使用
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_FRAME_RUNNER_HPP_
+#define _STD_FRAME_RUNNER_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <stdint.h>
+#include <functional.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _frame{
+
+/// 單調時鐘，單位是奈秒
+inline int64_t now()
+{
+	#if defined(_WIN32)
+		LARGE_INTEGER f, c;
+		QueryPerformanceFrequency(&f);
+		QueryPerformanceCounter(&c);
+		return int64_t(c.QuadPart / f.QuadPart) * 1000000000 + int64_t(c.QuadPart % f.QuadPart) * 1000000000 / f.QuadPart;
+	#else
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return int64_t(t.tv_sec)*1000000000 + t.tv_nsec;
+	#endif
+}
+
+struct slot
+{
+	slot():priority(0),cost(0),runs(0),used(false),removed(false){}
+
+	function<bool()>    job;
+	int                 priority;
+	int64_t             cost;       // 每次執行的預估時間(奈秒)，還沒跑過是0
+	unsigned long       runs;
+	bool                used;
+	bool                removed;    // 執行中被拿掉，等它返回再清
+};
+
+}//namespace _frame
+
+
+/// 在固定時間預算內逐步推進的工作清單
+class frame_runner
+{
+	public:
+
+		enum schedule
+		{
+			round_robin,    // 輪流，從上次停下的下一個接著做
+			by_priority     // 優先權高的先做，同樣優先權的照加入順序
+		};
+
+		static const size_t npos = size_t(-1);
+
+		explicit frame_runner(schedule s = round_robin):schedule_(s),cursor_(0),running_(npos),used_(0){}
+
+		/// 加入一個工作並回傳它的編號，優先權只在by_priority模式有作用，數字大的先做
+		size_t add(const function<bool()> &job, int priority = 0)
+		{
+			size_t id;
+
+			if ( free_.empty() )
+			{
+				id = slots_.size();
+				slots_.push_back(_frame::slot());      // deque，執行中的工作不會被搬走
+			}
+			else
+			{
+				id = free_.back();
+				free_.pop_back();
+			}
+
+			_frame::slot &s = slots_[id];
+			s.job      = job;
+			s.priority = priority;
+			s.cost     = 0;
+			s.runs     = 0;
+			s.used     = true;
+			s.removed  = false;
+
+			if ( schedule_==by_priority )
+			{
+				size_t i = order_.size();
+
+				while ( i && slots_[order_[i-1]].priority < priority ) i--;
+
+				order_.insert(order_.begin()+i, id);
+
+				if ( i < cursor_ ) cursor_++;
+			}
+			else
+			{
+				order_.push_back(id);
+			}
+
+			return id;
+		}
+
+		/// 拿掉還沒做完的工作
+		bool remove(size_t id)
+		{
+			if ( id >= slots_.size() || !slots_[id].used || slots_[id].removed ) return false;
+
+			if ( id==running_ )
+			{
+				slots_[id].removed = true;
+			}
+			else
+			{
+				release(id);
+			}
+
+			return true;
+		}
+
+		/// 在budget微秒內盡量推進工作，回傳這次執行了幾次
+		size_t tick(long budget)
+		{
+			int64_t start    = _frame::now();
+			int64_t deadline = start + int64_t(budget)*1000;
+			int64_t t        = start;
+			size_t  steps    = 0;
+
+			while ( !order_.empty() )
+			{
+				size_t pick = choose(deadline - t, steps==0);
+
+				if ( pick==npos ) break;        // 剩下的時間放不進任何工作
+
+				size_t id = order_[pick];
+
+				run_guard guard(this, id);
+				bool done = slots_[id].job();
+				guard.finish();
+
+				int64_t end = _frame::now();
+				measure(slots_[id], end - t);
+				t = end;
+				steps++;
+
+				if ( schedule_==round_robin )
+				{
+					cursor_ = position(id) + 1;     // 工作裡可能加減了別的工作，重新找位置
+				}
+
+				if ( done || slots_[id].removed ) release(id);
+
+				if ( t >= deadline ) break;
+			}
+
+			used_ = (t - start) / 1000;
+
+			return steps;
+		}
+
+		/// 還沒做完的工作數量
+		inline size_t size() const { return order_.size(); }
+
+		inline bool empty() const { return order_.empty(); }
+
+		/// 某個工作每次執行的預估時間(微秒)，還沒執行過是0
+		inline long estimate(size_t id) const
+		{
+			return id < slots_.size() && slots_[id].used ? long(slots_[id].cost / 1000) : 0;
+		}
+
+		/// 上一次tick()實際花掉的時間(微秒)
+		inline long used() const { return used_; }
+
+	private:
+
+		frame_runner(const frame_runner&);          // 不允許複製
+		frame_runner& operator=(const frame_runner&);
+
+		// 執行中的記號，工作丟出例外時也一定會清掉，並釋放已經拿掉自己的工作
+		struct run_guard
+		{
+			run_guard(frame_runner *r, size_t i):owner(r),id(i),finished(false) { owner->running_ = id; }
+
+			~run_guard()
+			{
+				if ( finished ) return;
+
+				owner->running_ = npos;
+
+				if ( owner->slots_[id].removed ) owner->release(id);
+			}
+
+			// 正常返回，剩下的交給tick()處理
+			inline void finish()
+			{
+				owner->running_ = npos;
+				finished = true;
+			}
+
+			frame_runner    *owner;
+			size_t          id;
+			bool            finished;
+		};
+
+		// 找第一個預估放得進剩下時間的工作，first時不管預估直接挑
+		size_t choose(int64_t remaining, bool first) const
+		{
+			size_t n     = order_.size();
+			size_t begin = schedule_==round_robin ? cursor_ % n : 0;
+
+			for ( size_t k=0 ; k<n ; k++ )
+			{
+				size_t i = ( begin + k ) % n;
+
+				if ( first || slots_[order_[i]].cost <= remaining ) return i;
+			}
+
+			return npos;
+		}
+
+		// 指數平均，新的量測佔四分之一
+		static void measure(_frame::slot &s, int64_t cost)
+		{
+			if ( s.runs++==0 ) s.cost = cost;
+			else               s.cost += ( cost - s.cost ) / 4;
+		}
+
+		size_t position(size_t id) const
+		{
+			for ( size_t i=0 ; i<order_.size() ; i++ )
+			{
+				if ( order_[i]==id ) return i;
+			}
+
+			return 0;
+		}
+
+		void release(size_t id)
+		{
+			size_t i = position(id);
+
+			order_.erase(order_.begin()+i);
+
+			if ( i < cursor_ ) cursor_--;
+
+			_frame::slot &s = slots_[id];
+			s.job     = function<bool()>();
+			s.used    = false;
+			s.removed = false;
+			free_.push_back(id);
+		}
+
+		schedule                    schedule_;
+		std::deque<_frame::slot>    slots_;
+		std::vector<size_t>         order_;     // 還沒做完的工作，by_priority時依優先權排好
+		std::vector<size_t>         free_;      // 可以重複使用的編號
+		size_t                      cursor_;    // round_robin下次從哪裡開始
+		size_t                      running_;   // 正在執行的工作
+		long                        used_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_FRAME_RUNNER_HPP_
@@ -6,6 +6,20 @@
  * <pre>
  * 用法參考 std::function 或 boost::function 都可以
  *
+ * f.emplace<T>(args...) 直接在核心裡建構仿函式 T
+ * f.emplace_bind(&g, args...) 等同於 f = bind(&g, args...)，但綁定的參數只會被複製一次
+ *
+ * 回傳大型物件的函式可以改用 f.invoke_into(out, args...) 把結果直接寫進 out
+ * C++98底下 out 的 type 要有 swap() 才省得掉複製，沒有的話改用 f.construct_into(p, args...) 直接建構在還沒有物件的記憶體 p 上
+ *
+ * 呼叫空的function會丟出 bad_function_call，關掉例外的環境則直接 abort()
+ *
+ * 編譯時定義 FUNCTIONAL_TELEMETRY 可以統計每種函式簽名的核心配置、clone()等次數
+ *
+ * C++11以後預設直接用標準庫，定義 FUNCTIONAL_OWN_IMPLEMENTATION 則改用這份實作
+ * 這時候所有東西都放在 namespace functional 裡，不會跟標準庫撞名
+ * C++98底下 functional 只是 std 的別名，兩邊的程式碼都能寫成 functional::function
+ *
  * http://github.com/ToyAuthor/functional
  * </pre>
  */
@@ -15,29 +29,134 @@
 #define _STD_FUNCTIONAL_HPP_
 
 
-// 判斷編譯器是否為C++11，是就改用標準庫吧
-#if __cplusplus > 201100L
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
 
 #include <functional>
 
 #else
 
 
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
 #include <bind.hpp>
 
-namespace std{
+#ifdef FUNCTIONAL_TELEMETRY
+#include <cstdio>
+#include <cstdlib>
+#include <typeinfo>
+#include <atomic.hpp>
+#endif
+
+namespace _STD_FUNCTIONAL_NS{
+
+/// 呼叫空的function時丟出的例外
+class bad_function_call : public std::exception
+{
+	public:
+
+		virtual const char* what() const throw() { return "bad_function_call"; }
+};
+
+template<typename R, typename S> struct function_base;
 
 
 namespace _functional{
 
+/// 用來對齊內部緩衝區的type們，需要把物件直接放進自己體內的工具都會用到
+union max_align
+{
+	long double     ld;
+	double          d;
+	long            l;
+	void            *p;
+	void            (*f)();
+};
+
+/// function::operator()收到的參數以參考形式放進storage，免得多複製一次
+/// C++11底下是右值參考，參數能一路搬到目標函式< 函式簽名 >
+template<typename Sig> struct call_storage;
+
+#ifdef _STD_FUNCTIONAL_CXX11
+template<typename P> struct call_arg       { typedef P&& type; };
+#else
+template<typename P> struct call_arg       { typedef P& type; };
+template<typename P> struct call_arg<P&>   { typedef P& type; };
+#endif
+
+// 把operator()的參數轉成call_arg的形式交給storage
+template<typename P>
+inline typename call_arg<P>::type pass(typename untie_ref<P>::type &p)
+{
+	return static_cast<typename call_arg<P>::type>(p);
+}
+
+template<typename R> struct call_storage<R()> { typedef storage0 type; };
+template<typename R, typename P1> struct call_storage<R(P1)> { typedef storage1<typename call_arg<P1>::type> type; };
+template<typename R, typename P1, typename P2> struct call_storage<R(P1, P2)> { typedef storage2<typename call_arg<P1>::type, typename call_arg<P2>::type> type; };
+template<typename R, typename P1, typename P2, typename P3> struct call_storage<R(P1, P2, P3)> { typedef storage3<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4> struct call_storage<R(P1, P2, P3, P4)> { typedef storage4<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5> struct call_storage<R(P1, P2, P3, P4, P5)> { typedef storage5<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type, typename call_arg<P5>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> struct call_storage<R(P1, P2, P3, P4, P5, P6)> { typedef storage6<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type, typename call_arg<P5>::type, typename call_arg<P6>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> struct call_storage<R(P1, P2, P3, P4, P5, P6, P7)> { typedef storage7<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type, typename call_arg<P5>::type, typename call_arg<P6>::type, typename call_arg<P7>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> struct call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)> { typedef storage8<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type, typename call_arg<P5>::type, typename call_arg<P6>::type, typename call_arg<P7>::type, typename call_arg<P8>::type> type; };
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> struct call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> { typedef storage9<typename call_arg<P1>::type, typename call_arg<P2>::type, typename call_arg<P3>::type, typename call_arg<P4>::type, typename call_arg<P5>::type, typename call_arg<P6>::type, typename call_arg<P7>::type, typename call_arg<P8>::type, typename call_arg<P9>::type> type; };
+
+/// invoke_into()用來把結果寫進呼叫端的物件< 函式回傳值的型態 >
+template<typename R>
+struct into
+{
+	typedef typename _bind::untie_const<typename untie_ref<R>::type>::type& out_type;
+
+	template<typename S, typename F>
+	static inline void Do(out_type out, const S &s, F &f)
+	{
+		R tmp(s.Do(type<R>(), f));      // 回傳值直接建構在tmp上
+		_bind::give<R>::Do(out, tmp);
+	}
+
+	template<typename B, typename S>
+	static inline void eval(out_type out, const B &b, const S &s)
+	{
+		b.eval_into(out, s);
+	}
+};
+
+/// 沒有回傳值就沒有東西可以寫，照常呼叫就好
+template<>
+struct into<void>
+{
+	typedef void* out_type;
+
+	template<typename S, typename F>
+	static inline void Do(out_type, const S &s, F &f)
+	{
+		s.Do(type<void>(), f);
+	}
+
+	template<typename B, typename S>
+	static inline void eval(out_type, const B &b, const S &s)
+	{
+		b.eval(s);
+	}
+};
+
 /// function物件的核心所在< 函式回傳值的型態 , storage的種類 >
 template<typename R, typename S>
 struct core_base
 {
 	virtual ~core_base(){}
 	virtual core_base* clone() const=0;             // 幫助function物件copy自己
+	virtual core_base* clone_to(void *p) const=0;   // 跟clone()一樣，只是複製到外部準備好的記憶體上
 	virtual R CallFunction(const S &s) const=0;     // 執行function內容
+	virtual void CallInto(typename into<R>::out_type out, const S &s) const=0;  // 執行function內容，結果寫進out
+	virtual size_t footprint() const=0;             // 核心本身佔了幾個位元組，統計用
 	virtual void SetObject(void *p){}               // 為了從外部輸入物件指標而設計的
+#ifdef _STD_FUNCTIONAL_CXX11
+	virtual core_base* move_to(void *p){ return clone_to(p); }  // 跟clone_to()一樣，但目標可以被搬走，只有複製成本低的核心不必覆寫
+#endif
 };
 
 /// 支援一般函式< return type , storage type , _functional pointer type >
@@ -53,10 +172,25 @@ struct core_function : core_base< R, S >
 		return new core_function(_f);
 	}
 
+	virtual core_base<R,S>* clone_to(void *p) const
+	{
+		return new (p) core_function(_f);
+	}
+
+	virtual size_t footprint() const
+	{
+		return sizeof(*this);
+	}
+
 	R CallFunction(const S &s) const
 	{
 		return s.Do(type<R>(),_f);
 	}
+
+	void CallInto(typename into<R>::out_type out, const S &s) const
+	{
+		into<R>::Do(out, s, _f);
+	}
 };
 
 /// 偽裝成一般函式指標，但是內含物件指標，真正執行的是成員函式< return type , member function pointer , claas type >
@@ -118,10 +252,25 @@ struct core_member_function : core_base< R, S >
 	{
 		return new core_member_function(_f);
 	}
+
+	virtual core_base<R,S>* clone_to(void *p) const
+	{
+		return new (p) core_member_function(_f);
+	}
+
+	virtual size_t footprint() const
+	{
+		return sizeof(*this);
+	}
 	R CallFunction(const S &s) const
 	{
 		return s.Do(type<R>(),_f);
 	}
+
+	void CallInto(typename into<R>::out_type out, const S &s) const
+	{
+		into<R>::Do(out, s, _f);
+	}
 	void SetObject(void *app)
 	{
 		_f.set_this(app);
@@ -134,32 +283,329 @@ struct core_bind : core_base< typename T::result_type, S >
 {
 	typedef typename T::result_type result_type;
 
-	const T     obj;        // 用來儲存bind_t物件
+	T           obj;        // 用來儲存bind_t物件，C++11底下要能被move_to()搬走所以不是const
 
 	explicit core_bind(const T &b):obj(b){}
+#ifdef _STD_FUNCTIONAL_CXX11
+	explicit core_bind(T &&b):obj(std::move(b)){}
+
+	// 讓bind_t直接在核心裡建構，參數只會被複製(或移動)一次
+	template<typename W, typename... A>
+	core_bind(_bind::emplace_tag t, const W &f, A&&... a):obj(t, f, std::forward<A>(a)...){}
+#else
+	// 讓bind_t直接在核心裡建構，參數只會被複製一次
+	template<typename W>
+	core_bind(_bind::emplace_tag t, const W &f):obj(t, f){}
+	template<typename W, typename A1>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1):obj(t, f, a1){}
+	template<typename W, typename A1, typename A2>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2):obj(t, f, a1, a2){}
+	template<typename W, typename A1, typename A2, typename A3>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3):obj(t, f, a1, a2, a3){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4):obj(t, f, a1, a2, a3, a4){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4, typename A5>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5):obj(t, f, a1, a2, a3, a4, a5){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6):obj(t, f, a1, a2, a3, a4, a5, a6){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7):obj(t, f, a1, a2, a3, a4, a5, a6, a7){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8):obj(t, f, a1, a2, a3, a4, a5, a6, a7, a8){}
+	template<typename W, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	core_bind(_bind::emplace_tag t, const W &f, A1 &a1, A2 &a2, A3 &a3, A4 &a4, A5 &a5, A6 &a6, A7 &a7, A8 &a8, A9 &a9):obj(t, f, a1, a2, a3, a4, a5, a6, a7, a8, a9){}
+#endif
 
 	virtual core_base<result_type,S>* clone() const
 	{
 		return new core_bind(obj);
 	}
 
+	virtual core_base<result_type,S>* clone_to(void *p) const
+	{
+		return new (p) core_bind(obj);
+	}
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	virtual core_base<result_type,S>* move_to(void *p)
+	{
+		return new (p) core_bind(std::move(obj));
+	}
+#endif
+
+	virtual size_t footprint() const
+	{
+		return sizeof(*this);
+	}
+
 	virtual result_type CallFunction(const S &s) const
 	{
 		return obj.eval(s);
 	}
+
+	virtual void CallInto(typename into<result_type>::out_type out, const S &s) const
+	{
+		into<result_type>::eval(out, obj, s);
+	}
 };
 
+/// 支援任意的仿函式，由function::emplace()直接在核心裡建構< 回傳值type , storage type , 仿函式type >
+template<typename R, typename S, typename T>
+struct core_functor : core_base< R, S >
+{
+	mutable T   obj;        // 仿函式本身，operator()不一定是const所以用mutable
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename... A>
+	explicit core_functor(_bind::emplace_tag, A&&... a):obj(std::forward<A>(a)...){}
+#else
+	explicit core_functor(_bind::emplace_tag):obj(){}
+	template<typename A1>
+	core_functor(_bind::emplace_tag, const A1 &a1):obj(a1){}
+	template<typename A1, typename A2>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2):obj(a1, a2){}
+	template<typename A1, typename A2, typename A3>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3):obj(a1, a2, a3){}
+	template<typename A1, typename A2, typename A3, typename A4>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4):obj(a1, a2, a3, a4){}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5):obj(a1, a2, a3, a4, a5){}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6):obj(a1, a2, a3, a4, a5, a6){}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7):obj(a1, a2, a3, a4, a5, a6, a7){}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8):obj(a1, a2, a3, a4, a5, a6, a7, a8){}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	core_functor(_bind::emplace_tag, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9):obj(a1, a2, a3, a4, a5, a6, a7, a8, a9){}
+#endif
+
+	virtual core_base<R,S>* clone() const
+	{
+		return new core_functor(*this);
+	}
+
+	virtual core_base<R,S>* clone_to(void *p) const
+	{
+		return new (p) core_functor(*this);
+	}
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	virtual core_base<R,S>* move_to(void *p)
+	{
+		return new (p) core_functor(std::move(*this));
+	}
+#endif
+
+	virtual size_t footprint() const
+	{
+		return sizeof(*this);
+	}
+
+	R CallFunction(const S &s) const
+	{
+		return s.Do(type<R>(),obj);
+	}
+
+	void CallInto(typename into<R>::out_type out, const S &s) const
+	{
+		into<R>::Do(out, s, obj);
+	}
+};
+
+//-------------------------------------統計數字-------------------------------------start
+// 定義FUNCTIONAL_TELEMETRY之後，每種函式簽名都會各自累計下列數字
+// 程式結束時會自動把結果印到stderr，執行期間也可以透過function_counters::first()逐一讀取
+// 沒有定義的話這些掛鉤全都是空的inline函式，不會留下任何成本
+
+#ifdef FUNCTIONAL_TELEMETRY
+
+}//namespace _functional
+
+/// 單一函式簽名的統計數字
+struct function_counters
+{
+	explicit function_counters(const char *n):name(n),cores_allocated(0),clones(0),bytes_held(0),destroyed(0),empty_calls(0),next(0){}
+
+	const char      *name;              // function_base<R,S>經過typeid()得到的名稱
+	atomic<long>    cores_allocated;    // 配置過幾個核心，包含clone()出來的
+	atomic<long>    clones;             // 呼叫過幾次clone()
+	atomic<long>    bytes_held;         // 目前所有存活的核心一共佔了多少位元組
+	atomic<long>    destroyed;          // 刪除過幾個核心
+	atomic<long>    empty_calls;        // 呼叫沒有內容的function幾次
+	function_counters *next;
+
+	/// 所有出現過的函式簽名會串成一條串列，從這裡開始讀
+	static inline const function_counters* first()
+	{
+		return head().load();
+	}
+
+	/// 把目前所有的數字印出來
+	static void dump(FILE *out)
+	{
+		for ( const function_counters *c = first() ; c ; c = c->next )
+		{
+			fprintf(out, "%s: cores_allocated=%ld clones=%ld bytes_held=%ld destroyed=%ld empty_calls=%ld\n",
+			        c->name,
+			        c->cores_allocated.load(),
+			        c->clones.load(),
+			        c->bytes_held.load(),
+			        c->destroyed.load(),
+			        c->empty_calls.load());
+		}
+	}
+
+	// 新的函式簽名第一次被用到時掛上串列
+	static void add(function_counters *c)
+	{
+		function_counters *old = head().load();
+
+		do
+		{
+			c->next = old;
+		}
+		while ( !head().compare_exchange_weak(old, c) );
+
+		static atomic<int> registered(0);
+
+		if ( registered.exchange(1)==0 )
+		{
+			atexit(&dump_at_exit);
+		}
+	}
+
+	private:
+
+		static inline atomic<function_counters*>& head()
+		{
+			static atomic<function_counters*> h;
+			return h;
+		}
+
+		static void dump_at_exit()
+		{
+			dump(stderr);
+		}
+
+		function_counters(const function_counters&);
+		function_counters& operator=(const function_counters&);
+};
+
+namespace _functional{
+
+/// 每種函式簽名各自擁有一份統計數字< 函式回傳值的型態 , storage的種類 >
+template<typename R, typename S>
+struct telemetry
+{
+	static function_counters& counters()
+	{
+		static function_counters *c = make();
+		return *c;
+	}
+
+	static inline void created(const core_base<R,S> *p)
+	{
+		counters().cores_allocated.fetch_add(1);
+		counters().bytes_held.fetch_add(long(p->footprint()));
+	}
+
+	static inline void destroyed(const core_base<R,S> *p)
+	{
+		counters().destroyed.fetch_add(1);
+		counters().bytes_held.fetch_sub(long(p->footprint()));
+	}
+
+	static inline void cloned()     { counters().clones.fetch_add(1); }
+	static inline void empty_call() { counters().empty_calls.fetch_add(1); }
+
+	private:
+
+		// 故意不釋放，程式結束時atexit()還要讀取它
+		static function_counters* make()
+		{
+			function_counters *c = new function_counters(typeid(function_base<R,S>).name());
+			function_counters::add(c);
+			return c;
+		}
+};
+
+#else
+
+template<typename R, typename S>
+struct telemetry
+{
+	static inline void created(const core_base<R,S>*){}
+	static inline void destroyed(const core_base<R,S>*){}
+	static inline void cloned(){}
+	static inline void empty_call(){}
+};
+
+#endif//FUNCTIONAL_TELEMETRY
+
+//-------------------------------------統計數字-------------------------------------end
+
+// 判斷目前的編譯設定有沒有開啟例外
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define _STD_FUNCTIONAL_EXCEPTIONS
+#define _STD_FUNCTIONAL_THROW(e) throw e
+#else
+#define _STD_FUNCTIONAL_THROW(e) std::abort()
+#endif
+
+/// 空function的替身，讓pCore永遠不會是0，operator()也就不必檢查指標< 函式回傳值的型態 , storage的種類 >
+/// 每個函式簽名共用同一個靜態物件，永遠不會被delete
+/// inplace_function與variant_function空著的時候也交給它，三者呼叫空物件的行為一致
+template<typename R, typename S>
+struct core_empty : core_base<R,S>
+{
+	static core_empty instance;
+
+	virtual core_base<R,S>* clone() const
+	{
+		return &instance;
+	}
+
+	virtual core_base<R,S>* clone_to(void *p) const
+	{
+		return new (p) core_empty;
+	}
+
+	virtual size_t footprint() const
+	{
+		return 0;
+	}
+
+	R CallFunction(const S &) const
+	{
+		telemetry<R,S>::empty_call();
+		_STD_FUNCTIONAL_THROW(bad_function_call());
+	}
+
+	void CallInto(typename into<R>::out_type, const S &) const
+	{
+		telemetry<R,S>::empty_call();
+		_STD_FUNCTIONAL_THROW(bad_function_call());
+	}
+};
+
+template<typename R, typename S>
+core_empty<R,S> core_empty<R,S>::instance;
+
 }//namespace _functional
 
 /// function_base是下面各種function類別的共同基底，負責實現所有function都會需要的共同特徵< 函式回傳值的型態 , storage的種類 >
 template<typename R, typename S> struct function_base
 {
-	function_base():pCore(0){}
-	~function_base(){delete pCore;}
+	typedef R result_type;
+	typedef _functional::telemetry<R,S> telemetry;
+
+	function_base():pCore(empty()){}
+	~function_base(){reset(0);}
 
 	operator bool () const
 	{
-		if ( pCore )
+		if ( pCore != empty() )
 		{
 			return true;
 		}
@@ -167,7 +613,7 @@ template<typename R, typename S> struct function_base
 		return false;
 	}
 
-	_functional::core_base<R,S>     *pCore;     // 外部使用者不該修改此指標，該老慮要不要"protected"起來了
+	_functional::core_base<R,S>     *pCore;     // 外部使用者不該修改此指標，沒有內容時指向core_empty而不是0
 
 	// 用來輸入物件指標
 	template<typename C>
@@ -176,25 +622,291 @@ template<typename R, typename S> struct function_base
 		pCore->SetObject((void*)(c));
 	}
 
+	// 所有空function共用的核心
+	static inline _functional::core_base<R,S>* empty()
+	{
+		return &_functional::core_empty<R,S>::instance;
+	}
+
+	// 換上新的核心並丟掉舊的，所有對pCore的修改都該經過這裡，統計數字才會準確
+	// 傳入0代表清空
+	inline void reset(_functional::core_base<R,S> *p)
+	{
+		if ( p )
+		{
+			telemetry::created(p);
+		}
+		else
+		{
+			p = empty();
+		}
+
+		if ( pCore != empty() )
+		{
+			telemetry::destroyed(pCore);
+			delete pCore;
+		}
+
+		pCore = p;
+	}
+
+	// 給operator()用的，空function的核心會自己丟出例外，這裡不必檢查
+	inline _functional::core_base<R,S>* get_core() const
+	{
+		return pCore;
+	}
+
+	//----就地建構----start
+	// 參數直接交給核心裡的物件，不會先做出暫時的物件再整個複製進去
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	// 在核心裡建構一個T，回傳它的參考
+	template<typename T, typename... A>
+	inline T& emplace(A&&... a)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), std::forward<A>(a)...);
+		reset(c);
+		return c->obj;
+	}
+
+	// 效果等同於 *this = bind(f, a...)，但bind_t與綁定的參數直接建構在核心裡
+	template<typename F, typename... A>
+	inline void emplace_bind(F f, A&&... a)
+	{
+		typedef _bind::bind_type<F, typename storage_of<typename std::decay<A>::type...>::type> B;
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), std::forward<A>(a)...));
+	}
+#else
+	// 在核心裡建構一個T，回傳它的參考
+	template<typename T>
+	inline T& emplace()
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag());
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1>
+	inline T& emplace(const A1 &a1)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2>
+	inline T& emplace(const A1 &a1, const A2 &a2)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4, a5);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4, a5, a6);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4, a5, a6, a7);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4, a5, a6, a7, a8);
+		reset(c);
+		return c->obj;
+	}
+	template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline T& emplace(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9)
+	{
+		_functional::core_functor<R,S,T> *c = new _functional::core_functor<R,S,T>(_bind::emplace_tag(), a1, a2, a3, a4, a5, a6, a7, a8, a9);
+		reset(c);
+		return c->obj;
+	}
+
+	// 效果等同於 *this = bind(f, a...)，但bind_t與綁定的參數直接建構在核心裡
+	template<typename F>
+	inline void emplace_bind(F f)
+	{
+		typedef _bind::bind_type<F, storage0 > B;
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f)));
+	}
+	template<typename F, typename A1>
+	inline void emplace_bind(F f, const A1 &a1)
+	{
+		typedef _bind::bind_type<F, storage1<typename _bind::decay<A1>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1));
+	}
+	template<typename F, typename A1, typename A2>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2)
+	{
+		typedef _bind::bind_type<F, storage2<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2));
+	}
+	template<typename F, typename A1, typename A2, typename A3>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3)
+	{
+		typedef _bind::bind_type<F, storage3<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4)
+	{
+		typedef _bind::bind_type<F, storage4<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5)
+	{
+		typedef _bind::bind_type<F, storage5<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type, typename _bind::decay<A5>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		typename _bind::hold<A5>::type h5 = _bind::hold<A5>::get(a5);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4, h5));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6)
+	{
+		typedef _bind::bind_type<F, storage6<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type, typename _bind::decay<A5>::type, typename _bind::decay<A6>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		typename _bind::hold<A5>::type h5 = _bind::hold<A5>::get(a5);
+		typename _bind::hold<A6>::type h6 = _bind::hold<A6>::get(a6);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4, h5, h6));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7)
+	{
+		typedef _bind::bind_type<F, storage7<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type, typename _bind::decay<A5>::type, typename _bind::decay<A6>::type, typename _bind::decay<A7>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		typename _bind::hold<A5>::type h5 = _bind::hold<A5>::get(a5);
+		typename _bind::hold<A6>::type h6 = _bind::hold<A6>::get(a6);
+		typename _bind::hold<A7>::type h7 = _bind::hold<A7>::get(a7);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4, h5, h6, h7));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8)
+	{
+		typedef _bind::bind_type<F, storage8<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type, typename _bind::decay<A5>::type, typename _bind::decay<A6>::type, typename _bind::decay<A7>::type, typename _bind::decay<A8>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		typename _bind::hold<A5>::type h5 = _bind::hold<A5>::get(a5);
+		typename _bind::hold<A6>::type h6 = _bind::hold<A6>::get(a6);
+		typename _bind::hold<A7>::type h7 = _bind::hold<A7>::get(a7);
+		typename _bind::hold<A8>::type h8 = _bind::hold<A8>::get(a8);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4, h5, h6, h7, h8));
+	}
+	template<typename F, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline void emplace_bind(F f, const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9)
+	{
+		typedef _bind::bind_type<F, storage9<typename _bind::decay<A1>::type, typename _bind::decay<A2>::type, typename _bind::decay<A3>::type, typename _bind::decay<A4>::type, typename _bind::decay<A5>::type, typename _bind::decay<A6>::type, typename _bind::decay<A7>::type, typename _bind::decay<A8>::type, typename _bind::decay<A9>::type> > B;
+		typename _bind::hold<A1>::type h1 = _bind::hold<A1>::get(a1);
+		typename _bind::hold<A2>::type h2 = _bind::hold<A2>::get(a2);
+		typename _bind::hold<A3>::type h3 = _bind::hold<A3>::get(a3);
+		typename _bind::hold<A4>::type h4 = _bind::hold<A4>::get(a4);
+		typename _bind::hold<A5>::type h5 = _bind::hold<A5>::get(a5);
+		typename _bind::hold<A6>::type h6 = _bind::hold<A6>::get(a6);
+		typename _bind::hold<A7>::type h7 = _bind::hold<A7>::get(a7);
+		typename _bind::hold<A8>::type h8 = _bind::hold<A8>::get(a8);
+		typename _bind::hold<A9>::type h9 = _bind::hold<A9>::get(a9);
+		reset(new _functional::core_bind<typename B::type, S>(_bind::emplace_tag(), B::wrap(f), h1, h2, h3, h4, h5, h6, h7, h8, h9));
+	}
+#endif
+
+	//----就地建構----end
+
 	//----讓function物件可以像普通結構一樣的複製、傳遞----start
 
-	function_base(const function_base &other)
+	function_base(const function_base &other):pCore(empty())
 	{
-		if (other.pCore)
+		if ( other )
 		{
+			telemetry::cloned();
 			pCore = other.pCore->clone();
+			telemetry::created(pCore);
 		}
-		// 這邊沒有else的處理感覺比較危險
 	}
 
 	function_base& operator=(const function_base &other)
 	{
-		delete pCore;
-		pCore = other.pCore ? other.pCore->clone() : other.pCore;
+		if ( other )
+		{
+			telemetry::cloned();
+			reset(other.pCore->clone());
+		}
+		else
+		{
+			reset(0);
+		}
+
 		return *this;
 	}
 
 	//----讓function物件可以像普通結構一樣的複製、傳遞----end
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	// 移動時直接把核心交出去，被移走的function會變成空的
+	function_base(function_base &&other) noexcept : pCore(other.pCore)
+	{
+		other.pCore = empty();
+	}
+
+	function_base& operator=(function_base &&other) noexcept
+	{
+		if ( this != &other )
+		{
+			reset(0);
+			pCore = other.pCore;
+			other.pCore = empty();
+		}
+
+		return *this;
+	}
+#endif
 };
 
 
@@ -205,10 +917,10 @@ template<typename S> struct function{};
 
 /// function的沒有參數版本
 template<typename R>
-struct function<R()> : function_base<R, storage0>
+struct function<R()> : function_base<R, typename _functional::call_storage<R()>::type>
 {
 	typedef R (*Fn)();
-	typedef storage0 St;
+	typedef typename _functional::call_storage<R()>::type St;
 	using function_base<R,St>::pCore;       // 想令"pCore"屬性非public就不能用這招了
 
 	function(){}        // function在宣告時可以不用賦予內容沒關係
@@ -216,12 +928,11 @@ struct function<R()> : function_base<R, storage0>
 	//---------------------支援一般函式---------------------start
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 	//---------------------支援一般函式---------------------end
@@ -231,21 +942,20 @@ struct function<R()> : function_base<R, storage0>
 	function(R(C::*f)())
 	{
 		typedef _functional::member_function<R,R (C::*)(),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)())
 	{
 		typedef _functional::member_function<R,R (C::*)(),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 	//---------------------支援成員函式---------------------end
@@ -254,30 +964,55 @@ struct function<R()> : function_base<R, storage0>
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 		return *this;
 	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+		return *this;
+	}
+#endif
 	//---------------------支援bind()---------------------end
 
 	// 執行core_base裡暗藏的function，
 	R operator()() const
 	{
-		return pCore->CallFunction(St());
+		return this->get_core()->CallFunction(St());
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out) const
+	{
+		this->get_core()->CallInto(out, St());
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p) const
+	{
+		new (p) R(this->get_core()->CallFunction(St()));
 	}
 };
 
 /// function的一個參數版本
 template<typename R, typename P1>
-struct function<R(P1)> : function_base<R, storage1<P1> >
+struct function<R(P1)> : function_base<R, typename _functional::call_storage<R(P1)>::type>
 {
 	typedef R (*Fn)(P1);
-	typedef storage1<P1> St;
+	typedef typename _functional::call_storage<R(P1)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
@@ -285,12 +1020,11 @@ struct function<R(P1)> : function_base<R, storage1<P1> >
 	//---------------------支援一般函式---------------------start
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 	//---------------------支援一般函式---------------------end
@@ -300,21 +1034,20 @@ struct function<R(P1)> : function_base<R, storage1<P1> >
 	function(R(C::*f)(P1))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 	//---------------------支援成員函式---------------------end
@@ -323,40 +1056,64 @@ struct function<R(P1)> : function_base<R, storage1<P1> >
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
+		return *this;
+	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
 		return *this;
 	}
+#endif
 	//---------------------支援bind()---------------------end
 
 	R operator()(P1 p1) const
 	{
-		return pCore->CallFunction(St(p1));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1))));
 	}
 };
 
 /// function的兩個參數版本
 template<typename R, typename P1, typename P2>
-struct function<R(P1, P2)> : function_base<R, storage2<P1, P2> >
+struct function<R(P1, P2)> : function_base<R, typename _functional::call_storage<R(P1, P2)>::type>
 {
 	typedef R (*Fn)(P1,P2);
-	typedef storage2<P1,P2> St;
+	typedef typename _functional::call_storage<R(P1,P2)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -364,60 +1121,83 @@ struct function<R(P1, P2)> : function_base<R, storage2<P1, P2> >
 	function(R(C::*f)(P1,P2))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 		return *this;
 	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+		return *this;
+	}
+#endif
 
 	R operator()(P1 p1, P2 p2) const
 	{
-		return pCore->CallFunction(St(p1, p2));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2))));
 	}
 };
 
 /// function的三個參數版本
 template<typename R, typename P1, typename P2, typename P3>
-struct function<R(P1, P2, P3)> : function_base<R, storage3<P1, P2, P3> >
+struct function<R(P1, P2, P3)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3);
-	typedef storage3<P1,P2,P3> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -425,60 +1205,83 @@ struct function<R(P1, P2, P3)> : function_base<R, storage3<P1, P2, P3> >
 	function(R(C::*f)(P1,P2,P3))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
+		return *this;
+	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
 		return *this;
 	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3))));
 	}
 };
 
 /// function的四個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4>
-struct function<R(P1, P2, P3, P4)> : function_base<R, storage4<P1, P2, P3, P4> >
+struct function<R(P1, P2, P3, P4)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4);
-	typedef storage4<P1,P2,P3,P4> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -486,60 +1289,83 @@ struct function<R(P1, P2, P3, P4)> : function_base<R, storage4<P1, P2, P3, P4> >
 	function(R(C::*f)(P1,P2,P3,P4))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 		return *this;
 	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+		return *this;
+	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4))));
 	}
 };
 
 /// function的五個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
-struct function<R(P1, P2, P3, P4, P5)> : function_base<R, storage5<P1, P2, P3, P4, P5> >
+struct function<R(P1, P2, P3, P4, P5)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4,P5);
-	typedef storage5<P1,P2,P3,P4,P5> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -547,60 +1373,83 @@ struct function<R(P1, P2, P3, P4, P5)> : function_base<R, storage5<P1, P2, P3, P
 	function(R(C::*f)(P1,P2,P3,P4,P5))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4,P5),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4,P5))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
+		return *this;
+	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
 		return *this;
 	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4, p5));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5))));
 	}
 };
 
 /// function的六個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-struct function<R(P1, P2, P3, P4, P5, P6)> : function_base<R, storage6<P1, P2, P3, P4, P5, P6> >
+struct function<R(P1, P2, P3, P4, P5, P6)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4,P5,P6);
-	typedef storage6<P1,P2,P3,P4,P5,P6> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -608,60 +1457,83 @@ struct function<R(P1, P2, P3, P4, P5, P6)> : function_base<R, storage6<P1, P2, P
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4,P5,P6))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
+		return *this;
+	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
 		return *this;
 	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4, p5, p6));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6))));
 	}
 };
 
 /// function的七個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
-struct function<R(P1, P2, P3, P4, P5, P6, P7)> : function_base<R, storage7<P1, P2, P3, P4, P5, P6, P7> >
+struct function<R(P1, P2, P3, P4, P5, P6, P7)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7);
-	typedef storage7<P1,P2,P3,P4,P5,P6,P7> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -669,60 +1541,83 @@ struct function<R(P1, P2, P3, P4, P5, P6, P7)> : function_base<R, storage7<P1, P
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 		return *this;
 	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+		return *this;
+	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4, p5, p6, p7));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7))));
 	}
 };
 
 /// function的八個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
-struct function<R(P1, P2, P3, P4, P5, P6, P7, P8)> : function_base<R, storage8<P1, P2, P3, P4, P5, P6, P7, P8> >
+struct function<R(P1, P2, P3, P4, P5, P6, P7, P8)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7,P8);
-	typedef storage8<P1,P2,P3,P4,P5,P6,P7,P8> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -730,60 +1625,83 @@ struct function<R(P1, P2, P3, P4, P5, P6, P7, P8)> : function_base<R, storage8<P
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
+		return *this;
+	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
 		return *this;
 	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4, p5, p6, p7, p8));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8))));
 	}
 };
 
 /// function的九個參數版本
 template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
-struct function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> : function_base<R, storage9<P1, P2, P3, P4, P5, P6, P7, P8, P9> >
+struct function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> : function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>::type>
 {
 	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7,P8,P9);
-	typedef storage9<P1,P2,P3,P4,P5,P6,P7,P8,P9> St;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8,P9)>::type St;
 	using function_base<R,St>::pCore;
 
 	function(){}
 	function(Fn f)
 	{
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 	}
 	function operator=(Fn f)
 	{
-		delete pCore;
-		pCore = new _functional::core_function<R, St, Fn>(f);
+		this->reset(new _functional::core_function<R, St, Fn>(f));
 		return *this;
 	}
 
@@ -791,47 +1709,71 @@ struct function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> : function_base<R, storag
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 	}
 	template<typename C>
 	function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C* c)
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		pCore->SetObject((void*)(c));
 	}
 	template<typename C>
 	function operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9))
 	{
 		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
-		delete pCore;
-		pCore = new _functional::core_member_function<R, St, F, C>(F(f));
+		this->reset(new _functional::core_member_function<R, St, F, C>(F(f)));
 		return *this;
 	}
 
 	template<typename A,typename B,typename C>
 	function(const bind_t<A,B,C> &b)
 	{
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 	}
 	template<typename A,typename B,typename C>
 	function operator=(const bind_t<A,B,C> &b)
 	{
-		delete pCore;
-		pCore = new _functional::core_bind<bind_t<A,B,C>, St >(b);
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(b));
 		return *this;
 	}
+#ifdef _STD_FUNCTIONAL_CXX11
+	template<typename A,typename B,typename C>
+	function(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+	}
+	template<typename A,typename B,typename C>
+	function& operator=(bind_t<A,B,C> &&b)
+	{
+		this->reset(new _functional::core_bind<bind_t<A,B,C>, St >(std::move(b)));
+		return *this;
+	}
+#endif
 
 	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
 	{
-		return pCore->CallFunction(St(p1, p2, p3, p4, p5, p6, p7, p8, p9));
+		return this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9)));
+	}
+
+	// 結果直接寫進out，回傳大型物件時比operator()少一次複製
+	void invoke_into(typename _functional::into<R>::out_type out, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+	{
+		this->get_core()->CallInto(out, St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9)));
+	}
+
+	// 結果直接建構在p指向的空間上，p必須是還沒有物件、大小與對齊都夠放R的記憶體
+	// 沒有swap()的type在C++98底下用invoke_into()還是會複製一次，用這個才完全不必複製
+	void construct_into(void *p, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+	{
+		new (p) R(this->get_core()->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9))));
 	}
 };
 
 //---------------------------function類別們---------------------------end
 
-}//namespace std
+}//namespace _STD_FUNCTIONAL_NS
 
 
-#endif//__cplusplus > 201100L
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
 #endif//_STD_FUNCTIONAL_HPP_
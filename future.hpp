@@ -0,0 +1,1099 @@
+/**
+ * @file      future.hpp
+ * @brief     實作 promise/future/packaged_task，並加上 then 與 when_all/when_any
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::packaged_task<int(int)> task(&Parse);
+ *     std::future<int> f = task.get_future();
+ *     pool.post(std::bind(&std::packaged_task<int(int)>::operator(), task, 42));  // 複製品共用同一個結果
+ *
+ *     f.then(&Validate)                           // 完成的那個執行緒會直接接著執行Validate
+ *      .then(std::bind(&Store::Save, &store, _1));
+ *
+ *     std::when_all(fs.begin(), fs.end()).then(&AllDone);
+ *     f.get();                                    // 會等到結果出來為止
+ *
+ * C++11以後預設直接用標準庫的<future>，那邊沒有then()、when_all()與when_any()
+ *
+ * future跟promise都只是共用狀態的把手，複製它們只是多一個參考，C++98底下也能自由傳遞
+ * 共用狀態從依type分開的記憶體池取得，then()連同要執行的仿函式只佔一個區塊
+ * 是否完成只看一個無鎖的指標，接上then()與設定結果都不會上鎖
+ * 同一個future可以接好幾個then()，完成後依照接上的順序執行
+ *
+ * 所有promise都被解構卻沒設定結果時，get()會丟出 broken_promise，關掉例外的環境則直接 abort()
+ * 結果只能設定一次，第二次會丟出 promise_already_satisfied，不同執行緒同時設定也只有一個會成功
+ * then()的仿函式丟出例外時，它產生的future會跟broken一樣，get()丟出 broken_promise
+ * R 必須是可以複製的物件或 void，不支援參考
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_FUTURE_HPP_
+#define _STD_FUTURE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <future>
+
+#else
+
+#include <new>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <vector>
+#include <functional.hpp>
+#include <atomic.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace _STD_FUNCTIONAL_NS{
+
+/// 結果還沒設定，所有promise就都不見了
+class broken_promise : public std::exception
+{
+	public:
+
+		virtual const char* what() const throw() { return "broken_promise"; }
+};
+
+/// 同一個結果設定了第二次
+class promise_already_satisfied : public std::exception
+{
+	public:
+
+		virtual const char* what() const throw() { return "promise_already_satisfied"; }
+};
+
+template<typename R> class future;
+template<typename R> class promise;
+
+
+namespace _future{
+
+//------------------------記憶體池------------------------start
+
+inline void relax()
+{
+	#if defined(_WIN32)
+		SwitchToThread();
+	#else
+		sched_yield();
+	#endif
+}
+
+/// 同一種狀態共用的空區塊串列，用極短的自旋鎖保護< 要放進區塊的type >
+template<typename T>
+struct pool
+{
+	enum
+	{
+		max_cached = 1024       // 超過就直接還給系統
+	};
+
+	struct block { block *next; };
+
+	static void* allocate()
+	{
+		lock();
+		block *b = head_;
+
+		if ( b )
+		{
+			head_ = b->next;
+			count_--;
+		}
+
+		unlock();
+		return b ? static_cast<void*>(b) : ::operator new(sizeof(T) > sizeof(block) ? sizeof(T) : sizeof(block));
+	}
+
+	static void deallocate(void *p)
+	{
+		lock();
+
+		if ( count_ < max_cached )
+		{
+			block *b = static_cast<block*>(p);
+			b->next = head_;
+			head_ = b;
+			count_++;
+			p = 0;
+		}
+
+		unlock();
+
+		if ( p ) ::operator delete(p);
+	}
+
+	static inline void lock()   { while ( lock_.exchange(1, memory_order_acquire) ) relax(); }
+	static inline void unlock() { lock_.store(0, memory_order_release); }
+
+	static atomic<int>  lock_;
+	static block        *head_;
+	static size_t       count_;
+};
+
+template<typename T> atomic<int>            pool<T>::lock_(0);
+template<typename T> typename pool<T>::block *pool<T>::head_ = 0;
+template<typename T> size_t                 pool<T>::count_ = 0;
+
+// 從記憶體池取得並建構T
+template<typename T>
+inline T* make()
+{
+	return new (pool<T>::allocate()) T();
+}
+
+template<typename T>
+inline void unmake(T *t)
+{
+	t->~T();
+	pool<T>::deallocate(t);
+}
+
+//------------------------記憶體池------------------------end
+
+/// 讓等待結果的執行緒睡覺用
+class event
+{
+	public:
+
+	#if defined(_WIN32)
+		event():set_(false)         { InitializeCriticalSection(&m_); InitializeConditionVariable(&c_); }
+		~event()                    { DeleteCriticalSection(&m_); }
+
+		void set()
+		{
+			EnterCriticalSection(&m_);
+			set_ = true;
+			WakeAllConditionVariable(&c_);
+			LeaveCriticalSection(&m_);
+		}
+
+		void wait()
+		{
+			EnterCriticalSection(&m_);
+			while ( !set_ ) SleepConditionVariableCS(&c_, &m_, INFINITE);
+			LeaveCriticalSection(&m_);
+		}
+	#else
+		event():set_(false)         { pthread_mutex_init(&m_,0); pthread_cond_init(&c_,0); }
+		~event()                    { pthread_cond_destroy(&c_); pthread_mutex_destroy(&m_); }
+
+		void set()
+		{
+			pthread_mutex_lock(&m_);
+			set_ = true;
+			pthread_cond_broadcast(&c_);
+			pthread_mutex_unlock(&m_);
+		}
+
+		void wait()
+		{
+			pthread_mutex_lock(&m_);
+			while ( !set_ ) pthread_cond_wait(&c_, &m_);
+			pthread_mutex_unlock(&m_);
+		}
+	#endif
+
+	private:
+
+		event(const event&);
+		event& operator=(const event&);
+
+	#if defined(_WIN32)
+		CRITICAL_SECTION    m_;
+		CONDITION_VARIABLE  c_;
+	#else
+		pthread_mutex_t     m_;
+		pthread_cond_t      c_;
+	#endif
+		bool                set_;
+};
+
+/// 等結果出來才要執行的東西，串成一條只會往前接的串列
+struct continuation
+{
+	continuation():next(0){}
+	virtual ~continuation(){}
+
+	virtual void run() = 0;     // 結果出來時由完成的執行緒呼叫，只會呼叫一次
+
+	continuation    *next;
+};
+
+// 串列被關上的記號，看到它就代表結果已經出來了
+inline continuation* closed()
+{
+	static char tag;
+	return reinterpret_cast<continuation*>(&tag);
+}
+
+/// 共用狀態中跟結果type無關的部份
+struct state_base
+{
+	state_base():refs_(1),owners_(0),head_(0),claimed_(0),broken_(false){}
+	virtual ~state_base(){}
+
+	virtual void destroy() = 0;     // 還給自己的記憶體池
+
+	inline void add_ref() { refs_.fetch_add(1); }
+
+	inline void release()
+	{
+		if ( refs_.fetch_sub(1)==1 ) destroy();
+	}
+
+	// promise的數量，最後一個消失時還沒有結果就當作broken
+	inline void add_owner() { owners_.fetch_add(1); add_ref(); }
+
+	inline void release_owner()
+	{
+		if ( owners_.fetch_sub(1)==1 && try_claim() ) finish(true);
+		release();
+	}
+
+	inline bool ready() const
+	{
+		return head_.load(memory_order_acquire)==closed();
+	}
+
+	// 接上c，已經完成的話就直接在目前的執行緒執行
+	void attach(continuation *c)
+	{
+		continuation *h = head_.load(memory_order_acquire);
+
+		while ( h!=closed() )
+		{
+			c->next = h;
+
+			if ( head_.compare_exchange_weak(h, c, memory_order_acq_rel) ) return;
+		}
+
+		c->run();
+	}
+
+	// 關上串列，並依照接上的順序執行所有continuation
+	void finish(bool broken)
+	{
+		broken_ = broken;       // 結果要在關上之前寫好
+		continuation *h = head_.exchange(closed(), memory_order_acq_rel);
+		continuation *r = 0;
+
+		while ( h )             // 串列是後接的在前面，先翻過來
+		{
+			continuation *n = h->next;
+			h->next = r;
+			r = h;
+			h = n;
+		}
+
+		while ( r )
+		{
+			continuation *n = r->next;      // run()之後r可能就不存在了
+			r->run();
+			r = n;
+		}
+	}
+
+	void wait()
+	{
+		if ( ready() ) return;
+
+		waiter w;
+		attach(&w);
+		w.ev.wait();
+	}
+
+	inline void check() const
+	{
+		if ( broken_ ) _STD_FUNCTIONAL_THROW(broken_promise());
+	}
+
+	// 搶到的那一個才能建構結果並呼叫finish()，兩個執行緒同時設定也只會有一個成功
+	inline bool try_claim()
+	{
+		return claimed_.exchange(1, memory_order_acq_rel)==0;
+	}
+
+	inline void claim()
+	{
+		if ( !try_claim() ) _STD_FUNCTIONAL_THROW(promise_already_satisfied());
+	}
+
+	/// 建構結果時丟出例外就把設定的權利還回去，跟沒設定過一樣
+	struct claim_guard
+	{
+		explicit claim_guard(state_base *s):st(s){ st->claim(); }
+		~claim_guard() { if ( st ) st->claimed_.store(0, memory_order_release); }
+
+		inline void commit() { st = 0; }
+
+		state_base  *st;
+	};
+
+	struct waiter : continuation
+	{
+		virtual void run() { ev.set(); }
+
+		event   ev;
+	};
+
+	atomic<long>            refs_;      // future、promise與還沒執行的continuation各算一個
+	atomic<long>            owners_;
+	atomic<continuation*>   head_;
+	atomic<int>             claimed_;   // 已經有人在設定結果
+	bool                    broken_;
+
+	private:
+
+		state_base(const state_base&);
+		state_base& operator=(const state_base&);
+};
+
+/// 放結果的共用狀態< 結果的type >
+template<typename R>
+struct state : state_base
+{
+	state():has_(false){}
+
+	~state()
+	{
+		if ( has_ ) value().~R();
+	}
+
+	inline const R& value() const { return *reinterpret_cast<const R*>(buf_.c); }
+	inline       R& value()       { return *reinterpret_cast<R*>(buf_.c); }
+
+	void set_value(const R &v)
+	{
+		claim_guard g(this);
+		new (buf_.c) R(v);
+		g.commit();
+		has_ = true;
+		finish(false);
+	}
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	void set_value(R &&v)
+	{
+		claim_guard g(this);
+		new (buf_.c) R(std::move(v));
+		g.commit();
+		has_ = true;
+		finish(false);
+	}
+#endif
+
+	// 用storage裡的參數呼叫f，結果直接建構在狀態裡面
+	template<typename S, typename F>
+	void set_from(const S &s, F &f)
+	{
+		claim_guard g(this);
+		new (buf_.c) R(s.Do(type<R>(), f));
+		g.commit();
+		has_ = true;
+		finish(false);
+	}
+
+	union
+	{
+		_functional::max_align  align;
+		char                    c[sizeof(R)];
+	} buf_;
+
+	bool    has_;
+};
+
+template<>
+struct state<void> : state_base
+{
+	inline void value() const {}
+
+	void set_value()
+	{
+		claim();
+		finish(false);
+	}
+
+	template<typename S, typename F>
+	void set_from(const S &s, F &f)
+	{
+		claim_guard g(this);
+		s.Do(type<void>(), f);
+		g.commit();
+		finish(false);
+	}
+};
+
+/// promise與packaged_task用的狀態
+template<typename R>
+struct promise_state : state<R>
+{
+	virtual void destroy() { unmake(this); }
+};
+
+/// 把來源的結果當作參數交給then()的仿函式
+template<typename R>
+struct arg_storage
+{
+	typedef storage1<const R&> type;
+
+	static inline type make(const state<R> &s) { return type(s.value()); }
+};
+
+template<>
+struct arg_storage<void>
+{
+	typedef storage0 type;
+
+	static inline type make(const state<void>&) { return type(); }
+};
+
+/// then()產生的狀態，仿函式跟continuation都住在裡面< then的結果 , 來源的結果 , 仿函式 >
+template<typename U, typename R, typename F>
+struct then_state : state<U>, continuation
+{
+	then_state():src(0),fn(0){}
+
+	virtual void destroy() { unmake(this); }
+
+	virtual void run()
+	{
+		if ( src->broken_ )
+		{
+			this->finish(true);         // 上游壞掉了，下游也跟著壞
+		}
+		else
+		{
+			call();
+		}
+
+		fn->~F();
+		fn = 0;
+		src->release();
+		src = 0;
+		this->release();                // continuation拿著的那份參考
+	}
+
+	// 例外不能往外丟，不然finish()的迴圈會停在一半，其他continuation永遠不會執行
+	void call()
+	{
+	#ifdef _STD_FUNCTIONAL_EXCEPTIONS
+		try
+		{
+			this->set_from(arg_storage<R>::make(*src), *fn);
+		}
+		catch (...)
+		{
+			if ( this->try_claim() ) this->finish(true);  // 仿函式丟出例外，當作壞掉
+		}
+	#else
+		this->set_from(arg_storage<R>::make(*src), *fn);
+	#endif
+	}
+
+	state<R>    *src;
+	F           *fn;
+
+	union
+	{
+		_functional::max_align  align;
+		char                    c[sizeof(F)];
+	} f_;
+};
+
+/// when_all()產生的狀態
+struct all_state : state<void>
+{
+	struct node : continuation
+	{
+		node():owner(0){}
+
+		virtual void run() { owner->arrive(); }
+
+		all_state   *owner;
+	};
+
+	all_state():left_(0){}
+
+	virtual void destroy() { unmake(this); }
+
+	// 每個來源完成時呼叫一次，最後一個負責設定結果
+	void arrive()
+	{
+		if ( left_.fetch_sub(1)==1 )
+		{
+			set_value();
+			release();
+		}
+	}
+
+	std::vector<node>   nodes_;
+	atomic<long>        left_;
+};
+
+/// when_any()產生的狀態，結果是最先完成的那個的位置
+struct any_state : state<size_t>
+{
+	struct node : continuation
+	{
+		node():owner(0),index(0){}
+
+		virtual void run() { owner->arrive(index); }
+
+		any_state   *owner;
+		size_t      index;
+	};
+
+	any_state():left_(0),won_(0){}
+
+	virtual void destroy() { unmake(this); }
+
+	void arrive(size_t i)
+	{
+		if ( won_.exchange(1)==0 ) set_value(i);
+		if ( left_.fetch_sub(1)==1 ) release();     // 其他node都跑完才能放掉
+	}
+
+	std::vector<node>   nodes_;
+	atomic<long>        left_;
+	atomic<int>         won_;
+};
+
+/// 從仿函式取得then()的結果type
+template<typename F> struct result_of
+{
+	typedef typename untie_ref<typename F::result_type>::type type;
+};
+
+template<typename U>
+struct result_of<U (*)()>
+{
+	typedef typename untie_ref<U>::type type;
+};
+
+template<typename U, typename A>
+struct result_of<U (*)(A)>
+{
+	typedef typename untie_ref<U>::type type;
+};
+
+/// 讓when_all()這類工具碰得到future裡面的狀態
+struct access
+{
+	template<typename R>
+	static inline state<R>* get(const future<R> &f) { return f.st_; }
+
+	template<typename R>
+	static inline future<R> adopt(state<R> *s) { return future<R>(s); }
+};
+
+}//namespace _future
+
+
+namespace _future{
+
+/// future共用的部份，只是共用狀態的參考計數把手< 結果的type >
+template<typename R>
+class handle
+{
+	public:
+
+		typedef R value_type;
+
+		handle():st_(0){}
+		handle(const handle &h):st_(h.st_) { if ( st_ ) st_->add_ref(); }
+		~handle() { if ( st_ ) st_->release(); }
+
+		handle& operator=(const handle &h)
+		{
+			if ( h.st_ ) h.st_->add_ref();
+			if ( st_ )   st_->release();
+			st_ = h.st_;
+			return *this;
+		}
+
+		/// 有沒有連到共用狀態
+		inline bool valid() const { return st_!=0; }
+
+		/// 結果出來了沒，不會等待
+		inline bool is_ready() const { return st_->ready(); }
+
+		/// 等到結果出來
+		inline void wait() const { st_->wait(); }
+
+		/// 結果出來後在完成的執行緒上執行f(結果)，並取得f的結果
+		/// f可以是函式指標、bind()的回傳值或function，R是void時f不收參數
+		/// 如果已經有結果，f會直接在目前的執行緒執行
+		template<typename F>
+		future<typename result_of<F>::type> then(const F &f) const
+		{
+			typedef typename result_of<F>::type U;
+			typedef then_state<U,R,F> T;
+
+			T *t = make<T>();
+			t->fn  = new (t->f_.c) F(f);    // 仿函式跟狀態住在同一個區塊
+			t->src = st_;
+			st_->add_ref();
+			t->add_ref();                   // 給continuation用的
+			st_->attach(t);
+			return access::adopt<U>(t);
+		}
+
+	protected:
+
+		friend struct access;
+
+		explicit handle(state<R> *s):st_(s){}     // 接收已經加過的參考
+
+		state<R>    *st_;
+};
+
+}//namespace _future
+
+
+/// 取得非同步結果的把手< 結果的type >
+template<typename R>
+class future : public _future::handle<R>
+{
+	public:
+
+		future(){}
+
+		/// 等到結果出來並取得結果
+		inline const R& get() const
+		{
+			this->st_->wait();
+			this->st_->check();
+			return this->st_->value();
+		}
+
+	private:
+
+		friend struct _future::access;
+
+		explicit future(_future::state<R> *s):_future::handle<R>(s){}
+};
+
+/// 沒有結果的版本
+template<>
+class future<void> : public _future::handle<void>
+{
+	public:
+
+		future(){}
+
+		/// 等到完成
+		inline void get() const
+		{
+			st_->wait();
+			st_->check();
+		}
+
+	private:
+
+		friend struct _future::access;
+
+		explicit future(_future::state<void> *s):_future::handle<void>(s){}
+};
+
+
+namespace _future{
+
+/// promise共用的部份< 結果的type >
+template<typename R>
+class promise_base
+{
+	public:
+
+		promise_base():st_(make< promise_state<R> >())
+		{
+			st_->owners_.store(1);
+		}
+
+		promise_base(const promise_base &p):st_(p.st_) { st_->add_owner(); }
+		~promise_base() { st_->release_owner(); }
+
+		promise_base& operator=(const promise_base &p)
+		{
+			p.st_->add_owner();
+			st_->release_owner();
+			st_ = p.st_;
+			return *this;
+		}
+
+		/// 取得對應的future，可以取很多次
+		inline future<R> get_future() const
+		{
+			st_->add_ref();
+			return access::adopt<R>(st_);
+		}
+
+	protected:
+
+		state<R>    *st_;
+};
+
+}//namespace _future
+
+
+/// 設定非同步結果的把手，複製品共用同一個結果< 結果的type >
+template<typename R>
+class promise : public _future::promise_base<R>
+{
+	public:
+
+		/// 設定結果並執行所有then()，只能設定一次
+		inline void set_value(const R &v) { this->st_->set_value(v); }
+
+#ifdef _STD_FUNCTIONAL_CXX11
+		inline void set_value(R &&v) { this->st_->set_value(std::move(v)); }
+#endif
+
+		// 給packaged_task用，結果直接建構在共用狀態裡
+		template<typename S, typename F>
+		inline void set_from(const S &s, F &f) { this->st_->set_from(s, f); }
+};
+
+/// 沒有結果的版本
+template<>
+class promise<void> : public _future::promise_base<void>
+{
+	public:
+
+		inline void set_value() { st_->set_value(); }
+
+		template<typename S, typename F>
+		inline void set_from(const S &s, F &f) { st_->set_from(s, f); }
+};
+
+
+/// 直接做出已經有結果的future
+template<typename R>
+inline future<R> make_ready_future(const R &v)
+{
+	promise<R> p;
+	p.set_value(v);
+	return p.get_future();
+}
+
+inline future<void> make_ready_future()
+{
+	promise<void> p;
+	p.set_value();
+	return p.get_future();
+}
+
+
+/// 範圍內的future全部完成時完成，結果請從原本的future取得
+/// 空的範圍會直接完成
+template<typename I>
+inline future<void> when_all(I first, I last)
+{
+	_future::all_state *s = _future::make<_future::all_state>();
+	s->nodes_.resize(size_t(std::distance(first, last)));
+
+	if ( s->nodes_.empty() )
+	{
+		s->set_value();
+		return _future::access::adopt<void>(s);
+	}
+
+	s->left_.store(long(s->nodes_.size()));
+	s->add_ref();                       // 所有node共用的那份參考
+
+	for ( size_t i=0 ; first!=last ; ++first, ++i )
+	{
+		s->nodes_[i].owner = s;
+		_future::access::get(*first)->attach(&s->nodes_[i]);
+	}
+
+	return _future::access::adopt<void>(s);
+}
+
+/// 兩個future都完成時完成
+template<typename A, typename B>
+inline future<void> when_all(const future<A> &a, const future<B> &b)
+{
+	_future::all_state *s = _future::make<_future::all_state>();
+	s->nodes_.resize(2);
+	s->left_.store(2);
+	s->add_ref();
+	s->nodes_[0].owner = s;
+	s->nodes_[1].owner = s;
+	_future::access::get(a)->attach(&s->nodes_[0]);
+	_future::access::get(b)->attach(&s->nodes_[1]);
+	return _future::access::adopt<void>(s);
+}
+
+/// 範圍內任何一個future完成時完成，結果是它在範圍裡的位置
+/// 空的範圍會直接完成，結果是size_t(-1)
+template<typename I>
+inline future<size_t> when_any(I first, I last)
+{
+	_future::any_state *s = _future::make<_future::any_state>();
+	s->nodes_.resize(size_t(std::distance(first, last)));
+
+	if ( s->nodes_.empty() )
+	{
+		s->set_value(size_t(-1));
+		return _future::access::adopt<size_t>(s);
+	}
+
+	s->left_.store(long(s->nodes_.size()));
+	s->add_ref();
+
+	for ( size_t i=0 ; first!=last ; ++first, ++i )
+	{
+		s->nodes_[i].owner = s;
+		s->nodes_[i].index = i;
+		_future::access::get(*first)->attach(&s->nodes_[i]);
+	}
+
+	return _future::access::adopt<size_t>(s);
+}
+
+
+/// 把函式包裝成會把結果交給future的工作，複製品共用同一個結果< 函式簽名 >
+template<typename Sig> class packaged_task;
+
+namespace _future{
+
+/// packaged_task共用的部份< 結果的type , 函式簽名 >
+template<typename R, typename Sig>
+struct task_base
+{
+	task_base(){}
+
+	template<typename F>
+	explicit task_base(const F &f):f_(f){}
+
+	/// 有沒有要執行的函式
+	inline bool valid() const { return !!f_; }
+
+	inline future<R> get_future() const { return p_.get_future(); }
+
+	function<Sig>       f_;
+	mutable promise<R>  p_;     // 只是共用狀態的把手，const的operator()也能設定結果
+};
+
+}//namespace _future
+
+/// packaged_task的零個參數版本
+template<typename R>
+class packaged_task<R()> : public _future::task_base<R, R()>
+{
+	public:
+
+		typedef typename _functional::call_storage<R()>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R()>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()() const
+		{
+			this->p_.set_from(St(), this->f_);
+		}
+};
+
+/// packaged_task的一個參數版本
+template<typename R, typename P1>
+class packaged_task<R(P1)> : public _future::task_base<R, R(P1)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1)), this->f_);
+		}
+};
+
+/// packaged_task的兩個參數版本
+template<typename R, typename P1, typename P2>
+class packaged_task<R(P1, P2)> : public _future::task_base<R, R(P1, P2)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2)), this->f_);
+		}
+};
+
+/// packaged_task的三個參數版本
+template<typename R, typename P1, typename P2, typename P3>
+class packaged_task<R(P1, P2, P3)> : public _future::task_base<R, R(P1, P2, P3)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3)), this->f_);
+		}
+};
+
+/// packaged_task的四個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4>
+class packaged_task<R(P1, P2, P3, P4)> : public _future::task_base<R, R(P1, P2, P3, P4)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4)), this->f_);
+		}
+};
+
+/// packaged_task的五個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
+class packaged_task<R(P1, P2, P3, P4, P5)> : public _future::task_base<R, R(P1, P2, P3, P4, P5)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4, P5)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4, P5)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5)), this->f_);
+		}
+};
+
+/// packaged_task的六個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+class packaged_task<R(P1, P2, P3, P4, P5, P6)> : public _future::task_base<R, R(P1, P2, P3, P4, P5, P6)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4, P5, P6)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6)), this->f_);
+		}
+};
+
+/// packaged_task的七個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+class packaged_task<R(P1, P2, P3, P4, P5, P6, P7)> : public _future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7)), this->f_);
+		}
+};
+
+/// packaged_task的八個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+class packaged_task<R(P1, P2, P3, P4, P5, P6, P7, P8)> : public _future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7, P8)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7, P8)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8)), this->f_);
+		}
+};
+
+/// packaged_task的九個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+class packaged_task<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> : public _future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>
+{
+	public:
+
+		typedef typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>::type St;
+
+		packaged_task(){}
+
+		template<typename F>
+		explicit packaged_task(const F &f):_future::task_base<R, R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>(f){}
+
+		/// 執行函式並設定結果，只能執行一次
+		void operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+		{
+			this->p_.set_from(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9)), this->f_);
+		}
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_FUTURE_HPP_
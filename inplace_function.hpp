@@ -0,0 +1,764 @@
+/**
+ * @file      inplace_function.hpp
+ * @brief     容量固定、永遠不會配置記憶體的 function
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法跟 function 一樣，只是多了一個容量參數:
+ *     std::inplace_function<void(int), 48> f = std::bind(&Foo::OnTick, &foo, _1);
+ *
+ * 核心物件(core_function/core_member_function/core_bind)直接建構在內部的緩衝區裡
+ * 複製時也只是把核心複製到另一個物件的緩衝區，整個過程不會碰到heap
+ * 目標放不進Capacity個位元組的話會在編譯期失敗，而不是偷偷改用heap
+ * 呼叫空的 inplace_function 跟 function 一樣會丟出 bad_function_call
+ * C++11底下可以移動，核心跟綁定的參數會被搬到另一個物件的緩衝區，被移走的一方變成空的
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_INPLACE_FUNCTION_HPP_
+#define _STD_INPLACE_FUNCTION_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+namespace _inplace{
+
+// 編譯期檢查用，只有true的版本有定義
+template<bool B> struct target_must_fit;
+template<>       struct target_must_fit<true>{};
+
+}//namespace _inplace
+
+/// 所有inplace_function的共同基底< 函式回傳值的型態 , storage的種類 , 緩衝區大小 >
+template<typename R, typename S, size_t N> struct inplace_function_base
+{
+	typedef R result_type;
+	typedef _functional::core_base<R,S> core;
+
+	inplace_function_base():pCore(empty()){}
+	~inplace_function_base(){ reset(); }
+
+	inplace_function_base(const inplace_function_base &other):pCore(empty())
+	{
+		if ( other )
+		{
+			pCore = other.pCore->clone_to(&store_);
+		}
+	}
+
+	inplace_function_base& operator=(const inplace_function_base &other)
+	{
+		if ( this != &other )
+		{
+			reset();
+
+			if ( other )
+			{
+				pCore = other.pCore->clone_to(&store_);
+			}
+		}
+
+		return *this;
+	}
+
+#ifdef _STD_FUNCTIONAL_CXX11
+	// 核心沒辦法整個交出去，只能就地搬到這邊的緩衝區，被移走的一方會變成空的
+	inplace_function_base(inplace_function_base &&other):pCore(empty())
+	{
+		if ( other )
+		{
+			pCore = other.pCore->move_to(&store_);
+			other.reset();
+		}
+	}
+
+	inplace_function_base& operator=(inplace_function_base &&other)
+	{
+		if ( this != &other )
+		{
+			reset();
+
+			if ( other )
+			{
+				pCore = other.pCore->move_to(&store_);
+				other.reset();
+			}
+		}
+
+		return *this;
+	}
+#endif
+
+	operator bool () const
+	{
+		return pCore != empty();
+	}
+
+	// 用來輸入物件指標
+	template<typename C>
+	inline void set(C* c)
+	{
+		pCore->SetObject((void*)(c));
+	}
+
+	// 跟function共用空的核心，呼叫時一樣丟出bad_function_call
+	static inline core* empty()
+	{
+		return &_functional::core_empty<R,S>::instance;
+	}
+
+	// 清空內容，核心物件就地解構
+	inline void reset()
+	{
+		if ( pCore != empty() )
+		{
+			pCore->~core();
+			pCore = empty();
+		}
+	}
+
+	// 把T型態的核心建構在緩衝區裡，T放不下就編譯失敗
+	template<typename T, typename A>
+	inline void create(const A &a)
+	{
+		(void)sizeof(_inplace::target_must_fit<(sizeof(T) <= N)>);
+		reset();
+		pCore = new (&store_) T(a);
+	}
+
+	// 把任意的仿函式(包括function本身)當成目標，同樣直接建構在緩衝區裡< 仿函式type , 建構參數type >
+	template<typename T, typename A>
+	inline T& emplace(const A &a)
+	{
+		typedef _functional::core_functor<R,S,T> C;
+		(void)sizeof(_inplace::target_must_fit<(sizeof(C) <= N)>);
+		reset();
+		C *c = new (&store_) C(_bind::emplace_tag(), a);
+		pCore = c;
+		return c->obj;
+	}
+
+	core    *pCore;     // 指向store_，沒有內容時指向core_empty，operator()不必檢查
+
+	union
+	{
+		char                    buf[N];
+		_functional::max_align  align;
+	}       store_;
+};
+
+
+/// inplace_function的樣板原型，沒有用處，真正有用的是它的偏特化版本
+template<typename S, size_t N = 64> struct inplace_function{};
+
+//---------------------------inplace_function類別們---------------------------start
+
+/// inplace_function的沒有參數版本
+template<typename R, size_t N>
+struct inplace_function<R(), N> : inplace_function_base<R, typename _functional::call_storage<R()>::type, N>
+{
+	typedef R (*Fn)();
+	typedef typename _functional::call_storage<R()>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)())
+	{
+		typedef _functional::member_function<R,R (C::*)(),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)())
+	{
+		typedef _functional::member_function<R,R (C::*)(),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()() const
+	{
+		return pCore->CallFunction(St());
+	}
+};
+
+/// inplace_function的一個參數版本
+template<typename R, typename P1, size_t N>
+struct inplace_function<R(P1), N> : inplace_function_base<R, typename _functional::call_storage<R(P1)>::type, N>
+{
+	typedef R (*Fn)(P1);
+	typedef typename _functional::call_storage<R(P1)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1)));
+	}
+};
+
+/// inplace_function的兩個參數版本
+template<typename R, typename P1, typename P2, size_t N>
+struct inplace_function<R(P1, P2), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2)>::type, N>
+{
+	typedef R (*Fn)(P1,P2);
+	typedef typename _functional::call_storage<R(P1,P2)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2)));
+	}
+};
+
+/// inplace_function的三個參數版本
+template<typename R, typename P1, typename P2, typename P3, size_t N>
+struct inplace_function<R(P1, P2, P3), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3);
+	typedef typename _functional::call_storage<R(P1,P2,P3)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3)));
+	}
+};
+
+/// inplace_function的四個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, size_t N>
+struct inplace_function<R(P1, P2, P3, P4), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4)));
+	}
+};
+
+/// inplace_function的五個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, size_t N>
+struct inplace_function<R(P1, P2, P3, P4, P5), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4,P5);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4,P5))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5)));
+	}
+};
+
+/// inplace_function的六個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, size_t N>
+struct inplace_function<R(P1, P2, P3, P4, P5, P6), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4,P5,P6);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4,P5,P6))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6)));
+	}
+};
+
+/// inplace_function的七個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, size_t N>
+struct inplace_function<R(P1, P2, P3, P4, P5, P6, P7), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7)));
+	}
+};
+
+/// inplace_function的八個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, size_t N>
+struct inplace_function<R(P1, P2, P3, P4, P5, P6, P7, P8), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7,P8);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8)));
+	}
+};
+
+/// inplace_function的九個參數版本
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, size_t N>
+struct inplace_function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9), N> : inplace_function_base<R, typename _functional::call_storage<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>::type, N>
+{
+	typedef R (*Fn)(P1,P2,P3,P4,P5,P6,P7,P8,P9);
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8,P9)>::type St;
+	typedef inplace_function_base<R, St, N> base;
+	using base::pCore;
+
+	inplace_function(){}
+	inplace_function(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+	}
+	inplace_function& operator=(Fn f)
+	{
+		this->template create< _functional::core_function<R, St, Fn> >(f);
+		return *this;
+	}
+
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+	}
+	template<typename C>
+	inplace_function(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C* c)
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		pCore->SetObject((void*)(c));
+	}
+	template<typename C>
+	inplace_function& operator=(R(C::*f)(P1,P2,P3,P4,P5,P6,P7,P8,P9))
+	{
+		typedef _functional::member_function<R,R (C::*)(P1,P2,P3,P4,P5,P6,P7,P8,P9),C> F;
+		this->template create< _functional::core_member_function<R, St, F, C> >(F(f));
+		return *this;
+	}
+
+	template<typename A,typename B,typename C>
+	inplace_function(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+	}
+	template<typename A,typename B,typename C>
+	inplace_function& operator=(const bind_t<A,B,C> &b)
+	{
+		this->template create< _functional::core_bind<bind_t<A,B,C>, St> >(b);
+		return *this;
+	}
+
+	R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+	{
+		return pCore->CallFunction(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9)));
+	}
+};
+//---------------------------inplace_function類別們---------------------------end
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_INPLACE_FUNCTION_HPP_
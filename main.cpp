@@ -1,17 +1,1598 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <errno.h>
+#include <dlfcn.h>
+#endif
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+// C++11以後一樣要測這裡自己的實作，不要換成標準庫
+#if __cplusplus > 201100L
+#define FUNCTIONAL_OWN_IMPLEMENTATION
+#include <memory>
+#include <utility>
+#include <type_traits>
+#endif
+
 #include <functional.hpp>
+#include <inplace_function.hpp>
+#include <variant_function.hpp>
+#include <callback_store.hpp>
+#include <reactor.hpp>
+#include <future.hpp>
+#include <fiber.hpp>
+#include <task_graph.hpp>
+#include <parallel.hpp>
+#include <pipeline.hpp>
+#include <deadline_executor.hpp>
+#include <strand.hpp>
+#include <frame_runner.hpp>
+#include <debounce.hpp>
+#include <async_logger.hpp>
+#include <memoize.hpp>
+#include <range.hpp>
+#include <trampoline.hpp>
+#if defined(__linux__)
+#include <async_io.hpp>
+#include <affinity_executor.hpp>
+#endif
+
+// C++98底下所有東西都放在std裡面，統一用functional::來寫
+#ifndef _STD_FUNCTIONAL_CXX11
+namespace functional = std;
+#endif
+
+static int failures = 0;
+
+// Release會定義NDEBUG，不能用assert()
+#define CHECK(x) do{ if ( !(x) ){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); failures++; } }while(0)
+
+//------------------------讓執行緒建不起來------------------------
 
-void MyFunction(int a)
+#if defined(__linux__) && defined(__GLIBC__)
+#define HAVE_FAIL_THREADS
+
+static int threads_ok   = 0;    // 接下來還有幾次pthread_create()照常成功
+static int threads_fail = 0;    // 那之後要失敗幾次
+
+// 先讓ok條執行緒照常建立，接著的fail次都失敗，之後恢復正常
+static void FailThreads(int ok, int fail)
 {
-	printf("%d\n",a);
+	threads_ok   = ok;
+	threads_fail = fail;
 }
 
-int main()
+// 蓋掉libc的pthread_create()，測試執行緒建不起來時的處理
+extern "C" int pthread_create(pthread_t *t, const pthread_attr_t *attr, void *(*f)(void*), void *arg) __THROWNL
 {
-	using namespace std::placeholders;  // for std::placeholders::_1
+	typedef int (*Real)(pthread_t*, const pthread_attr_t*, void *(*)(void*), void*);
 
-	std::function<void(int)>     func=std::bind(&MyFunction,_1);
-	func(5);
+	static Real real = 0;
+
+	if ( !real )
+	{
+		void *sym = dlsym(RTLD_NEXT, "pthread_create");
+		memcpy(&real, &sym, sizeof(real));      // 物件指標不能直接轉成函式指標
+	}
+
+	if ( threads_ok > 0 )
+	{
+		threads_ok--;
+	}
+	else if ( threads_fail > 0 )
+	{
+		threads_fail--;
+		return EAGAIN;
+	}
+
+	return real(t, attr, f, arg);
+}
+#endif
+
+void MyFunction(int a){ printf("%d\n",a); }
+
+static void Nothing(){}
+static int Twice(int a){ return a*2; }
+static int AddOne(int a){ return a+1; }
+static int Throw(int a){ throw a; }
+static void Collect(std::vector<int> *out, int v){ out->push_back(v); }
+
+//------------------------function------------------------
+
+// 呼叫空的f要丟出bad_function_call
+template<typename F>
+static bool ThrowsWhenEmpty(const F &f)
+{
+	try { f(1); } catch ( const functional::bad_function_call& ) { return true; }
+	return false;
+}
+
+static void TestEmptyCall()
+{
+	functional::function<int(int)> f;
+	CHECK( !f && ThrowsWhenEmpty(f) );
+
+	functional::inplace_function<int(int), 32> g;
+	CHECK( !g && ThrowsWhenEmpty(g) );
+
+	g = &Twice;
+	CHECK( g && g(4)==8 );
+
+	functional::inplace_function<int(int), 32> h = g;
+	g.reset();
+	CHECK( !g && ThrowsWhenEmpty(g) );
+	CHECK( h(5)==10 );
+
+	h = g;                                                           // 複製空的也是空的
+	CHECK( !h && ThrowsWhenEmpty(h) );
+
+	functional::variant_function<int(int), int(*)(int)> v;
+	CHECK( !v && ThrowsWhenEmpty(v) );
+
+	v = &Twice;
+	CHECK( v && v(6)==12 );
+}
+
+//------------------------invoke_into------------------------
+
+// 數一數被複製了幾次，搬移不算
+template<bool Swappable>
+struct Counted
+{
+	Counted():v(0){}
+	explicit Counted(int a):v(a){}
+	Counted(const Counted &o):v(o.v)            { copies++; }
+	Counted& operator=(const Counted &o)        { v = o.v; copies++; return *this; }
+#ifdef _STD_FUNCTIONAL_CXX11
+	Counted(Counted &&o):v(o.v){}
+	Counted& operator=(Counted &&o)             { v = o.v; return *this; }
+#endif
+
+	int         v;
+	char        payload[512];
+
+	static int  copies;
+};
+
+template<bool Swappable> int Counted<Swappable>::copies = 0;
+
+// 有swap()成員的版本，C++98的invoke_into()會用它把結果交出去
+struct Row : Counted<true>
+{
+	Row(){}
+	explicit Row(int a):Counted<true>(a){}
+
+	void swap(Row &o){ int t = v; v = o.v; o.v = t; }
+};
+
+typedef Counted<false> Plain;
+
+static Row   MakeRow(int a)  { return Row(a); }
+static Plain MakePlain(int a){ return Plain(a); }
+
+// 還沒有物件的空間，給construct_into()用
+template<typename T>
+union Raw
+{
+	functional::_functional::max_align  align;
+	char                                c[sizeof(T)];
+
+	T* get(){ return reinterpret_cast<T*>(c); }
+};
+
+static void TestInvokeInto()
+{
+	using namespace functional::placeholders;
+
+	functional::function<Row(int)> rows[2] = { &MakeRow, functional::bind(&MakeRow, _1) };
+
+	for ( int i=0 ; i<2 ; i++ )
+	{
+		Row out;
+		Row::copies = 0;
+		rows[i].invoke_into(out, 7);
+		CHECK( out.v==7 && Row::copies==0 );                         // C++98用swap()，C++11用搬移
+	}
+
+	functional::function<Plain(int)> plains[2] = { &MakePlain, functional::bind(&MakePlain, _1) };
+
+	for ( int i=0 ; i<2 ; i++ )
+	{
+		Plain out;
+		Plain::copies = 0;
+		out = plains[i](1);
+		int assigned = Plain::copies;
+
+		Plain::copies = 0;
+		plains[i].invoke_into(out, 8);
+		CHECK( out.v==8 && Plain::copies==assigned );                 // 沒有swap()的話跟out = f()一樣
+#ifdef _STD_FUNCTIONAL_CXX11
+		CHECK( Plain::copies==0 );
+#else
+		CHECK( Plain::copies==1 );
+#endif
+
+		Raw<Plain> raw;
+		Plain::copies = 0;
+		plains[i].construct_into(raw.c, 9);
+		CHECK( raw.get()->v==9 && Plain::copies==0 );                // 直接建構在呼叫端的空間上
+		raw.get()->~Plain();
+	}
+}
+
+//------------------------emplace------------------------
+
+static int PlainSum(const Plain &a, const Plain &b, int c){ return a.v+b.v+c; }
+
+// 持有一個Plain的仿函式，給emplace<T>()用
+struct Holder
+{
+	explicit Holder(const Plain &a):p(a){}
+
+	int operator()(int c) const { return p.v+c; }
+
+	Plain   p;
+};
+
+static void TestEmplace()
+{
+	using namespace functional::placeholders;
+
+	Plain a(1), b(2);
+
+	Plain::copies = 0;
+	functional::function<int(int)> f = functional::bind(&PlainSum, a, b, _1);
+	int assigned = Plain::copies;
+	CHECK( f(3)==6 );
+
+	Plain::copies = 0;
+	functional::function<int(int)> g;
+	g.emplace_bind(&PlainSum, a, b, _1);
+	CHECK( g(3)==6 && Plain::copies==2 );                            // 每個綁定的參數只複製一次
+#ifndef _STD_FUNCTIONAL_CXX11
+	CHECK( assigned>Plain::copies );                                  // 先bind()再交給function會多複製幾次
+#else
+	CHECK( assigned>=Plain::copies );
+#endif
+
+	Plain::copies = 0;
+	functional::function<int(int)> k;
+	Holder &obj = k.emplace<Holder>(a);                             // function不收任意的仿函式，只能這樣放進去
+	CHECK( k(4)==5 && Plain::copies==1 );                            // 參數直接交給Holder的建構子
+
+	obj.p.v = 10;                                                    // 回傳的參考就是核心裡的那一個
+	CHECK( k(4)==14 );
+}
+
+//------------------------move------------------------
+
+#ifdef _STD_FUNCTIONAL_CXX11
+static int TakeUnique(std::unique_ptr<int> p){ return *p; }
+static int PlusUnique(std::unique_ptr<int> p, int a){ return *p+a; }
+static int PlainAdd(const Plain &a, int b){ return a.v+b; }
+
+static void TestMove()
+{
+	using namespace functional::placeholders;
+
+	// 只能移動的參數要一路轉發到目標
+	functional::function<int(std::unique_ptr<int>)> f = &TakeUnique;
+	CHECK( f(std::unique_ptr<int>(new int(5)))==5 );
+
+	functional::function<int(std::unique_ptr<int>)> g = functional::bind(&PlusUnique, _1, 2);
+	CHECK( g(std::unique_ptr<int>(new int(5)))==7 );
+
+	functional::inplace_function<int(std::unique_ptr<int>), 64> h = functional::bind(&PlusUnique, _1, 3);
+	CHECK( h(std::unique_ptr<int>(new int(5)))==8 );
+
+	// 被移走的function是空的
+	functional::function<int(int)> a = functional::bind(&Twice, _1);
+	functional::function<int(int)> b = std::move(a);
+	CHECK( !a && ThrowsWhenEmpty(a) && b(3)==6 );
+
+	a = std::move(b);
+	CHECK( !b && a(4)==8 );
+
+	CHECK( std::is_nothrow_move_constructible< functional::function<int(int)> >::value );
+	CHECK( std::is_nothrow_move_assignable< functional::function<int(int)> >::value );
+
+	// inplace_function只能把核心搬到另一個緩衝區，綁定的參數要用移動而不是複製
+	functional::inplace_function<int(int), 1024> x = functional::bind(&PlainAdd, Plain(1), _1);
+	Plain::copies = 0;
+	functional::inplace_function<int(int), 1024> y = std::move(x);
+	CHECK( !x && ThrowsWhenEmpty(x) && y(2)==3 && Plain::copies==0 );
+
+	x = std::move(y);
+	CHECK( !y && x(3)==4 && Plain::copies==0 );
+
+	x = std::move(x);                                                // 移給自己不會把內容弄丟
+	CHECK( x(3)==4 );
+}
+#endif
+
+#ifdef FUNCTIONAL_TELEMETRY
+static void TestTelemetry()
+{
+	// 故意把記憶體弄髒再建構，數字一定要從0開始
+	// 用volatile寫，不然編譯器會當成建構前的無用寫入而省略掉
+	union { functional::_functional::max_align align; char c[sizeof(functional::function_counters)]; } buf;
+	volatile char *dirty = buf.c;
+	for ( size_t i=0 ; i<sizeof(buf.c) ; i++ ) dirty[i] = char(0xAB);
+
+	functional::function_counters *c = new (buf.c) functional::function_counters("fresh");
+
+	CHECK( c->cores_allocated.load()==0 );
+	CHECK( c->clones.load()==0 );
+	CHECK( c->bytes_held.load()==0 );
+	CHECK( c->destroyed.load()==0 );
+	CHECK( c->empty_calls.load()==0 );
+
+	// 三種function呼叫空物件都算進同一個函式簽名的empty_calls
+	typedef functional::_functional::call_storage<int(int)>::type St;
+	functional::function_counters &counters = functional::_functional::telemetry<int, St>::counters();
+	long before = counters.empty_calls.load();
+
+	CHECK( ThrowsWhenEmpty(functional::function<int(int)>()) );
+	CHECK( ThrowsWhenEmpty(functional::inplace_function<int(int)>()) );
+	CHECK( ThrowsWhenEmpty(functional::variant_function<int(int), int(*)(int)>()) );
+	CHECK( counters.empty_calls.load()==before+3 );
+}
+#endif
+
+//------------------------memoize------------------------
+
+static int memo_runs = 0;
+
+static int Square(int a){ memo_runs++; return a*a; }
+
+static int64_t Wide(int64_t a){ memo_runs++; return a/2; }
+
+static long double Half(long double a){ memo_runs++; return a/2; }
+
+// C++98沒有long long，借用memoize.hpp裡同一個type的typedef
+typedef functional::_memoize::long_long  LongLong;
+typedef functional::_memoize::ulong_long ULongLong;
+
+static LongLong Negate(LongLong a, ULongLong b){ memo_runs++; return -a - LongLong(b); }
+
+static void TestMemoize()
+{
+	functional::function<int(int)> fast = functional::memoize(functional::function<int(int)>(&Square), 3);
+
+	memo_runs = 0;
+	CHECK( fast(2)==4 && fast(3)==9 && fast(2)==4 );
+	CHECK( memo_runs==2 );                                           // 兩次沒命中，一次命中
+
+	fast(4);                                                         // 放滿3筆，最新的是4、2、3
+	fast(5);                                                         // 擠掉最久沒用的3
+	memo_runs = 0;
+	fast(2);
+	fast(4);
+	fast(5);
+	CHECK( memo_runs==0 );
+	fast(3);
+	CHECK( memo_runs==1 );                                           // 3已經被擠掉了
+
+	functional::function<int(int)> copy = fast;                      // 複製品共用同一份快取
+	memo_runs = 0;
+	copy(3);
+	CHECK( memo_runs==0 );
+
+	functional::function<int(int)> one = functional::memoize(functional::function<int(int)>(&Square), 1);
+
+	memo_runs = 0;
+	one(7);
+	one(7);
+	CHECK( memo_runs==1 );
+	one(8);                                                          // 容量1，每換一個參數就擠掉上一個
+	one(7);
+	CHECK( memo_runs==3 );
+
+	functional::function<int64_t(int64_t)> wide = functional::memoize(functional::function<int64_t(int64_t)>(&Wide), 8);
+	int64_t big = int64_t(1) << 40;
+
+	memo_runs = 0;
+	CHECK( wide(big)==big/2 && wide(big+1)==big/2 && wide(big)==big/2 );
+	CHECK( memo_runs==2 );
+
+	functional::function<LongLong(LongLong, ULongLong)> neg = functional::memoize(functional::function<LongLong(LongLong, ULongLong)>(&Negate), 8);
+
+	memo_runs = 0;
+	CHECK( neg(LongLong(big), 1)==-LongLong(big)-1 && neg(LongLong(big), 1)==-LongLong(big)-1 );
+	CHECK( memo_runs==1 );
+
+	functional::function<long double(long double)> half = functional::memoize(functional::function<long double(long double)>(&Half), 8);
+
+	memo_runs = 0;
+	CHECK( half(3.0L)==1.5L && half(3.0L)==1.5L && half(-0.0L)==0 && half(0.0L)==0 );
+	CHECK( memo_runs==2 );                                           // 0.0與-0.0算同一個key
+}
+
+//------------------------range------------------------
+
+static int range_maps = 0;
+
+static int  Triple(int a){ range_maps++; return a*3; }
+static bool IsEven(int a){ return a%2==0; }
+static int  Add(int a, int b){ return a+b; }
+static int  Scale(int a, int k){ return a*k; }
+
+// 自己寫的仿函式也可以當階段，map需要result_type
+struct Offset
+{
+	typedef int result_type;
+
+	int operator()(int a) const { return a+base; }
+
+	int base;
+};
+
+struct Above
+{
+	typedef bool result_type;
+
+	bool operator()(int a) const { return a>limit; }
+
+	int limit;
+};
+
+static void TestRange()
+{
+	using namespace functional::placeholders;
+
+	std::vector<int> v;
+	for ( int i=1 ; i<=10 ; i++ ) v.push_back(i);
+
+	CHECK( functional::make_range(v).reduce(0, &Add)==55 );
+	CHECK( functional::make_range(v).count()==10 );
+	CHECK( functional::make_range(v.begin(), v.begin()+4).count()==4 );
+
+	// 3,6,9,...,30裡的偶數是6,12,18,24,30
+	CHECK( functional::make_range(v).map(&Triple).filter(&IsEven).count()==5 );
+	CHECK( functional::make_range(v).map(&Triple).filter(&IsEven).reduce(0, &Add)==90 );
+	CHECK( functional::make_range(v).map(&Triple).filter(&IsEven).take(2).reduce(0, &Add)==18 );
+
+	range_maps = 0;
+	CHECK( functional::make_range(v).map(&Triple).take(3).count()==3 );
+	CHECK( range_maps==3 );                                          // 拿夠了就不再往來源要
+
+	range_maps = 0;
+	CHECK( functional::make_range(v).map(&Triple).take(0).count()==0 );
+	CHECK( range_maps==0 );
+
+	CHECK( functional::make_range(v).take(100).count()==10 );        // 超過的話就是全部
+	CHECK( functional::make_range(v).filter(&IsEven).take(100).reduce(0, &Add)==30 );
+
+	std::vector<int> none;
+	CHECK( functional::make_range(none).map(&Triple).count()==0 );
+	CHECK( functional::make_range(none).reduce(7, &Add)==7 );
+
+	Offset plus100 = { 100 };
+	Above  big     = { 105 };
+	CHECK( functional::make_range(v).map(plus100).filter(big).count()==5 );
+
+	CHECK( functional::make_range(v).map(functional::bind(&Scale, _1, 10)).take(3).reduce(0, &Add)==60 );
+	CHECK( functional::make_range(v).map(functional::function<int(int)>(&Triple)).filter(&IsEven).take(1).reduce(0, &Add)==6 );
+
+	std::vector<int> out;
+	functional::make_range(v).filter(&IsEven).map(functional::bind(&Scale, _1, 2)).copy(std::back_inserter(out));
+	static const int expect[] = { 4, 8, 12, 16, 20 };
+	CHECK( out.size()==5 && std::equal(out.begin(), out.end(), expect) );
+
+	std::vector<int> seen;
+	functional::make_range(v).take(2).for_each(functional::bind(&Collect, &seen, _1));
+	CHECK( seen.size()==2 && seen[0]==1 && seen[1]==2 );
+}
+
+//------------------------trampoline------------------------
+
+static int CompareInts(const void *a, const void *b, bool descending)
+{
+	int x = *static_cast<const int*>(a);
+	int y = *static_cast<const int*>(b);
+	int r = x<y ? -1 : x>y ? 1 : 0;
+	return descending ? -r : r;
+}
+
+// 模仿libuv之類的handle，void*放在data欄位
+struct Handle
+{
+	void    *data;
+	int     id;
+};
+
+static void OnEvent(int *sum, Handle *h, int v){ *sum += h->id*v; }
+
+// 假裝是C函式庫，只認得函式指標跟handle
+static void FireEvent(void (*fn)(Handle*, int), Handle *h, int v){ fn(h, v); }
+
+// bind()的型別寫不出來，靠template推導，target在整個回呼期間都要活著
+template<typename F>
+static void FireTwice(F target)
+{
+	Handle h = { 0, 10 };
+	functional::c_callback_data<void(Handle*, int)> cb(target);
+
+	h.data = cb.ctx;
+	FireEvent(cb.fn, &h, 3);
+	FireEvent(cb.fn, &h, 4);
+}
+
+#if !defined(_WIN32)
+static void* MarkThread(int *flag){ *flag = 1; return flag; }
+#endif
+
+static void TestTrampoline()
+{
+	using namespace functional::placeholders;
+
+#if defined(__GLIBC__)
+	{
+		int v[6] = { 5, 1, 4, 2, 6, 3 };
+		functional::function<int(const void*, const void*)> cmp = functional::bind(&CompareInts, _1, _2, true);
+		functional::c_compare_callback cb(cmp);
+
+		qsort_r(v, 6, sizeof(int), cb.fn, cb.ctx);
+
+		static const int expect[] = { 6, 5, 4, 3, 2, 1 };
+		CHECK( std::equal(v, v+6, expect) );
+	}
+#endif
+
+#if !defined(_WIN32)
+	{
+		int flag = 0;
+		functional::function<void*()> body = functional::bind(&MarkThread, &flag);
+		functional::c_thread_callback cb(body);
+
+		pthread_t t;
+		void *ret = 0;
+		CHECK( pthread_create(&t, 0, cb.fn, cb.ctx)==0 );
+		CHECK( pthread_join(t, &ret)==0 );
+		CHECK( flag==1 && ret==&flag );
+	}
+#endif
+
+	{
+		int sum = 0;
+		FireTwice(functional::bind(&OnEvent, &sum, _1, _2));             // 直接拿bind()的回傳值，不經過function
+		CHECK( sum==70 );
+	}
+}
+
+//------------------------callback_store------------------------
+
+static functional::callback_store<void(int)> *store = 0;
+static int store_sum = 0;
+
+static void Accumulate(int v){ store_sum += v; }
+
+// 在呼叫途中加入很多同一種type的callback，逼陣列重新配置
+static void Grow(int)
+{
+	for ( int i=0 ; i<64 ; i++ ) store->add(&Accumulate);
+}
+
+static void TestCallbackStore()
+{
+	functional::callback_store<void(int)> tick;
+	store = &tick;
+
+	tick.add(&Grow);
+	tick.add(&Accumulate);
+
+	tick(1);
+	CHECK( store_sum==1 );                                           // 這一輪加入的還不會被呼叫
+	CHECK( tick.size()==66 );
+
+	store_sum = 0;
+	tick.clear();
+	tick.add(&Accumulate);
+	tick(2);
+	CHECK( store_sum==2 );
+
+	store = 0;
+}
+
+//------------------------reactor------------------------
+
+#if defined(__linux__)
+// 數一數還有幾份活著，用來確認handler有沒有被釋放
+struct Tracker
+{
+	Tracker()               { live++; }
+	Tracker(const Tracker&) { live++; }
+	~Tracker()              { live--; }
+
+	static int live;
+};
+
+int Tracker::live = 0;
+
+static void ThrowOnReady(const Tracker&, int, unsigned){ throw 1; }
+static void IgnoreReady(const Tracker&, int, unsigned){}
+
+// 分派途中登記一個epoll不收的fd
+static void AddRejected(functional::reactor *r, int bad, int *result, int, unsigned)
+{
+	using namespace functional::placeholders;
+
+	*result = r->add(bad, EPOLLIN, functional::bind(&IgnoreReady, Tracker(), _1, _2)) ? 1 : 0;
+}
+
+static void TestReactor()
+{
+	using namespace functional::placeholders;
+
+	int fds[2];
+	CHECK( pipe(fds)==0 );
+
+	{
+		functional::reactor r;
+		CHECK( r.add(fds[0], EPOLLIN, functional::bind(&ThrowOnReady, Tracker(), _1, _2)) );
+		CHECK( Tracker::live==1 );
+		CHECK( write(fds[1], "x", 1)==1 );
+
+		bool thrown = false;
+		try { r.run_once(1000); } catch ( int ) { thrown = true; }
+		CHECK( thrown );
+
+		CHECK( r.remove(fds[0]) );
+		CHECK( Tracker::live==0 );                                   // handler丟出例外之後，移除時仍會馬上釋放
+	}
+
+	{
+		FILE *file = tmpfile();                                      // 一般檔案不能交給epoll
+		int  result = -1;
+
+		functional::reactor r;
+		CHECK( file && r.add(fds[0], EPOLLIN, functional::bind(&AddRejected, &r, fileno(file), &result, _1, _2)) );
+		CHECK( write(fds[1], "x", 1)==1 );
+		CHECK( r.run_once(1000)==1 );
+		CHECK( result==0 && Tracker::live==0 );                     // 分派途中登記失敗的handler也要在這批結束時釋放
+
+		fclose(file);
+	}
+
+	close(fds[0]);
+	close(fds[1]);
+}
+#endif
+
+//------------------------future------------------------
+
+#if !defined(_WIN32)
+struct Race
+{
+	functional::promise<int>    p;
+	functional::atomic<int>     go;
+	functional::atomic<int>     losers;
+};
+
+static void* RaceSet(void *arg)
+{
+	Race *r = static_cast<Race*>(arg);
+
+	while ( !r->go.load() ) {}
+
+	try { r->p.set_value(1); } catch ( const functional::promise_already_satisfied& ) { r->losers.fetch_add(1); }
 
 	return 0;
 }
+#endif
+
+static void TestFuture()
+{
+	{
+		functional::promise<int> p;
+		functional::future<int> f = p.get_future();
+		functional::future<int> g = f.then(&Twice).then(&AddOne);   // 還沒有結果，先接上去
+
+		CHECK( !g.is_ready() );
+		p.set_value(20);
+		CHECK( f.get()==20 );
+		CHECK( g.get()==41 );
+		CHECK( f.then(&Twice).get()==40 );                           // 已經有結果，直接執行
+	}
+
+	{
+		functional::promise<int> ps[3];                              // vector(3)在C++98是複製同一個，會共用結果
+		std::vector< functional::future<int> > fs;
+
+		for ( size_t i=0 ; i<3 ; i++ ) fs.push_back(ps[i].get_future());
+
+		functional::future<size_t> any = functional::when_any(fs.begin(), fs.end());
+		functional::future<void>   all = functional::when_all(fs.begin(), fs.end());
+
+		CHECK( !any.is_ready() );
+		ps[2].set_value(7);
+		CHECK( any.get()==2 );
+		ps[0].set_value(5);
+		CHECK( any.get()==2 );                                       // 第一個完成的才算
+		CHECK( !all.is_ready() );
+		ps[1].set_value(6);
+		CHECK( all.is_ready() );
+	}
+
+	{
+		functional::future<int> f;
+		functional::future<int> g;
+
+		{
+			functional::promise<int> p;
+			f = p.get_future();
+			g = f.then(&Twice);
+		}
+
+		bool thrown = false;
+		try { f.get(); } catch ( const functional::broken_promise& ) { thrown = true; }
+		CHECK( thrown );
+
+		thrown = false;
+		try { g.get(); } catch ( const functional::broken_promise& ) { thrown = true; }
+		CHECK( thrown );                                             // 下游跟著壞掉
+	}
+
+	{
+		functional::promise<int> p;
+		functional::future<int> f = p.get_future();
+		functional::future<int> bad  = f.then(&Throw);
+		functional::future<int> good = f.then(&Twice);              // 排在丟出例外的後面
+
+		p.set_value(3);                                              // 例外不會丟到這裡
+		CHECK( good.get()==6 );
+
+		bool thrown = false;
+		try { bad.get(); } catch ( const functional::broken_promise& ) { thrown = true; }
+		CHECK( thrown );
+	}
+
+#if !defined(_WIN32)
+	for ( int i=0 ; i<200 ; i++ )                                    // 同時設定只有一個會成功
+	{
+		Race r;
+		r.go.store(0);
+		r.losers.store(0);
+
+		functional::future<int> f = r.p.get_future();
+		pthread_t t[2];
+
+		pthread_create(&t[0], 0, &RaceSet, &r);
+		pthread_create(&t[1], 0, &RaceSet, &r);
+		r.go.store(1);
+		pthread_join(t[0], 0);
+		pthread_join(t[1], 0);
+
+		CHECK( r.losers.load()==1 );
+		CHECK( f.get()==1 );
+	}
+#endif
+
+	{
+		functional::promise<int> p;
+		p.set_value(1);
+
+		bool thrown = false;
+		try { p.set_value(2); } catch ( const functional::promise_already_satisfied& ) { thrown = true; }
+		CHECK( thrown );
+	}
+}
+
+//------------------------fiber------------------------
+
+#if defined(__linux__)
+static void YieldThenCount(functional::atomic<int> *n)
+{
+	for ( int i=0 ; i<3 ; i++ ) functional::this_fiber::yield();
+	n->fetch_add(1);
+}
+
+static void TestFiber()
+{
+	functional::atomic<int> n(0);
+
+	{
+		functional::fiber_scheduler sched(2);
+		CHECK( sched.threads()==2 );
+
+		for ( int i=0 ; i<20 ; i++ )
+		{
+			CHECK( sched.spawn(functional::bind(&YieldThenCount, &n)) );
+		}
+
+		sched.wait();
+		CHECK( n.load()==20 );
+	}
+}
+#endif
+
+//------------------------affinity_executor------------------------
+
+#if defined(__linux__)
+// 綁定的參數很大，放不進工作裡的空間，核心只能放在heap上
+struct Bulky
+{
+	char    pad[256];
+};
+
+static void Tally(functional::atomic<int> *n, Bulky){ n->fetch_add(100); }
+static void Bump(functional::atomic<int> *n){ n->fetch_add(1); }
+
+static void TestAffinityExecutor()
+{
+	functional::atomic<int> n(0);
+	size_t nodes = 0;
+	Bulky big;
+	memset(&big, 0, sizeof(big));
+
+	{
+		functional::affinity_executor ex(2, functional::affinity_executor::pin_node);
+		nodes = ex.nodes();
+		CHECK( nodes>=1 );
+		CHECK( ex.size()>=1 );
+
+		for ( size_t k=0 ; k<ex.nodes() ; k++ )
+		{
+			CHECK( ex.post(functional::bind(&Bump, &n), k) );
+		}
+
+		CHECK( ex.post(functional::bind(&Bump, &n), ex.nodes()+5) );     // 超出範圍的當成0
+		CHECK( ex.post(functional::bind(&Bump, &n)) );
+		CHECK( ex.post_near(functional::bind(&Bump, &n), &n) );
+		CHECK( ex.post(functional::bind(&Tally, &n, big)) );             // 核心放不進工作裡，退回heap
+
+		for ( int i=0 ; i<2000 ; i++ )                                   // 用完的工作記憶體會重複使用
+		{
+			CHECK( ex.post(functional::bind(&Bump, &n), size_t(i)) );
+		}
+	}                                                                    // 解構時會先做完排隊中的工作
+
+	CHECK( n.load()==int(nodes)+3+100+2000 );
+}
+#endif
+
+//------------------------async_io------------------------
+
+#if defined(__linux__)
+static void SaveResult(int *out, int res)
+{
+	*out = res;
+}
+
+static void CountCancel(int *count, int res)
+{
+	if ( res==-ECANCELED || res==-EINTR ) ++*count;
+}
+
+static void ThrowResult(int res){ throw res; }
+
+static void TestAsyncIo()
+{
+	using namespace functional::placeholders;
+
+	int fds[2];
+	CHECK( pipe(fds)==0 );
+
+	char in[4] = "abc";
+	char out[4] = "";
+	int  wrote = 0;
+	int  got   = 0;
+	int  stuck = 0;
+
+	{
+		functional::async_io io(8);
+
+		if ( io.valid() )       // 沙箱裡可能不給用io_uring
+		{
+			CHECK( io.write(fds[1], in, 3, uint64_t(-1), functional::bind(&SaveResult, &wrote, _1)) );
+			CHECK( io.wait(1)==1 );
+			CHECK( wrote==3 );
+
+			CHECK( io.read(fds[0], out, 3, uint64_t(-1), functional::bind(&SaveResult, &got, _1)) );
+			CHECK( io.wait(1)==1 );
+			CHECK( got==3 && memcmp(out, "abc", 3)==0 );
+
+			// 管線裡沒有資料，這筆讀取永遠不會自己完成，解構時要取消並等到它有結果
+			CHECK( io.read(fds[0], out, 3, uint64_t(-1), functional::bind(&SaveResult, &stuck, _1)) );
+			CHECK( io.submit()==1 );
+			CHECK( io.pending()==1 );
+		}
+		else
+		{
+			stuck = -ECANCELED;
+		}
+	}
+
+	CHECK( stuck==-ECANCELED || stuck==-EINTR );
+
+	// 每個slot都卡著一筆讀取，解構時的取消要全部收得到結果
+	int cancelled = 0;
+	char many[64];
+
+	{
+		functional::async_io io(8);
+
+		if ( io.valid() )
+		{
+			int n = 0;
+
+			while ( io.read(fds[0], many+n, 1, uint64_t(-1), functional::bind(&CountCancel, &cancelled, _1)) ) n++;
+
+			CHECK( n>0 && errno==EBUSY );
+			CHECK( io.submit()==n && io.pending()==size_t(n) );
+			cancelled -= n;
+		}
+	}
+
+	CHECK( cancelled==0 );
+
+	// callback丟出例外的話slot還是要還回來，不然幾次之後就沒有slot可用了
+	{
+		functional::async_io io(2);
+
+		if ( io.valid() )
+		{
+			int thrown = 0;
+
+			for ( int i=0 ; i<16 ; i++ )
+			{
+				CHECK( io.write(fds[1], in, 1, uint64_t(-1), &ThrowResult) );
+
+				try { io.wait(1); } catch ( int ) { thrown++; }
+			}
+
+			CHECK( thrown==16 && io.pending()==0 );
+		}
+	}
+
+	close(fds[0]);
+	close(fds[1]);
+}
+#endif
+
+//------------------------task_graph------------------------
+
+#if !defined(_WIN32)
+// 記下每個節點是第幾個開始的
+static void Stamp(functional::atomic<int> *seq, int *slot){ *slot = seq->fetch_add(1); }
+
+static void TestTaskGraph()
+{
+	{
+		functional::task_graph g(2);
+		CHECK( g.threads()==2 );
+
+		functional::atomic<int> seq(0);
+		int at[4] = { 0, 0, 0, 0 };
+
+		size_t a = g.add(functional::bind(&Stamp, &seq, &at[0]));
+		size_t b = g.add(functional::bind(&Stamp, &seq, &at[1]));
+		size_t c = g.add(functional::bind(&Stamp, &seq, &at[2]));
+		size_t d = g.add(functional::bind(&Stamp, &seq, &at[3]));
+
+		g.precede(a, c);
+		g.precede(b, c);
+		g.precede(c, d);
+
+		for ( int round=0 ; round<50 ; round++ )                     // 同一張圖可以反覆執行
+		{
+			seq.store(0);
+			CHECK( g.run() );
+			CHECK( seq.load()==4 );
+			CHECK( at[0] < at[2] && at[1] < at[2] && at[2] < at[3] );
+		}
+
+		CHECK( g.add(&Nothing)==functional::task_graph::npos );  // freeze()之後不能再加
+	}
+
+	{
+		functional::task_graph g;
+		size_t a = g.add(&Nothing);
+		size_t b = g.add(&Nothing);
+		size_t c = g.add(&Nothing);
+
+		g.precede(a, b);
+		g.precede(b, c);
+		g.precede(c, a);
+
+		CHECK( !g.freeze() );                                        // 有環
+		CHECK( !g.run() );
+		CHECK( !g.frozen() );
+	}
+}
+#endif
+
+//------------------------parallel------------------------
+
+#if !defined(_WIN32)
+// 每個位置被處理幾次，每個區段只碰自己的位置，不需要鎖
+static void MarkRange(int *hits, int b, int e)
+{
+	for ( int i=b ; i<e ; i++ ) hits[i]++;
+}
+
+// 記下區段的數量與總和，順便檢查除了最後一段之外都不小於grain
+struct SumRange
+{
+	void operator()(int b, int e) const
+	{
+		long s = 0;
+		for ( int i=b ; i<e ; i++ ) s += i;
+
+		sum->fetch_add(s);
+		calls->fetch_add(1);
+
+		if ( e-b < grain && e!=end ) small->fetch_add(1);
+	}
+
+	functional::atomic<long>    *sum;
+	functional::atomic<int>     *calls;
+	functional::atomic<int>     *small;
+	int                         grain;
+	int                         end;
+};
+
+static long Sum(functional::parallel_pool &pool, int begin, int end, int grain, int *calls, int *small)
+{
+	functional::atomic<long> s(0);
+	functional::atomic<int>  c(0);
+	functional::atomic<int>  m(0);
+	SumRange body = { &s, &c, &m, grain < 1 ? 1 : grain, end };
+
+	functional::parallel_for(pool, begin, end, grain, body);
+
+	*calls = c.load();
+	*small = m.load();
+	return s.load();
+}
+
+// 外層每一列再平行處理自己的每一行
+struct Rows
+{
+	void operator()(int b, int e) const
+	{
+		using namespace functional::placeholders;
+
+		for ( int r=b ; r<e ; r++ )
+		{
+			functional::parallel_for(*pool, 0, 64, 4, functional::bind(&MarkRange, cells + r*64, _1, _2));
+		}
+	}
+
+	functional::parallel_pool   *pool;
+	int                         *cells;
+};
+
+static void Hit(int *slot){ (*slot)++; }
+
+static void TestParallel()
+{
+	using namespace functional::placeholders;
+
+	functional::parallel_pool pool(3);
+	CHECK( pool.size()==3 );
+
+	int calls = 0;
+	int small = 0;
+
+	CHECK( Sum(pool, 0, 10000, 1, &calls, &small)==49995000L );
+	CHECK( calls>=1 && small==0 );
+
+	CHECK( Sum(pool, -500, 1500, 64, &calls, &small)==999000L );        // 不是從0開始，grain也不是預設的1
+	CHECK( small==0 );
+
+	CHECK( Sum(pool, 3, 40, 1000, &calls, &small)==(3+39)*37/2 );       // grain比整段還大，只呼叫一次
+	CHECK( calls==1 );
+
+	CHECK( Sum(pool, 7, 7, 1, &calls, &small)==0 && calls==0 );         // 空的範圍
+	CHECK( Sum(pool, 9, 2, 1, &calls, &small)==0 && calls==0 );         // 反過來的範圍
+
+	{
+		std::vector<int> hits(5000, 0);
+		functional::parallel_for(pool, 0, 5000, 100, functional::bind(&MarkRange, &hits[0], _1, _2));
+		CHECK( std::count(hits.begin(), hits.end(), 1)==5000 );
+	}
+
+	{
+		std::vector<int> cells(32*64, 0);
+		Rows rows = { &pool, &cells[0] };
+		functional::parallel_for(pool, 0, 32, 1, rows);                  // 巢狀呼叫不會卡死
+		CHECK( std::count(cells.begin(), cells.end(), 1)==32*64 );
+	}
+
+	{
+		int h[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+		functional::parallel_invoke(pool,
+		                            functional::bind(&Hit, &h[0]), functional::bind(&Hit, &h[1]), functional::bind(&Hit, &h[2]),
+		                            functional::bind(&Hit, &h[3]), functional::bind(&Hit, &h[4]), functional::bind(&Hit, &h[5]),
+		                            functional::bind(&Hit, &h[6]), functional::bind(&Hit, &h[7]), functional::bind(&Hit, &h[8]));
+		CHECK( std::count(h, h+9, 1)==9 );                                  // 最多九個，每個剛好一次
+
+		functional::parallel_invoke(functional::bind(&Hit, &h[0]), functional::bind(&Hit, &h[1]));  // 全域的池
+		CHECK( h[0]==2 && h[1]==2 );
+	}
+}
+#endif
+
+//------------------------pipeline------------------------
+
+#if !defined(_WIN32)
+static void TestPipeline()
+{
+	using namespace functional::placeholders;
+
+	std::vector<int> got;
+
+	{
+		functional::pipeline<int> p(16);                             // 緩衝區很小，會一直繞回開頭也會塞住
+		p.stage(&Twice)
+		 .stage(&AddOne, 3)                                          // 中間的階段開3個副本
+		 .sink(functional::bind(&Collect, &got, _1));
+
+		for ( int i=0 ; i<1000 ; i++ ) CHECK( p.push(i) );
+
+		p.close();
+		CHECK( !p.push(0) );
+	}
+
+	bool ordered = got.size()==1000;
+
+	for ( size_t i=0 ; ordered && i<got.size() ; i++ ) ordered = got[i]==int(i)*2+1;
+
+	CHECK( ordered );                                                // 副本輪流分派，順序跟push()一樣
+
+#ifdef HAVE_FAIL_THREADS
+	got.clear();
+
+	{
+		functional::pipeline<int> p(16);
+		FailThreads(1, 1);                                           // 從下游開始建，sink成功，中間的第一個副本失敗
+		p.stage(&Twice)
+		 .stage(&AddOne, 3)
+		 .sink(functional::bind(&Collect, &got, _1));
+		FailThreads(0, 0);
+
+		CHECK( p.running() );
+
+		for ( int i=0 ; i<1000 ; i++ ) CHECK( p.push(i) );
+	}
+
+	ordered = got.size()==1000;
+
+	for ( size_t i=0 ; ordered && i<got.size() ; i++ ) ordered = got[i]==int(i)*2+1;
+
+	CHECK( ordered );                                                // 少了一個副本，資料不會卡住也不會亂
+
+	{
+		functional::pipeline<int> p(16);
+		FailThreads(1, 3);                                           // 中間的階段一條都建不起來
+		p.stage(&Twice)
+		 .stage(&AddOne, 3)
+		 .sink(functional::bind(&Collect, &got, _1));
+		FailThreads(0, 0);
+
+		CHECK( !p.running() );                                       // 已經啟動的sink會自己結束，解構時不會卡住
+		CHECK( !p.push(1) );
+	}
+#endif
+}
+#endif
+
+//------------------------deadline_executor------------------------
+
+#if !defined(_WIN32)
+struct Gate
+{
+	functional::atomic<int>     started;
+	functional::atomic<int>     open;
+};
+
+// 把唯一的工作執行緒卡住，好讓後面的工作全部排進佇列
+static void WaitGate(Gate *g)
+{
+	g->started.store(1);
+	while ( !g->open.load() ) sched_yield();
+}
+
+static void Record(std::vector<int> *order, int v){ order->push_back(v); }
+
+static void TestDeadlineExecutor()
+{
+	std::vector<int> order;
+	Gate g;
+	g.started.store(0);
+	g.open.store(0);
+
+	{
+		functional::deadline_executor ex(1, 3);
+		ex.post(functional::bind(&WaitGate, &g), 0);
+
+		while ( !g.started.load() ) sched_yield();
+
+		ex.post(functional::bind(&Record, &order, 30));                  // 沒指定就是最低等級
+		ex.post(functional::bind(&Record, &order, 31), 2);
+		ex.post(functional::bind(&Record, &order, 10), 1);
+		ex.post(functional::bind(&Record, &order, 3), 0);                // 沒有期限排在有期限的後面
+		ex.post(functional::bind(&Record, &order, 2), 0, 60000000);
+		ex.post(functional::bind(&Record, &order, 1), 0, 30000000);      // 期限最早
+		g.open.store(1);
+	}                                                                    // 解構時會先做完排隊中的工作
+
+	static const int expect[] = { 1, 2, 3, 10, 30, 31 };
+	CHECK( order.size()==6 && std::equal(order.begin(), order.end(), expect) );
+}
+#endif
+
+//------------------------strand------------------------
+
+#if !defined(_WIN32)
+struct Serial
+{
+	functional::atomic<int>     inside;     // 同時在執行的工作數量
+	functional::atomic<int>     overlaps;
+	std::vector<int>            order;      // strand保證不會同時碰，不用鎖
+};
+
+static void Enter(Serial *s, int v)
+{
+	if ( s->inside.fetch_add(1)!=0 ) s->overlaps.fetch_add(1);
+
+	s->order.push_back(v);
+	sched_yield();                          // 拉長執行時間，重疊的話比較容易抓到
+
+	s->inside.fetch_sub(1);
+}
+
+static void MarkCaller(pthread_t *t, int *runs)
+{
+	*t = pthread_self();
+	++*runs;
+}
+
+static void TestStrand()
+{
+	functional::deadline_executor ex(4, 1);
+
+	{
+		Serial s;
+		s.inside.store(0);
+		s.overlaps.store(0);
+
+		functional::strand<functional::deadline_executor> st(ex);
+
+		for ( int i=0 ; i<2000 ; i++ )
+		{
+			st.post(functional::bind(&Enter, &s, i));
+		}
+
+		while ( st.pending()!=0 ) sched_yield();
+
+		CHECK( s.overlaps.load()==0 );
+		CHECK( s.order.size()==2000 );
+
+		bool fifo = true;
+
+		for ( int i=0 ; i<int(s.order.size()) ; i++ )
+		{
+			if ( s.order[i]!=i ) fifo = false;
+		}
+
+		CHECK( fifo );
+	}
+
+	{
+		functional::strand<functional::deadline_executor> st(ex);
+		pthread_t who;
+		int runs = 0;
+
+		st.dispatch(functional::bind(&MarkCaller, &who, &runs));        // 閒置，當場在這條執行緒執行
+		CHECK( runs==1 && pthread_equal(who, pthread_self()) );
+		CHECK( st.pending()==0 );
+
+		Gate g;
+		g.started.store(0);
+		g.open.store(0);
+
+		st.post(functional::bind(&WaitGate, &g));
+		while ( !g.started.load() ) sched_yield();
+
+		st.dispatch(functional::bind(&MarkCaller, &who, &runs));        // 忙碌中，只能排隊
+		CHECK( runs==1 && st.pending()==2 );
+
+		g.open.store(1);
+		while ( st.pending()!=0 ) sched_yield();
+
+		CHECK( runs==2 && !pthread_equal(who, pthread_self()) );
+	}
+}
+#endif
+
+//------------------------frame_runner------------------------
+
+struct Stepper
+{
+	functional::frame_runner    *runner;
+	size_t                      id;
+	int                         runs;
+	int                         remove_at;  // 第幾次執行時拿掉自己
+	int                         done_at;    // 第幾次執行時回報做完了
+	int                         throw_at;   // 第幾次執行時丟出例外
+
+	bool Step()
+	{
+		runs++;
+
+		if ( runs==remove_at ) runner->remove(id);
+		if ( runs==throw_at ) throw runs;
+
+		return runs==done_at;
+	}
+};
+
+static void TestFrameRunner()
+{
+	functional::frame_runner jobs;
+	Stepper a = { &jobs, 0, 0, 2, -1, -1 };
+	Stepper b = { &jobs, 0, 0, -1, 5, -1 };
+
+	a.id = jobs.add(functional::bind(&Stepper::Step, &a));
+	b.id = jobs.add(functional::bind(&Stepper::Step, &b));
+
+	CHECK( jobs.tick(0)==1 );                                        // 預算是0也至少會做一個
+	CHECK( a.runs==1 && b.runs==0 );
+
+	jobs.tick(1000000);                                              // 時間很多，全部做完為止
+
+	CHECK( a.runs==2 );                                              // 拿掉自己之後不會再被執行
+	CHECK( b.runs==5 );
+	CHECK( jobs.empty() );
+	CHECK( !jobs.remove(a.id) );
+
+	Stepper c = { &jobs, 0, 0, -1, -1, 1 };
+	c.id = jobs.add(functional::bind(&Stepper::Step, &c));
+
+	bool thrown = false;
+	try { jobs.tick(1000); } catch ( int ) { thrown = true; }
+	CHECK( thrown && jobs.size()==1 );
+	CHECK( jobs.remove(c.id) && jobs.empty() );                      // 丟出例外之後還是拿得掉
+
+	Stepper d = { &jobs, 0, 0, 1, -1, 1 };
+	d.id = jobs.add(functional::bind(&Stepper::Step, &d));
+
+	thrown = false;
+	try { jobs.tick(1000); } catch ( int ) { thrown = true; }
+	CHECK( thrown && jobs.empty() );                                 // 拿掉自己之後才丟出例外，一樣要釋放
+	CHECK( jobs.tick(1000)==0 && d.runs==1 );
+}
+
+//------------------------debounce------------------------
+
+#if !defined(_WIN32)
+// 先把工作存起來，等測試說可以了才執行
+struct Manual
+{
+	void post(const functional::function<void()> &f) { queue.push_back(f); }
+
+	void run()
+	{
+		std::vector< functional::function<void()> > q;
+		q.swap(queue);
+
+		for ( size_t i=0 ; i<q.size() ; i++ ) q[i]();
+	}
+
+	std::vector< functional::function<void()> > queue;
+};
+
+static int Plus(const int &a, const int &b){ return a+b; }
+
+static functional::atomic<int> debounced_calls(0);
+static functional::atomic<int> debounced_value(0);
+
+static void Debounced(int v)
+{
+	debounced_value.store(v);
+	debounced_calls.fetch_add(1);
+}
+
+static void TestDebounce()
+{
+	using namespace functional::placeholders;
+
+	std::vector<int> got;
+	functional::function<void(int)> sink = functional::bind(&Collect, &got, _1);
+
+	{
+		Manual ex;
+		functional::function<void(int)> merged = functional::coalesce(ex, sink);
+
+		merged(1);
+		merged(2);
+		merged(3);
+		CHECK( ex.queue.size()==1 );                                     // 排隊期間只投遞一次
+		ex.run();
+		CHECK( got.size()==1 && got[0]==3 );                             // 只拿到最新的參數
+
+		merged(4);                                                       // 做完之後可以再投遞
+		CHECK( ex.queue.size()==1 );
+		ex.run();
+		CHECK( got.size()==2 && got[1]==4 );
+	}
+
+	{
+		got.clear();
+		Manual ex;
+		functional::function<void(int)> sum = functional::coalesce(ex, sink, functional::function<int(const int&, const int&)>(&Plus));
+
+		sum(1);
+		sum(2);
+		sum(3);
+		ex.run();
+		CHECK( got.size()==1 && got[0]==6 );                             // 累積起來
+	}
+
+	{
+		functional::function<void(int)> calm = functional::debounce(functional::function<void(int)>(&Debounced), 50);
+
+		for ( int i=1 ; i<=5 ; i++ ) calm(i);
+
+		timespec t = { 0, 300000000 };
+		nanosleep(&t, 0);
+
+		CHECK( debounced_calls.load()==1 );                              // 安靜下來之後才執行一次
+		CHECK( debounced_value.load()==5 );
+	}
+}
+
+#ifdef HAVE_FAIL_THREADS
+// 計時執行緒整個行程只有一條，所以這項要在另一個行程裡單獨測
+static void TestDebounceNoTimer()
+{
+	FailThreads(0, 1);
+	functional::function<void(int)> calm = functional::debounce(functional::function<void(int)>(&Debounced), 50);
+
+	calm(1);                                                             // 第一次用到時才建計時執行緒
+	FailThreads(0, 0);
+	CHECK( debounced_calls.load()==1 && debounced_value.load()==1 );    // 沒有計時執行緒就當場執行
+
+	calm(2);
+	CHECK( debounced_calls.load()==2 && debounced_value.load()==2 );
+}                                                                        // 解構時不會去join不存在的執行緒
+#endif
+#endif
+
+//------------------------async_logger------------------------
+
+#if !defined(_WIN32)
+static void TestAsyncLogger()
+{
+	FILE *f = tmpfile();
+
+	{
+		functional::async_logger log(f, 256);                       // 很小的佇列，會一直繞回開頭
+		char name[16] = "alpha";
+
+		CHECK( log.write("%s\n", name) );
+		strcpy(name, "CLOBBERED");                                   // 陣列已經複製進去了
+
+		for ( int i=0 ; i<200 ; i++ )
+		{
+			while ( !log.write("line %d %s\n", i, "x") ) sched_yield();
+		}
+	}
+
+	rewind(f);
+
+	char line[64];
+	CHECK( fgets(line, sizeof(line), f) && strcmp(line, "alpha\n")==0 );
+
+	int n = 0;
+
+	while ( fgets(line, sizeof(line), f) )
+	{
+		char expect[64];
+		sprintf(expect, "line %d x\n", n);
+
+		if ( strcmp(line, expect)!=0 ) break;
+
+		n++;
+	}
+
+	CHECK( n==200 );                                                 // 繞回開頭之後順序跟內容都沒亂
+	fclose(f);
+
+#ifdef HAVE_FAIL_THREADS
+	f = tmpfile();
+
+	{
+		FailThreads(0, 1);
+		functional::async_logger log(f, 256);                       // 背景執行緒建不起來
+		FailThreads(0, 0);
+
+		for ( int i=0 ; i<100 ; i++ ) CHECK( log.write("sync %d\n", i) );
+
+		CHECK( log.dropped()==0 );
+		CHECK( ftell(f)==long(strlen("sync 0\n")*10 + strlen("sync 10\n")*90) );  // 還沒解構就已經寫出去了
+	}                                                                // 解構時不會去join不存在的執行緒
+
+	fclose(f);
+#endif
+}
+#endif
+
+// 印出結果，有失敗的話main()回傳1
+static int Report()
+{
+	if ( failures )
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	using namespace functional::placeholders;
+
+#ifdef HAVE_FAIL_THREADS
+	if ( argc > 1 && strcmp(argv[1], "no_timer")==0 )
+	{
+		TestDebounceNoTimer();
+		return Report();
+	}
+#else
+	(void)argc;
+	(void)argv;
+#endif
+
+	functional::function<void(int)> func=functional::bind(&MyFunction,_1);
+	func(5);
+
+#ifdef FUNCTIONAL_TELEMETRY
+	TestTelemetry();
+#endif
+	TestEmptyCall();
+	TestInvokeInto();
+	TestEmplace();
+#ifdef _STD_FUNCTIONAL_CXX11
+	TestMove();
+#endif
+	TestMemoize();
+	TestRange();
+	TestTrampoline();
+	TestCallbackStore();
+	TestFuture();
+	TestFrameRunner();
+#if defined(__linux__)
+	TestReactor();
+	TestFiber();
+	TestAsyncIo();
+	TestAffinityExecutor();
+#endif
+#if !defined(_WIN32)
+	TestTaskGraph();
+	TestParallel();
+	TestPipeline();
+	TestDeadlineExecutor();
+	TestStrand();
+	TestDebounce();
+	TestAsyncLogger();
+#endif
+
+	return Report();
+}
@@ -0,0 +1,808 @@
+/**
+ * @file      memoize.hpp
+ * @brief     替 function 加上有容量上限的查詢快取
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::function<double(int)> slow = &PricingCurve;
+ *     std::function<double(int)> fast = std::memoize(slow, 4096);
+ *     fast(7);     // 第一次會真正執行PricingCurve
+ *     fast(7);     // 之後直接從快取取出結果
+ *
+ * 快取以參數組成的 storage 當作 key，並依雜湊值分散到數個 shard
+ * 每個 shard 各自持有一把鎖與一條LRU串列，查詢時只會鎖住其中一個 shard
+ * 被包裝的函式必須是純函式，執行期間不會持有任何鎖
+ *
+ * 參數的type必須支援 operator== 並且有對應的 memoize_hash 特化版本
+ * 內建的整數(包括 long long 與 int64_t)、浮點數、指標與 std::string 已經準備好了，自訂type請自行特化
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_MEMOIZE_HPP_
+#define _STD_MEMOIZE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <cmath>
+#include <string>
+#include <functional.hpp>
+#include <mutex.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+//------------------memoize_hash------------------start
+
+/// 計算單一參數的雜湊值，沒有特化過的type就無法拿來當key
+template<typename T> struct memoize_hash;
+
+namespace _memoize{
+
+// FNV-1a，給沒辦法直接轉成整數的type使用
+inline size_t hash_bytes(const void *p, size_t n)
+{
+	const unsigned char *c = static_cast<const unsigned char*>(p);
+	size_t h = 2166136261u;
+
+	for ( size_t i=0 ; i<n ; i++ )
+	{
+		h ^= c[i];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+// 整數類的共同實作，比size_t寬的(32位元平台上的long long)不能直接截掉高位
+template<typename T>
+struct hash_integral
+{
+	inline size_t operator()(T v) const { return sizeof(T) > sizeof(size_t) ? hash_bytes(&v, sizeof(v)) : static_cast<size_t>(v); }
+};
+
+// 浮點數類的共同實作，0.0跟-0.0必須得到相同結果
+template<typename T>
+struct hash_floating
+{
+	inline size_t operator()(T v) const { return v==T(0) ? 0 : hash_bytes(&v, sizeof(v)); }
+};
+
+// long double的sizeof包含沒用到的填充位元組，拆成尾數與指數再算
+struct hash_long_double
+{
+	inline size_t operator()(long double v) const
+	{
+		if ( v==0 ) return 0;
+
+		int e;
+		double m = double(std::frexp(v, &e));   // 尾數在[0.5, 1)之間，轉成double不會溢位
+		return hash_floating<double>()(m) ^ static_cast<size_t>(e);
+	}
+};
+
+// C++98沒有long long，GCC與Clang在-pedantic底下只有這兩行不警告，其他地方都透過typedef來用
+#if defined(_STD_FUNCTIONAL_CXX11) || defined(_MSC_VER)
+#define _STD_MEMOIZE_LONG_LONG
+typedef long long           long_long;
+typedef unsigned long long  ulong_long;
+#elif defined(__GNUC__)
+#define _STD_MEMOIZE_LONG_LONG
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wlong-long"
+typedef long long           long_long;
+typedef unsigned long long  ulong_long;
+#pragma GCC diagnostic pop
+#endif
+
+}//namespace _memoize
+
+template<> struct memoize_hash<bool>           : _memoize::hash_integral<bool>{};
+template<> struct memoize_hash<char>           : _memoize::hash_integral<char>{};
+template<> struct memoize_hash<signed char>    : _memoize::hash_integral<signed char>{};
+template<> struct memoize_hash<unsigned char>  : _memoize::hash_integral<unsigned char>{};
+template<> struct memoize_hash<wchar_t>        : _memoize::hash_integral<wchar_t>{};
+template<> struct memoize_hash<short>          : _memoize::hash_integral<short>{};
+template<> struct memoize_hash<unsigned short> : _memoize::hash_integral<unsigned short>{};
+template<> struct memoize_hash<int>            : _memoize::hash_integral<int>{};
+template<> struct memoize_hash<unsigned int>   : _memoize::hash_integral<unsigned int>{};
+template<> struct memoize_hash<long>           : _memoize::hash_integral<long>{};
+template<> struct memoize_hash<unsigned long>  : _memoize::hash_integral<unsigned long>{};
+#ifdef _STD_MEMOIZE_LONG_LONG
+template<> struct memoize_hash<_memoize::long_long>  : _memoize::hash_integral<_memoize::long_long>{};
+template<> struct memoize_hash<_memoize::ulong_long> : _memoize::hash_integral<_memoize::ulong_long>{};
+#endif
+template<> struct memoize_hash<float>          : _memoize::hash_floating<float>{};
+template<> struct memoize_hash<double>         : _memoize::hash_floating<double>{};
+template<> struct memoize_hash<long double>    : _memoize::hash_long_double{};
+
+template<typename T> struct memoize_hash<T*>
+{
+	inline size_t operator()(T *p) const { return reinterpret_cast<size_t>(p); }
+};
+
+template<> struct memoize_hash<std::string>
+{
+	inline size_t operator()(const std::string &s) const { return _memoize::hash_bytes(s.data(), s.size()); }
+};
+
+//------------------memoize_hash------------------end
+
+namespace _memoize{
+
+// 不管對象是不是參考或const都化為原本type，key裡面只存這種type
+template<typename T> struct value_of           { typedef T type; };
+template<typename T> struct value_of<const T>  { typedef T type; };
+template<typename T> struct value_of<T&> : value_of<T>{};
+
+// 把新的雜湊值混進既有的結果
+inline void combine(size_t &seed, size_t h)
+{
+	seed ^= h + 0x9e3779b9u + (seed<<6) + (seed>>2);
+}
+
+// 打散位元，讓低位元也能拿來挑shard跟bucket
+inline size_t finalize(size_t h)
+{
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	h *= 0x297a2d39u;
+	h ^= h >> 15;
+	return h;
+}
+
+//------------------操作storage的小工具------------------start
+// 透過storage::Do()把storage裡的參數一個個攤開來處理
+
+/// 對storage內的每個參數取雜湊值再混合起來
+struct key_hash
+{
+	inline size_t operator()() const
+	{
+		size_t h = 0;
+		return finalize(h);
+	}
+	template<typename A1>
+	inline size_t operator()(const A1 &a1) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		return finalize(h);
+	}
+	template<typename A1, typename A2>
+	inline size_t operator()(const A1 &a1, const A2 &a2) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		combine(h, memoize_hash<A5>()(a5));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		combine(h, memoize_hash<A5>()(a5));
+		combine(h, memoize_hash<A6>()(a6));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		combine(h, memoize_hash<A5>()(a5));
+		combine(h, memoize_hash<A6>()(a6));
+		combine(h, memoize_hash<A7>()(a7));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		combine(h, memoize_hash<A5>()(a5));
+		combine(h, memoize_hash<A6>()(a6));
+		combine(h, memoize_hash<A7>()(a7));
+		combine(h, memoize_hash<A8>()(a8));
+		return finalize(h);
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline size_t operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9) const
+	{
+		size_t h = 0;
+		combine(h, memoize_hash<A1>()(a1));
+		combine(h, memoize_hash<A2>()(a2));
+		combine(h, memoize_hash<A3>()(a3));
+		combine(h, memoize_hash<A4>()(a4));
+		combine(h, memoize_hash<A5>()(a5));
+		combine(h, memoize_hash<A6>()(a6));
+		combine(h, memoize_hash<A7>()(a7));
+		combine(h, memoize_hash<A8>()(a8));
+		combine(h, memoize_hash<A9>()(a9));
+		return finalize(h);
+	}
+};
+
+/// 逐一比對key裡的參數是否與查詢用的storage相同< 查詢用的storage >
+template<typename P>
+struct key_equal
+{
+	explicit key_equal(const P &p):p_(p){}
+
+	inline bool operator()() const
+	{
+		return true;
+	}
+	template<typename A1>
+	inline bool operator()(const A1 &a1) const
+	{
+		return a1 == p_.a1_;
+	}
+	template<typename A1, typename A2>
+	inline bool operator()(const A1 &a1, const A2 &a2) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_;
+	}
+	template<typename A1, typename A2, typename A3>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_ && a5 == p_.a5_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_ && a5 == p_.a5_ && a6 == p_.a6_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_ && a5 == p_.a5_ && a6 == p_.a6_ && a7 == p_.a7_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_ && a5 == p_.a5_ && a6 == p_.a6_ && a7 == p_.a7_ && a8 == p_.a8_;
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline bool operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9) const
+	{
+		return a1 == p_.a1_ && a2 == p_.a2_ && a3 == p_.a3_ && a4 == p_.a4_ && a5 == p_.a5_ && a6 == p_.a6_ && a7 == p_.a7_ && a8 == p_.a8_ && a9 == p_.a9_;
+	}
+
+	const P &p_;
+};
+
+/// 把查詢用的storage(內含參考)複製成可長期保存的key< key的type >
+template<typename K>
+struct key_builder
+{
+	inline K operator()() const
+	{
+		return K();
+	}
+	template<typename A1>
+	inline K operator()(const A1 &a1) const
+	{
+		return K(const_cast<A1&>(a1));
+	}
+	template<typename A1, typename A2>
+	inline K operator()(const A1 &a1, const A2 &a2) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2));
+	}
+	template<typename A1, typename A2, typename A3>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3));
+	}
+	template<typename A1, typename A2, typename A3, typename A4>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4), const_cast<A5&>(a5));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4), const_cast<A5&>(a5), const_cast<A6&>(a6));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4), const_cast<A5&>(a5), const_cast<A6&>(a6), const_cast<A7&>(a7));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4), const_cast<A5&>(a5), const_cast<A6&>(a6), const_cast<A7&>(a7), const_cast<A8&>(a8));
+	}
+	template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	inline K operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9) const
+	{
+		return K(const_cast<A1&>(a1), const_cast<A2&>(a2), const_cast<A3&>(a3), const_cast<A4&>(a4), const_cast<A5&>(a5), const_cast<A6&>(a6), const_cast<A7&>(a7), const_cast<A8&>(a8), const_cast<A9&>(a9));
+	}
+};
+
+//------------------操作storage的小工具------------------end
+
+/// 快取裡的一筆資料< key的type , 函式回傳值的型態 >
+template<typename K, typename R>
+struct node
+{
+	template<typename P>
+	node(const P &p, const R &r, size_t h):key(build(p)),value(r),hash(h),chain(0),prev(0),next(0){}
+
+	template<typename P>
+	static inline K build(const P &p)
+	{
+		key_builder<K> b;
+		return p.Do(type<K>(), b);
+	}
+
+	const K     key;
+	const R     value;
+	size_t      hash;
+	node        *chain;     // 同一個bucket裡的下一筆
+	node        *prev;      // LRU串列，越前面越新
+	node        *next;
+};
+
+/// 一個shard就是一張獨立上鎖的小型雜湊表< key的type , 函式回傳值的型態 >
+template<typename K, typename R>
+struct shard
+{
+	typedef node<K,R> N;
+
+	shard():table(0),mask(0),head(0),tail(0),size(0),capacity(0){}
+
+	~shard()
+	{
+		while ( head )
+		{
+			N *n = head;
+			head = head->next;
+			delete n;
+		}
+
+		delete [] table;
+	}
+
+	void init(size_t cap)
+	{
+		size_t buckets = 1;
+		while ( buckets < cap ) buckets <<= 1;
+
+		table = new N*[buckets];
+		for ( size_t i=0 ; i<buckets ; i++ ) table[i] = 0;
+
+		mask = buckets - 1;
+		capacity = cap;
+	}
+
+	template<typename P>
+	N* find(size_t h, const P &p, unsigned bits) const
+	{
+		key_equal<P> eq(p);
+
+		for ( N *n = table[(h>>bits)&mask] ; n ; n = n->chain )
+		{
+			if ( n->hash==h && n->key.Do(type<bool>(), eq) )
+			{
+				return n;
+			}
+		}
+
+		return 0;
+	}
+
+	// 把剛用過的資料移到LRU串列最前面
+	void touch(N *n)
+	{
+		if ( n==head ) return;
+
+		unlink(n);
+		push_front(n);
+	}
+
+	void insert(N *n, unsigned bits)
+	{
+		N **slot = &table[(n->hash>>bits)&mask];
+		n->chain = *slot;
+		*slot = n;
+		push_front(n);
+
+		if ( ++size > capacity )
+		{
+			evict(bits);
+		}
+	}
+
+	mutex       lock;
+	N           **table;
+	size_t      mask;
+	N           *head;
+	N           *tail;
+	size_t      size;
+	size_t      capacity;
+
+	private:
+
+		void push_front(N *n)
+		{
+			n->prev = 0;
+			n->next = head;
+			if ( head ) head->prev = n;
+			head = n;
+			if ( !tail ) tail = n;
+		}
+
+		void unlink(N *n)
+		{
+			if ( n->prev ) n->prev->next = n->next; else head = n->next;
+			if ( n->next ) n->next->prev = n->prev; else tail = n->prev;
+		}
+
+		// 丟掉最久沒用到的那一筆
+		void evict(unsigned bits)
+		{
+			N *n = tail;
+			N **slot = &table[(n->hash>>bits)&mask];
+
+			while ( *slot!=n ) slot = &(*slot)->chain;
+
+			*slot = n->chain;
+			unlink(n);
+			delete n;
+			size--;
+		}
+};
+
+/// 被所有memoizer副本共享的快取本體< 函式回傳值的型態 , function的type , key的type >
+template<typename R, typename Fn, typename K>
+class cache
+{
+	public:
+
+		typedef shard<K,R> S;
+
+		cache(const Fn &f, size_t capacity):f_(f),refs_(1),bits_(0)
+		{
+			if ( capacity < 1 ) capacity = 1;
+
+			// shard數量取2的次方，最多16個，再加倍之後每個shard仍能放至少8筆才加倍
+			while ( bits_ < 4 && capacity / (size_t(2)<<bits_) >= 8 ) bits_++;
+
+			size_t count = size_t(1)<<bits_;
+			size_t each  = (capacity + count - 1) / count;
+
+			shards_ = new S[count];
+			for ( size_t i=0 ; i<count ; i++ ) shards_[i].init(each);
+		}
+
+		~cache(){ delete [] shards_; }
+
+		inline void retain()  { refs_.fetch_add(1); }
+		inline bool release() { return refs_.fetch_sub(1)==1; }
+
+		// P是查詢用的storage，裡面只存著參數的參考
+		template<typename P>
+		R get(const P &p)
+		{
+			key_hash hasher;
+			size_t h = p.Do(type<size_t>(), hasher);
+			S &s = shards_[h & ((size_t(1)<<bits_)-1)];
+
+			{
+				lock_guard<mutex> guard(s.lock);
+				typename S::N *n = s.find(h, p, bits_);
+
+				if ( n )
+				{
+					s.touch(n);
+					return n->value;
+				}
+			}
+
+			// 執行期間不持有鎖，同一個key被同時計算的話只保留先寫入的那筆
+			R r = p.Do(type<R>(), f_);
+
+			lock_guard<mutex> guard(s.lock);
+
+			if ( !s.find(h, p, bits_) )
+			{
+				s.insert(new typename S::N(p, r, h), bits_);
+			}
+
+			return r;
+		}
+
+	private:
+
+		cache(const cache&);
+		cache& operator=(const cache&);
+
+		Fn              f_;
+		atomic<long>    refs_;
+		unsigned        bits_;      // shard數量的log2
+		S               *shards_;
+};
+
+/// 塞進bind_t裡的仿函式，複製時只會共用同一份快取< 函式回傳值的型態 , function的type , key的type >
+template<typename R, typename Fn, typename K>
+struct memoizer
+{
+	public:
+
+		typedef R result_type;
+		typedef cache<R,Fn,K> C;
+
+		memoizer(const Fn &f, size_t capacity):c_(new C(f, capacity)){}
+		memoizer(const memoizer &other):c_(other.c_){ c_->retain(); }
+		~memoizer(){ if ( c_->release() ) delete c_; }
+
+		memoizer& operator=(const memoizer &other)
+		{
+			other.c_->retain();
+			if ( c_->release() ) delete c_;
+			c_ = other.c_;
+			return *this;
+		}
+
+		inline R operator()() const
+		{
+			return c_->get(storage0());
+		}
+		template<typename A1>
+		inline R operator()(const A1 &a1) const
+		{
+			return c_->get(storage1<const A1&>(a1));
+		}
+		template<typename A1, typename A2>
+		inline R operator()(const A1 &a1, const A2 &a2) const
+		{
+			return c_->get(storage2<const A1&, const A2&>(a1, a2));
+		}
+		template<typename A1, typename A2, typename A3>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3) const
+		{
+			return c_->get(storage3<const A1&, const A2&, const A3&>(a1, a2, a3));
+		}
+		template<typename A1, typename A2, typename A3, typename A4>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4) const
+		{
+			return c_->get(storage4<const A1&, const A2&, const A3&, const A4&>(a1, a2, a3, a4));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5) const
+		{
+			return c_->get(storage5<const A1&, const A2&, const A3&, const A4&, const A5&>(a1, a2, a3, a4, a5));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6) const
+		{
+			return c_->get(storage6<const A1&, const A2&, const A3&, const A4&, const A5&, const A6&>(a1, a2, a3, a4, a5, a6));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7) const
+		{
+			return c_->get(storage7<const A1&, const A2&, const A3&, const A4&, const A5&, const A6&, const A7&>(a1, a2, a3, a4, a5, a6, a7));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8) const
+		{
+			return c_->get(storage8<const A1&, const A2&, const A3&, const A4&, const A5&, const A6&, const A7&, const A8&>(a1, a2, a3, a4, a5, a6, a7, a8));
+		}
+		template<typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+		inline R operator()(const A1 &a1, const A2 &a2, const A3 &a3, const A4 &a4, const A5 &a5, const A6 &a6, const A7 &a7, const A8 &a8, const A9 &a9) const
+		{
+			return c_->get(storage9<const A1&, const A2&, const A3&, const A4&, const A5&, const A6&, const A7&, const A8&, const A9&>(a1, a2, a3, a4, a5, a6, a7, a8, a9));
+		}
+
+	private:
+
+		C   *c_;
+};
+
+}//namespace _memoize
+
+//---------------------------memoize---------------------------start
+
+// 回傳的function與原本的簽名相同，但背後多了一層最多保存capacity筆結果的快取
+
+template<typename R>
+function<R()> memoize(const function<R()> &f, size_t capacity)
+{
+	typedef storage0 K;
+	typedef _memoize::memoizer<R, function<R()>, K> F;
+	typedef storage0 S;
+	return bind_t<R, F, S>(F(f, capacity), S());
+}
+template<typename R, typename P1>
+function<R(P1)> memoize(const function<R(P1)> &f, size_t capacity)
+{
+	typedef storage1<typename _memoize::value_of<P1>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1)>, K> F;
+	typedef storage1<Argc<1>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	return bind_t<R, F, S>(F(f, capacity), S(a1));
+}
+template<typename R, typename P1, typename P2>
+function<R(P1, P2)> memoize(const function<R(P1, P2)> &f, size_t capacity)
+{
+	typedef storage2<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2)>, K> F;
+	typedef storage2<Argc<1>(*)(), Argc<2>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2));
+}
+template<typename R, typename P1, typename P2, typename P3>
+function<R(P1, P2, P3)> memoize(const function<R(P1, P2, P3)> &f, size_t capacity)
+{
+	typedef storage3<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3)>, K> F;
+	typedef storage3<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4>
+function<R(P1, P2, P3, P4)> memoize(const function<R(P1, P2, P3, P4)> &f, size_t capacity)
+{
+	typedef storage4<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4)>, K> F;
+	typedef storage4<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
+function<R(P1, P2, P3, P4, P5)> memoize(const function<R(P1, P2, P3, P4, P5)> &f, size_t capacity)
+{
+	typedef storage5<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type, typename _memoize::value_of<P5>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4, P5)>, K> F;
+	typedef storage5<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)(), Argc<5>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	Argc<5> (*a5)() = placeholders::_5;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4, a5));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+function<R(P1, P2, P3, P4, P5, P6)> memoize(const function<R(P1, P2, P3, P4, P5, P6)> &f, size_t capacity)
+{
+	typedef storage6<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type, typename _memoize::value_of<P5>::type, typename _memoize::value_of<P6>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4, P5, P6)>, K> F;
+	typedef storage6<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)(), Argc<5>(*)(), Argc<6>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	Argc<5> (*a5)() = placeholders::_5;
+	Argc<6> (*a6)() = placeholders::_6;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4, a5, a6));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+function<R(P1, P2, P3, P4, P5, P6, P7)> memoize(const function<R(P1, P2, P3, P4, P5, P6, P7)> &f, size_t capacity)
+{
+	typedef storage7<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type, typename _memoize::value_of<P5>::type, typename _memoize::value_of<P6>::type, typename _memoize::value_of<P7>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4, P5, P6, P7)>, K> F;
+	typedef storage7<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)(), Argc<5>(*)(), Argc<6>(*)(), Argc<7>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	Argc<5> (*a5)() = placeholders::_5;
+	Argc<6> (*a6)() = placeholders::_6;
+	Argc<7> (*a7)() = placeholders::_7;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4, a5, a6, a7));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+function<R(P1, P2, P3, P4, P5, P6, P7, P8)> memoize(const function<R(P1, P2, P3, P4, P5, P6, P7, P8)> &f, size_t capacity)
+{
+	typedef storage8<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type, typename _memoize::value_of<P5>::type, typename _memoize::value_of<P6>::type, typename _memoize::value_of<P7>::type, typename _memoize::value_of<P8>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4, P5, P6, P7, P8)>, K> F;
+	typedef storage8<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)(), Argc<5>(*)(), Argc<6>(*)(), Argc<7>(*)(), Argc<8>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	Argc<5> (*a5)() = placeholders::_5;
+	Argc<6> (*a6)() = placeholders::_6;
+	Argc<7> (*a7)() = placeholders::_7;
+	Argc<8> (*a8)() = placeholders::_8;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4, a5, a6, a7, a8));
+}
+template<typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> memoize(const function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)> &f, size_t capacity)
+{
+	typedef storage9<typename _memoize::value_of<P1>::type, typename _memoize::value_of<P2>::type, typename _memoize::value_of<P3>::type, typename _memoize::value_of<P4>::type, typename _memoize::value_of<P5>::type, typename _memoize::value_of<P6>::type, typename _memoize::value_of<P7>::type, typename _memoize::value_of<P8>::type, typename _memoize::value_of<P9>::type> K;
+	typedef _memoize::memoizer<R, function<R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>, K> F;
+	typedef storage9<Argc<1>(*)(), Argc<2>(*)(), Argc<3>(*)(), Argc<4>(*)(), Argc<5>(*)(), Argc<6>(*)(), Argc<7>(*)(), Argc<8>(*)(), Argc<9>(*)()> S;
+	Argc<1> (*a1)() = placeholders::_1;
+	Argc<2> (*a2)() = placeholders::_2;
+	Argc<3> (*a3)() = placeholders::_3;
+	Argc<4> (*a4)() = placeholders::_4;
+	Argc<5> (*a5)() = placeholders::_5;
+	Argc<6> (*a6)() = placeholders::_6;
+	Argc<7> (*a7)() = placeholders::_7;
+	Argc<8> (*a8)() = placeholders::_8;
+	Argc<9> (*a9)() = placeholders::_9;
+	return bind_t<R, F, S>(F(f, capacity), S(a1, a2, a3, a4, a5, a6, a7, a8, a9));
+}
+
+//---------------------------memoize---------------------------end
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_MEMOIZE_HPP_
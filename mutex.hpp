@@ -0,0 +1,101 @@
+/**
+ * @file      mutex.hpp
+ * @brief     實作 std::mutex 的簡易版
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 只提供 mutex 與 lock_guard 這兩樣最常用的東西
+ * POSIX 環境底下用 pthread，Windows 則用 CRITICAL_SECTION
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_MUTEX_HPP_
+#define _STD_MUTEX_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧
+#if __cplusplus > 201100L
+
+#include <mutex>
+
+// 強制使用本函式庫的時候，其他工具會在functional這個namespace裡找mutex
+#if defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+namespace functional{ using std::mutex; using std::lock_guard; }
+#endif
+
+#else
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace std{
+
+/// 不可遞迴鎖定的互斥鎖
+class mutex
+{
+	public:
+
+	#if defined(_WIN32)
+		typedef CRITICAL_SECTION*   native_handle_type;
+
+		mutex()                     { InitializeCriticalSection(&m_); }
+		~mutex()                    { DeleteCriticalSection(&m_); }
+
+		inline void lock()          { EnterCriticalSection(&m_); }
+		inline bool try_lock()      { return TryEnterCriticalSection(&m_)!=0; }
+		inline void unlock()        { LeaveCriticalSection(&m_); }
+	#else
+		typedef pthread_mutex_t*    native_handle_type;
+
+		mutex()                     { pthread_mutex_init(&m_,0); }
+		~mutex()                    { pthread_mutex_destroy(&m_); }
+
+		inline void lock()          { pthread_mutex_lock(&m_); }
+		inline bool try_lock()      { return pthread_mutex_trylock(&m_)==0; }
+		inline void unlock()        { pthread_mutex_unlock(&m_); }
+	#endif
+
+		// 給condition_variable這類需要直接操作底層物件的工具使用
+		inline native_handle_type native_handle() { return &m_; }
+
+	private:
+
+		mutex(const mutex&);                // 互斥鎖不允許複製
+		mutex& operator=(const mutex&);
+
+	#if defined(_WIN32)
+		CRITICAL_SECTION    m_;
+	#else
+		pthread_mutex_t     m_;
+	#endif
+};
+
+/// 建構時上鎖，解構時解鎖
+template<typename M>
+class lock_guard
+{
+	public:
+
+		typedef M mutex_type;
+
+		explicit lock_guard(M &m):m_(m){ m_.lock(); }
+		~lock_guard(){ m_.unlock(); }
+
+	private:
+
+		lock_guard(const lock_guard&);
+		lock_guard& operator=(const lock_guard&);
+
+		M   &m_;
+};
+
+}//namespace std
+
+
+#endif//__cplusplus > 201100L
+#endif//_STD_MUTEX_HPP_
@@ -0,0 +1,615 @@
+/**
+ * @file      parallel.hpp
+ * @brief     把迴圈或數個函式分給執行緒池平行執行的 parallel_for 與 parallel_invoke
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     // body(b, e)負責處理[b, e)，每次至少拿到grain個
+ *     std::parallel_for(0, height, 16, std::bind(&Image::BlurRows, &img, std::placeholders::_1, std::placeholders::_2));
+ *     std::parallel_for(0, n, 1024, &ScaleRange);                  // void ScaleRange(int, int)
+ *
+ *     std::parallel_invoke(&LoadMeshes, &LoadTextures, std::bind(&Audio::Load, &audio));
+ *
+ *     std::parallel_pool pool(3);                                 // 也可以指定自己的執行緒池
+ *     std::parallel_for(pool, 0, n, 256, body);
+ *
+ * 呼叫端的執行緒也會一起做，全部做完才返回(fork-join)
+ * 區段用一個原子計數器分配，先拿的拿大塊，剩下越少拿越小塊(guided)，快的執行緒自然會多做一點
+ * 所有執行緒呼叫的都是同一個body，不會替每個區段或每條執行緒複製一份
+ * 所以body必須能被多條執行緒同時呼叫
+ *
+ * body裡面可以再呼叫parallel_for，等待時沒被領走的名額會收回來自己做，不會卡死
+ * 沒指定執行緒池時使用全域的池，第一次用到才建立，執行緒數量是CPU數量減一
+ * body不可以丟出例外
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_PARALLEL_HPP_
+#define _STD_PARALLEL_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <functional.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _parallel{
+
+/// 一次fork-join的工作，放在呼叫端的堆疊上
+struct job
+{
+	job():slots(0),active(0){}
+	virtual ~job(){}
+
+	virtual void run() = 0;     // 每條參與的執行緒都會呼叫，做到沒東西可拿為止
+
+	size_t  slots;      // 還能再加入幾條執行緒，歸0時從佇列拿掉
+	size_t  active;     // 正在run()的工作執行緒，歸0才算結束(latch)
+};
+
+/// parallel_for的工作< body的type >
+template<typename F>
+struct for_job : job
+{
+	for_job(const F &f, int begin, int end, int grain, long ways)
+		:body(f),end_(end),grain_(grain),ways_(ways),next_(begin){}
+
+	virtual void run()
+	{
+		long b = next_.load();
+
+		while ( b < end_ )
+		{
+			// 剩下的平分給所有執行緒之後再折半，但不小於grain
+			long size = (end_ - b) / (2*ways_);
+
+			if ( size < grain_ ) size = grain_;
+
+			long e = end_ - b > size ? b + size : end_;
+
+			if ( next_.compare_exchange_weak(b, e) )
+			{
+				body(int(b), int(e));
+				b = next_.load();
+			}
+		}
+	}
+
+	const F         &body;      // 所有執行緒共用呼叫端的那一份
+	long            end_;
+	long            grain_;
+	long            ways_;
+	atomic<long>    next_;      // 下一個還沒被拿走的位置
+};
+
+}//namespace _parallel
+
+
+/// parallel_for與parallel_invoke使用的執行緒池
+class parallel_pool
+{
+	public:
+
+		/// threads是額外的工作執行緒數量，呼叫端的執行緒不算在內
+		explicit parallel_pool(size_t threads):stop_(false)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&work_, 0);
+			pthread_cond_init(&done_, 0);
+
+			threads_.reserve(threads);
+
+			// 建不起來的就算了，size()與fork_join()的幫手數量只算真的有在跑的
+			for ( size_t i=0 ; i<threads ; i++ )
+			{
+				pthread_t th;
+
+				if ( pthread_create(&th, 0, &parallel_pool::worker_main, this)==0 )
+				{
+					threads_.push_back(th);
+				}
+			}
+		}
+
+		~parallel_pool()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_broadcast(&work_);
+			pthread_mutex_unlock(&lock_);
+
+			for ( size_t i=0 ; i<threads_.size() ; i++ )
+			{
+				pthread_join(threads_[i], 0);
+			}
+
+			pthread_cond_destroy(&done_);
+			pthread_cond_destroy(&work_);
+			pthread_mutex_destroy(&lock_);
+		}
+
+		/// 沒指定執行緒池時用的全域池
+		static parallel_pool& global()
+		{
+			static parallel_pool pool(default_threads());
+			return pool;
+		}
+
+		/// 實際建立成功的工作執行緒數量，可能比要求的少
+		inline size_t size() const { return threads_.size(); }
+
+		/// 讓最多helpers條工作執行緒跟呼叫端一起執行j.run()，全部結束才返回
+		void fork_join(_parallel::job &j, size_t helpers)
+		{
+			if ( helpers > threads_.size() ) helpers = threads_.size();
+
+			if ( helpers )
+			{
+				pthread_mutex_lock(&lock_);
+				j.slots  = helpers;
+				j.active = 0;
+				queue_.push_back(&j);
+				pthread_cond_broadcast(&work_);
+				pthread_mutex_unlock(&lock_);
+			}
+
+			j.run();
+
+			if ( !helpers ) return;
+
+			pthread_mutex_lock(&lock_);
+
+			// 自己已經做完了，還沒被領走的名額收回來
+			if ( j.slots )
+			{
+				for ( std::deque<_parallel::job*>::iterator i = queue_.begin() ; i != queue_.end() ; ++i )
+				{
+					if ( *i==&j )
+					{
+						queue_.erase(i);
+						break;
+					}
+				}
+
+				j.slots = 0;
+			}
+
+			while ( j.active )
+			{
+				pthread_cond_wait(&done_, &lock_);
+			}
+
+			pthread_mutex_unlock(&lock_);
+		}
+
+	private:
+
+		parallel_pool(const parallel_pool&);        // 不允許複製
+		parallel_pool& operator=(const parallel_pool&);
+
+		static size_t default_threads()
+		{
+			long n = sysconf(_SC_NPROCESSORS_ONLN);
+			return n > 1 ? size_t(n-1) : 0;
+		}
+
+		static void* worker_main(void *p)
+		{
+			static_cast<parallel_pool*>(p)->worker();
+			return 0;
+		}
+
+		void worker()
+		{
+			pthread_mutex_lock(&lock_);
+
+			for (;;)
+			{
+				while ( queue_.empty() && !stop_ )
+				{
+					pthread_cond_wait(&work_, &lock_);
+				}
+
+				if ( stop_ ) break;
+
+				_parallel::job *j = queue_.front();
+
+				if ( --j->slots==0 ) queue_.pop_front();
+
+				j->active++;
+				pthread_mutex_unlock(&lock_);
+
+				j->run();
+
+				pthread_mutex_lock(&lock_);
+
+				if ( --j->active==0 ) pthread_cond_broadcast(&done_);
+			}
+
+			pthread_mutex_unlock(&lock_);
+		}
+
+		pthread_mutex_t                 lock_;
+		pthread_cond_t                  work_;      // 佇列有工作了
+		pthread_cond_t                  done_;      // 某個工作的latch歸0了
+		std::deque<_parallel::job*>     queue_;
+		std::vector<pthread_t>          threads_;
+		bool                            stop_;
+};
+
+
+/// 把[begin, end)切成至少grain個一段，交給body(b, e)平行處理
+template<typename F>
+void parallel_for(parallel_pool &pool, int begin, int end, int grain, const F &body)
+{
+	if ( grain < 1 ) grain = 1;
+	if ( begin >= end ) return;
+
+	long chunks = (long(end) - begin + grain - 1) / grain;
+
+	if ( chunks==1 || pool.size()==0 )
+	{
+		body(begin, end);
+		return;
+	}
+
+	size_t helpers = size_t(chunks-1) < pool.size() ? size_t(chunks-1) : pool.size();
+	_parallel::for_job<F> j(body, begin, end, grain, long(helpers+1));
+	pool.fork_join(j, helpers);
+}
+
+template<typename F>
+inline void parallel_for(int begin, int end, int grain, const F &body)
+{
+	parallel_for(parallel_pool::global(), begin, end, grain, body);
+}
+
+
+namespace _parallel{
+
+/// parallel_invoke的兩個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2>
+struct invoke2
+{
+	invoke2(const F1 &g1, const F2 &g2):f1(g1),f2(g2){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+};
+
+/// parallel_invoke的三個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3>
+struct invoke3
+{
+	invoke3(const F1 &g1, const F2 &g2, const F3 &g3):f1(g1),f2(g2),f3(g3){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+};
+
+/// parallel_invoke的四個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4>
+struct invoke4
+{
+	invoke4(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4):f1(g1),f2(g2),f3(g3),f4(g4){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+};
+
+/// parallel_invoke的五個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4, typename F5>
+struct invoke5
+{
+	invoke5(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4, const F5 &g5):f1(g1),f2(g2),f3(g3),f4(g4),f5(g5){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+				case 4: f5(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+	const F5	&f5;
+};
+
+/// parallel_invoke的六個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6>
+struct invoke6
+{
+	invoke6(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4, const F5 &g5, const F6 &g6):f1(g1),f2(g2),f3(g3),f4(g4),f5(g5),f6(g6){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+				case 4: f5(); break;
+				case 5: f6(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+	const F5	&f5;
+	const F6	&f6;
+};
+
+/// parallel_invoke的七個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7>
+struct invoke7
+{
+	invoke7(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4, const F5 &g5, const F6 &g6, const F7 &g7):f1(g1),f2(g2),f3(g3),f4(g4),f5(g5),f6(g6),f7(g7){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+				case 4: f5(); break;
+				case 5: f6(); break;
+				case 6: f7(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+	const F5	&f5;
+	const F6	&f6;
+	const F7	&f7;
+};
+
+/// parallel_invoke的八個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8>
+struct invoke8
+{
+	invoke8(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4, const F5 &g5, const F6 &g6, const F7 &g7, const F8 &g8):f1(g1),f2(g2),f3(g3),f4(g4),f5(g5),f6(g6),f7(g7),f8(g8){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+				case 4: f5(); break;
+				case 5: f6(); break;
+				case 6: f7(); break;
+				case 7: f8(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+	const F5	&f5;
+	const F6	&f6;
+	const F7	&f7;
+	const F8	&f8;
+};
+
+/// parallel_invoke的九個函式版本，第i個位置就是第i個函式
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8, typename F9>
+struct invoke9
+{
+	invoke9(const F1 &g1, const F2 &g2, const F3 &g3, const F4 &g4, const F5 &g5, const F6 &g6, const F7 &g7, const F8 &g8, const F9 &g9):f1(g1),f2(g2),f3(g3),f4(g4),f5(g5),f6(g6),f7(g7),f8(g8),f9(g9){}
+
+	void operator()(int b, int e) const
+	{
+		for ( int i=b ; i<e ; i++ )
+		{
+			switch ( i )
+			{
+				case 0: f1(); break;
+				case 1: f2(); break;
+				case 2: f3(); break;
+				case 3: f4(); break;
+				case 4: f5(); break;
+				case 5: f6(); break;
+				case 6: f7(); break;
+				case 7: f8(); break;
+				case 8: f9(); break;
+			}
+		}
+	}
+
+	const F1	&f1;
+	const F2	&f2;
+	const F3	&f3;
+	const F4	&f4;
+	const F5	&f5;
+	const F6	&f6;
+	const F7	&f7;
+	const F8	&f8;
+	const F9	&f9;
+};
+
+}//namespace _parallel
+
+
+/// 平行執行所有函式，全部做完才返回
+template<typename F1, typename F2>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2)
+{
+	parallel_for(pool, 0, 2, 1, _parallel::invoke2<F1, F2>(f1, f2));
+}
+template<typename F1, typename F2>
+inline void parallel_invoke(const F1 &f1, const F2 &f2)
+{
+	parallel_for(parallel_pool::global(), 0, 2, 1, _parallel::invoke2<F1, F2>(f1, f2));
+}
+
+template<typename F1, typename F2, typename F3>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3)
+{
+	parallel_for(pool, 0, 3, 1, _parallel::invoke3<F1, F2, F3>(f1, f2, f3));
+}
+template<typename F1, typename F2, typename F3>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3)
+{
+	parallel_for(parallel_pool::global(), 0, 3, 1, _parallel::invoke3<F1, F2, F3>(f1, f2, f3));
+}
+
+template<typename F1, typename F2, typename F3, typename F4>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4)
+{
+	parallel_for(pool, 0, 4, 1, _parallel::invoke4<F1, F2, F3, F4>(f1, f2, f3, f4));
+}
+template<typename F1, typename F2, typename F3, typename F4>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4)
+{
+	parallel_for(parallel_pool::global(), 0, 4, 1, _parallel::invoke4<F1, F2, F3, F4>(f1, f2, f3, f4));
+}
+
+template<typename F1, typename F2, typename F3, typename F4, typename F5>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5)
+{
+	parallel_for(pool, 0, 5, 1, _parallel::invoke5<F1, F2, F3, F4, F5>(f1, f2, f3, f4, f5));
+}
+template<typename F1, typename F2, typename F3, typename F4, typename F5>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5)
+{
+	parallel_for(parallel_pool::global(), 0, 5, 1, _parallel::invoke5<F1, F2, F3, F4, F5>(f1, f2, f3, f4, f5));
+}
+
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6)
+{
+	parallel_for(pool, 0, 6, 1, _parallel::invoke6<F1, F2, F3, F4, F5, F6>(f1, f2, f3, f4, f5, f6));
+}
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6)
+{
+	parallel_for(parallel_pool::global(), 0, 6, 1, _parallel::invoke6<F1, F2, F3, F4, F5, F6>(f1, f2, f3, f4, f5, f6));
+}
+
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7)
+{
+	parallel_for(pool, 0, 7, 1, _parallel::invoke7<F1, F2, F3, F4, F5, F6, F7>(f1, f2, f3, f4, f5, f6, f7));
+}
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7)
+{
+	parallel_for(parallel_pool::global(), 0, 7, 1, _parallel::invoke7<F1, F2, F3, F4, F5, F6, F7>(f1, f2, f3, f4, f5, f6, f7));
+}
+
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7, const F8 &f8)
+{
+	parallel_for(pool, 0, 8, 1, _parallel::invoke8<F1, F2, F3, F4, F5, F6, F7, F8>(f1, f2, f3, f4, f5, f6, f7, f8));
+}
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7, const F8 &f8)
+{
+	parallel_for(parallel_pool::global(), 0, 8, 1, _parallel::invoke8<F1, F2, F3, F4, F5, F6, F7, F8>(f1, f2, f3, f4, f5, f6, f7, f8));
+}
+
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8, typename F9>
+inline void parallel_invoke(parallel_pool &pool, const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7, const F8 &f8, const F9 &f9)
+{
+	parallel_for(pool, 0, 9, 1, _parallel::invoke9<F1, F2, F3, F4, F5, F6, F7, F8, F9>(f1, f2, f3, f4, f5, f6, f7, f8, f9));
+}
+template<typename F1, typename F2, typename F3, typename F4, typename F5, typename F6, typename F7, typename F8, typename F9>
+inline void parallel_invoke(const F1 &f1, const F2 &f2, const F3 &f3, const F4 &f4, const F5 &f5, const F6 &f6, const F7 &f7, const F8 &f8, const F9 &f9)
+{
+	parallel_for(parallel_pool::global(), 0, 9, 1, _parallel::invoke9<F1, F2, F3, F4, F5, F6, F7, F8, F9>(f1, f2, f3, f4, f5, f6, f7, f8, f9));
+}
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_PARALLEL_HPP_
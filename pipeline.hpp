@@ -0,0 +1,679 @@
+/**
+ * @file      pipeline.hpp
+ * @brief     每個階段各自一條執行緒，之間用有界的單生產者單消費者環狀緩衝區串起來的流水線
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::pipeline<Packet> p(1024);                  // 每條環狀緩衝區的容量
+ *     p.stage(&Decode)                                // Frame Decode(const Packet&)
+ *      .stage(std::bind(&Parser::Parse, &parser, _1), 3)      // 3個副本平行執行
+ *      .stage(&Enrich)
+ *      .sink(std::bind(&Writer::Write, &writer, _1));  // 最後一個階段，沒有輸出
+ *
+ *     while ( ... ) p.push(packet);                   // 只能由一個執行緒push()
+ *     p.close();                                      // 等所有資料流完並結束執行緒
+ *
+ * 階段可以是一般函式、bind()的回傳值或function，輸出的type從回傳值推導出來
+ * 相鄰兩階段的每一對執行緒之間各有一條環狀緩衝區，生產端輪流分給下游的副本，消費端也輪流從上游的副本拿
+ * 所以只要沒有兩個相鄰的階段都開副本，資料到最後一個階段時的順序就跟push()的順序一樣
+ *
+ * 讀寫的位置各自放在不同的cache line，兩端都先看自己快取的對方位置，真的不夠了才去讀對方的
+ * 寫入端累積一批才公開新的位置，讀取端也是一批才歸還空間，閒下來之前一定會先公開
+ * 緩衝區滿了就在原地等，上游自然跟著慢下來
+ *
+ * 建不起來的執行緒就不算那個副本，接到它的緩衝區會被拿掉，順序一樣不會亂
+ * 某個階段一條執行緒都建不起來的話，sink() 之後 running() 是 false，push() 一律回傳 false
+ *
+ * 資料的type必須有預設建構子並且可以指定，階段不可以丟出例外
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_PIPELINE_HPP_
+#define _STD_PIPELINE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <functional.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+template<typename In> class pipeline;
+
+namespace _pipeline{
+
+enum
+{
+	cache_line = 64
+};
+
+/// 等待對方時先讓出CPU，等久了就開始睡
+struct backoff
+{
+	backoff():n(0){}
+
+	void wait()
+	{
+		if ( ++n < 64 )
+		{
+			sched_yield();
+		}
+		else
+		{
+			timespec t = { 0, 50*1000 };
+			nanosleep(&t, 0);
+		}
+	}
+
+	inline void reset() { n = 0; }
+
+	unsigned    n;
+};
+
+/// 有界的單生產者單消費者環狀緩衝區< 資料的type >
+template<typename T>
+class ring
+{
+	public:
+
+		explicit ring(size_t capacity)
+			:dropped(false),head_(0),cached_tail_(0),local_head_(0),tail_(0),cached_head_(0),local_tail_(0),closed_(0)
+		{
+			size_t cap = 2;
+
+			while ( cap < capacity ) cap <<= 1;
+
+			buf_   = new T[cap];
+			mask_  = cap-1;
+			batch_ = cap/4 < 32 ? cap/4 : 32;
+		}
+
+		~ring() { delete [] buf_; }
+
+		//-----------------------------------生產端-----------------------------------start
+
+		// 滿了就回傳false
+		bool try_push(const T &v)
+		{
+			if ( local_tail_ - cached_head_ > mask_ )
+			{
+				cached_head_ = head_.load(memory_order_acquire);
+
+				if ( local_tail_ - cached_head_ > mask_ ) return false;
+			}
+
+			buf_[local_tail_ & mask_] = v;
+			local_tail_++;
+
+			if ( local_tail_ - tail_.load(memory_order_relaxed) >= batch_ ) flush();
+
+			return true;
+		}
+
+		// 把累積的資料公開給消費端
+		inline void flush()
+		{
+			tail_.store(local_tail_, memory_order_release);
+		}
+
+		// 之後不會再有資料了
+		inline void close()
+		{
+			flush();
+			closed_.store(1, memory_order_release);
+		}
+
+		//-----------------------------------生產端-----------------------------------end
+
+		//-----------------------------------消費端-----------------------------------start
+
+		// 空的就回傳false
+		bool try_pop(T &v)
+		{
+			if ( local_head_ == cached_tail_ )
+			{
+				release();      // 看起來空了，先把空間還給生產端
+				cached_tail_ = tail_.load(memory_order_acquire);
+
+				if ( local_head_ == cached_tail_ ) return false;
+			}
+
+			v = buf_[local_head_ & mask_];
+			local_head_++;
+
+			if ( local_head_ - head_.load(memory_order_relaxed) >= batch_ ) release();
+
+			return true;
+		}
+
+		// 空了而且生產端已經關閉
+		inline bool finished()
+		{
+			if ( !closed_.load(memory_order_acquire) ) return false;
+
+			return local_head_ == tail_.load(memory_order_acquire);
+		}
+
+		//-----------------------------------消費端-----------------------------------end
+
+		bool            dropped;        // 消費端的執行緒沒建起來，生產端啟動前會把它拿掉
+
+	private:
+
+		ring(const ring&);
+		ring& operator=(const ring&);
+
+		inline void release()
+		{
+			head_.store(local_head_, memory_order_release);
+		}
+
+		T               *buf_;
+		size_t          mask_;
+		size_t          batch_;
+
+		char            pad0_[cache_line];
+
+		// 消費端
+		atomic<size_t>  head_;          // 公開給生產端看的讀取位置
+		size_t          cached_tail_;
+		size_t          local_head_;
+
+		char            pad1_[cache_line];
+
+		// 生產端
+		atomic<size_t>  tail_;          // 公開給消費端看的寫入位置
+		size_t          cached_head_;
+		size_t          local_tail_;
+
+		char            pad2_[cache_line];
+
+		atomic<int>     closed_;
+};
+
+/// 一條執行緒的輸出端，輪流寫進下游每個副本的緩衝區
+template<typename T>
+struct outlet
+{
+	outlet():next(0){}
+
+	void put(const T &v)
+	{
+		ring<T> *r = rings[next];
+
+		if ( !r->try_push(v) )
+		{
+			backoff b;
+			r->flush();
+
+			while ( !r->try_push(v) )
+			{
+				b.wait();       // 下游跟不上，在這裡等
+			}
+		}
+
+		if ( ++next==rings.size() ) next = 0;
+	}
+
+	void flush()
+	{
+		for ( size_t i=0 ; i<rings.size() ; i++ ) rings[i]->flush();
+	}
+
+	void close()
+	{
+		for ( size_t i=0 ; i<rings.size() ; i++ ) rings[i]->close();
+	}
+
+	// 拿掉沒有消費端的緩衝區，只能在這個輸出端的執行緒開始之前呼叫
+	void prune()
+	{
+		size_t n = 0;
+
+		for ( size_t i=0 ; i<rings.size() ; i++ )
+		{
+			if ( !rings[i]->dropped ) rings[n++] = rings[i];
+		}
+
+		rings.resize(n);
+	}
+
+	std::vector<ring<T>*>   rings;
+	size_t                  next;
+};
+
+/// 一條執行緒的輸入端，輪流從上游每個副本的緩衝區拿，緩衝區由這裡負責刪除
+template<typename T>
+struct inlet
+{
+	enum result
+	{
+		got,
+		empty,
+		finished
+	};
+
+	inlet():next(0){}
+
+	// 按照順序拿，輪到的那條還沒資料就回傳empty
+	result try_get(T &v)
+	{
+		for ( size_t tries=0 ; tries<rings.size() ; tries++ )
+		{
+			ring<T> *r = rings[next];
+
+			if ( r->try_pop(v) )
+			{
+				advance();
+				return got;
+			}
+
+			if ( !r->finished() ) return empty;
+
+			// 這個上游已經結束，跳過它
+			advance();
+		}
+
+		return finished;
+	}
+
+	inline void advance()
+	{
+		if ( ++next==rings.size() ) next = 0;
+	}
+
+	void destroy()
+	{
+		for ( size_t i=0 ; i<rings.size() ; i++ ) delete rings[i];
+		rings.clear();
+	}
+
+	// 這條執行緒沒建起來，告訴上游不要再往這裡送
+	void drop()
+	{
+		for ( size_t i=0 ; i<rings.size() ; i++ ) rings[i]->dropped = true;
+	}
+
+	std::vector<ring<T>*>   rings;
+	size_t                  next;
+};
+
+/// 從仿函式取得階段的輸出type
+template<typename F> struct result_of
+{
+	typedef typename untie_ref<typename F::result_type>::type type;
+};
+
+template<typename R, typename A>
+struct result_of<R (*)(A)>
+{
+	typedef typename untie_ref<R>::type type;
+};
+
+/// 所有階段的共同介面
+struct stage_base
+{
+	virtual ~stage_base(){}
+
+	virtual bool start() = 0;       // 下游都啟動之後才會被呼叫，一條執行緒都沒建起來時回傳false
+	virtual void join() = 0;
+};
+
+/// 中間的階段< 輸入type , 輸出type , 仿函式 >
+template<typename In, typename Out, typename F>
+struct stage : stage_base
+{
+	struct worker
+	{
+		explicit worker(const F &fn):f(fn),thread(),started(false){}
+
+		static void* main(void *p)
+		{
+			worker *w = static_cast<worker*>(p);
+			In v;
+			backoff b;
+
+			for (;;)
+			{
+				typename inlet<In>::result r = w->in.try_get(v);
+
+				if ( r==inlet<In>::got )
+				{
+					w->out.put(w->f(v));
+					b.reset();
+				}
+				else if ( r==inlet<In>::finished )
+				{
+					break;
+				}
+				else
+				{
+					w->out.flush();     // 閒下來之前先把手上的交出去
+					b.wait();
+				}
+			}
+
+			w->out.close();
+			return 0;
+		}
+
+		F               f;
+		inlet<In>       in;
+		outlet<Out>     out;
+		pthread_t       thread;
+		bool            started;
+	};
+
+	stage(const F &f, size_t replicas):workers(replicas ? replicas : 1, worker(f)){}
+
+	~stage()
+	{
+		for ( size_t i=0 ; i<workers.size() ; i++ ) workers[i].in.destroy();
+	}
+
+	virtual bool start()
+	{
+		size_t started = 0;
+
+		for ( size_t i=0 ; i<workers.size() ; i++ )
+		{
+			worker &w = workers[i];
+			w.out.prune();
+
+			w.started = pthread_create(&w.thread, 0, &worker::main, &w)==0;
+
+			if ( w.started )
+			{
+				started++;
+			}
+			else
+			{
+				// 建不起來的副本：上游不要再送過來，下游也不必等它
+				w.in.drop();
+				w.out.close();
+			}
+		}
+
+		return started > 0;
+	}
+
+	virtual void join()
+	{
+		for ( size_t i=0 ; i<workers.size() ; i++ )
+		{
+			if ( workers[i].started ) pthread_join(workers[i].thread, 0);
+
+			workers[i].started = false;
+		}
+	}
+
+	std::vector<worker>     workers;        // 建構後大小固定，位址不會變
+};
+
+/// 最後一個階段，沒有輸出< 輸入type , 仿函式 >
+template<typename In, typename F>
+struct sink_stage : stage_base
+{
+	struct worker
+	{
+		explicit worker(const F &fn):f(fn),thread(),started(false){}
+
+		static void* main(void *p)
+		{
+			worker *w = static_cast<worker*>(p);
+			In v;
+			backoff b;
+
+			for (;;)
+			{
+				typename inlet<In>::result r = w->in.try_get(v);
+
+				if ( r==inlet<In>::got )
+				{
+					w->f(v);
+					b.reset();
+				}
+				else if ( r==inlet<In>::finished )
+				{
+					break;
+				}
+				else
+				{
+					b.wait();
+				}
+			}
+
+			return 0;
+		}
+
+		F               f;
+		inlet<In>       in;
+		pthread_t       thread;
+		bool            started;
+	};
+
+	sink_stage(const F &f, size_t replicas):workers(replicas ? replicas : 1, worker(f)){}
+
+	~sink_stage()
+	{
+		for ( size_t i=0 ; i<workers.size() ; i++ ) workers[i].in.destroy();
+	}
+
+	virtual bool start()
+	{
+		size_t started = 0;
+
+		for ( size_t i=0 ; i<workers.size() ; i++ )
+		{
+			worker &w = workers[i];
+			w.started = pthread_create(&w.thread, 0, &worker::main, &w)==0;
+
+			if ( w.started ) started++;
+			else             w.in.drop();       // 上游不要再送過來
+		}
+
+		return started > 0;
+	}
+
+	virtual void join()
+	{
+		for ( size_t i=0 ; i<workers.size() ; i++ )
+		{
+			if ( workers[i].started ) pthread_join(workers[i].thread, 0);
+
+			workers[i].started = false;
+		}
+	}
+
+	std::vector<worker>     workers;
+};
+
+// 在上游的每個輸出端與下游的每個輸入端之間各接一條緩衝區
+template<typename T, typename W>
+inline void connect(const std::vector<outlet<T>*> &up, std::vector<W> &down, size_t capacity)
+{
+	for ( size_t i=0 ; i<up.size() ; i++ )
+	{
+		for ( size_t j=0 ; j<down.size() ; j++ )
+		{
+			ring<T> *r = new ring<T>(capacity);
+			up[i]->rings.push_back(r);
+			down[j].in.rings.push_back(r);
+		}
+	}
+}
+
+/// 串接階段用的暫時物件< 來源的type , 目前最後一個階段的輸出type >
+template<typename In, typename T>
+class builder
+{
+	public:
+
+		builder(pipeline<In> *p, const std::vector<outlet<T>*> &up):p_(p),up_(up){}
+
+		/// 再接一個階段，replicas是平行執行的副本數量
+		template<typename F>
+		builder<In, typename result_of<F>::type> stage(const F &f, size_t replicas = 1)
+		{
+			typedef typename result_of<F>::type Out;
+			typedef _pipeline::stage<T,Out,F> S;
+
+			S *s = new S(f, replicas);
+			p_->stages_.push_back(s);
+			connect(up_, s->workers, p_->capacity_);
+
+			std::vector<outlet<Out>*> outs;
+
+			for ( size_t i=0 ; i<s->workers.size() ; i++ )
+			{
+				outs.push_back(&s->workers[i].out);
+			}
+
+			return builder<In,Out>(p_, outs);
+		}
+
+		/// 接上最後一個階段並開始執行，有階段一條執行緒都建不起來時流水線不會運作，見running()
+		template<typename F>
+		pipeline<In>& sink(const F &f, size_t replicas = 1)
+		{
+			typedef sink_stage<T,F> S;
+
+			S *s = new S(f, replicas);
+			p_->stages_.push_back(s);
+			connect(up_, s->workers, p_->capacity_);
+			p_->start();
+			return *p_;
+		}
+
+	private:
+
+		pipeline<In>                *p_;
+		std::vector<outlet<T>*>     up_;
+};
+
+}//namespace _pipeline
+
+
+/// 多階段流水線< 送進來的資料type >
+template<typename In>
+class pipeline
+{
+	public:
+
+		/// capacity是每條緩衝區的容量，會調成2的次方
+		explicit pipeline(size_t capacity = 1024):capacity_(capacity),running_(false){}
+
+		~pipeline()
+		{
+			close();
+
+			for ( size_t i=0 ; i<stages_.size() ; i++ ) delete stages_[i];
+		}
+
+		/// 接上第一個階段
+		template<typename F>
+		_pipeline::builder<In, typename _pipeline::result_of<F>::type> stage(const F &f, size_t replicas = 1)
+		{
+			return source().stage(f, replicas);
+		}
+
+		/// 只有一個階段的流水線
+		template<typename F>
+		pipeline& sink(const F &f, size_t replicas = 1)
+		{
+			return source().sink(f, replicas);
+		}
+
+		/// 送進一筆資料，下游滿了就會等，還沒接上sink()或已經close()時回傳false
+		bool push(const In &v)
+		{
+			if ( !running_ ) return false;
+
+			out_.put(v);
+			return true;
+		}
+
+		/// sink()之後所有階段都有執行緒在跑，而且還沒close()
+		inline bool running() const { return running_; }
+
+		/// 把目前累積的資料交給下游，不必等到湊滿一批
+		void flush()
+		{
+			if ( running_ ) out_.flush();
+		}
+
+		/// 不會再有新資料，等所有資料流完並結束所有執行緒
+		void close()
+		{
+			if ( !running_ ) return;
+
+			running_ = false;
+			out_.close();
+
+			for ( size_t i=0 ; i<stages_.size() ; i++ ) stages_[i]->join();
+		}
+
+	private:
+
+		template<typename A, typename B> friend class _pipeline::builder;
+
+		pipeline(const pipeline&);              // 不允許複製
+		pipeline& operator=(const pipeline&);
+
+		_pipeline::builder<In,In> source()
+		{
+			std::vector<_pipeline::outlet<In>*> up(1, &out_);
+			return _pipeline::builder<In,In>(this, up);
+		}
+
+		// 從下游開始啟動，沒建起來的副本在上游的執行緒開始之前就從上游拿掉
+		void start()
+		{
+			size_t i = stages_.size();
+
+			while ( i > 0 )
+			{
+				if ( !stages_[i-1]->start() ) break;
+
+				i--;
+			}
+
+			if ( i > 0 )
+			{
+				// 這個階段的輸出都已經關閉，已經啟動的下游會自己結束
+				for ( size_t k=i ; k<stages_.size() ; k++ ) stages_[k]->join();
+
+				return;
+			}
+
+			out_.prune();
+			running_ = true;
+		}
+
+		size_t                              capacity_;
+		_pipeline::outlet<In>               out_;
+		std::vector<_pipeline::stage_base*> stages_;
+		bool                                running_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_PIPELINE_HPP_
@@ -0,0 +1,342 @@
+/**
+ * @file      range.hpp
+ * @brief     可串接 map/filter/take 的惰性資料流
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     int sum = std::make_range(v.begin(), v.end())
+ *                   .map(std::bind(&Scale, _1, 3))
+ *                   .filter(&IsEven)
+ *                   .take(100)
+ *                   .reduce(0, &Add);
+ *
+ * 每個階段都只是把下一個階段包起來，直到呼叫 reduce/for_each/copy/count 才真正開始跑
+ * 整條串接只會走過來源一次，中間不會產生任何暫存容器
+ * 階段可以是一般函式、bind() 的回傳值或 function 物件
+ * 全部都是靜態type的時候，編譯器能把整條串接展開成單一迴圈
+ *
+ * 每個階段在建立時會複製一次前面的階段，請在同一個運算式裡把整條串接寫完
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_RANGE_HPP_
+#define _STD_RANGE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <iterator>
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+namespace _range{
+
+//------------------取得階段的回傳值type------------------start
+
+// bind_t與function都帶有result_type
+template<typename F> struct result_of
+{
+	typedef typename untie_ref<typename F::result_type>::type type;
+};
+
+// 一般函式指標
+template<typename R, typename A1>
+struct result_of<R (*)(A1)>
+{
+	typedef typename untie_ref<R>::type type;
+};
+
+template<typename R, typename A1, typename A2>
+struct result_of<R (*)(A1, A2)>
+{
+	typedef typename untie_ref<R>::type type;
+};
+
+//------------------取得階段的回傳值type------------------end
+
+//------------------sink系列------------------start
+// 來源會把每筆資料推給sink，sink處理完再推給下一個sink
+// 回傳false代表後面不需要更多資料了
+
+template<typename F, typename K>
+struct map_sink
+{
+	map_sink(const F &f, K &k):f_(f),k_(k){}
+
+	template<typename T>
+	inline bool operator()(const T &v)
+	{
+		return k_(f_(v));
+	}
+
+	const F     &f_;
+	K           &k_;
+};
+
+template<typename F, typename K>
+struct filter_sink
+{
+	filter_sink(const F &f, K &k):f_(f),k_(k){}
+
+	template<typename T>
+	inline bool operator()(const T &v)
+	{
+		return f_(v) ? k_(v) : true;
+	}
+
+	const F     &f_;
+	K           &k_;
+};
+
+template<typename K>
+struct take_sink
+{
+	take_sink(size_t n, K &k):n_(n),k_(k){}
+
+	template<typename T>
+	inline bool operator()(const T &v)
+	{
+		return k_(v) && --n_ > 0;
+	}
+
+	size_t      n_;     // 還可以放行幾筆
+	K           &k_;
+};
+
+template<typename T, typename F>
+struct reduce_sink
+{
+	reduce_sink(const T &init, const F &f):acc(init),f_(f){}
+
+	template<typename V>
+	inline bool operator()(const V &v)
+	{
+		acc = f_(acc, v);
+		return true;
+	}
+
+	T           acc;
+	const F     &f_;
+};
+
+template<typename F>
+struct for_each_sink
+{
+	explicit for_each_sink(const F &f):f_(f){}
+
+	template<typename V>
+	inline bool operator()(const V &v)
+	{
+		f_(v);
+		return true;
+	}
+
+	const F     &f_;
+};
+
+template<typename O>
+struct copy_sink
+{
+	explicit copy_sink(O o):out(o){}
+
+	template<typename V>
+	inline bool operator()(const V &v)
+	{
+		*out = v;
+		++out;
+		return true;
+	}
+
+	O           out;
+};
+
+struct count_sink
+{
+	count_sink():n(0){}
+
+	template<typename V>
+	inline bool operator()(const V &)
+	{
+		n++;
+		return true;
+	}
+
+	size_t      n;
+};
+
+//------------------sink系列------------------end
+
+template<typename S, typename F> struct map_stage;
+template<typename S, typename F> struct filter_stage;
+template<typename S>             struct take_stage;
+
+/// 所有階段的共同介面< 衍生的階段 , 這個階段吐出的資料type >
+template<typename D, typename V>
+struct stage_base
+{
+	typedef V value_type;
+
+	template<typename F>
+	inline map_stage<D,F> map(F f) const
+	{
+		return map_stage<D,F>(derived(), f);
+	}
+
+	template<typename F>
+	inline filter_stage<D,F> filter(F f) const
+	{
+		return filter_stage<D,F>(derived(), f);
+	}
+
+	inline take_stage<D> take(size_t n) const
+	{
+		return take_stage<D>(derived(), n);
+	}
+
+	//------------------真正開始執行的操作------------------start
+
+	// 從init開始，把每筆資料用f(acc,v)累積起來
+	template<typename T, typename F>
+	inline T reduce(T init, F f) const
+	{
+		reduce_sink<T,F> k(init, f);
+		derived().run(k);
+		return k.acc;
+	}
+
+	template<typename F>
+	inline void for_each(F f) const
+	{
+		for_each_sink<F> k(f);
+		derived().run(k);
+	}
+
+	template<typename O>
+	inline O copy(O out) const
+	{
+		copy_sink<O> k(out);
+		derived().run(k);
+		return k.out;
+	}
+
+	inline size_t count() const
+	{
+		count_sink k;
+		derived().run(k);
+		return k.n;
+	}
+
+	//------------------真正開始執行的操作------------------end
+
+	private:
+
+		inline const D& derived() const { return static_cast<const D&>(*this); }
+};
+
+/// 資料來源，用一組iterator表示< iterator的type >
+template<typename I>
+struct source : stage_base<source<I>, typename std::iterator_traits<I>::value_type>
+{
+	source(I first, I last):first_(first),last_(last){}
+
+	template<typename K>
+	inline bool run(K &k) const
+	{
+		for ( I i = first_ ; i != last_ ; ++i )
+		{
+			if ( !k(*i) ) return false;
+		}
+
+		return true;
+	}
+
+	I   first_;
+	I   last_;
+};
+
+/// 把每筆資料換成f(v)< 上一個階段 , 轉換用的函式 >
+template<typename S, typename F>
+struct map_stage : stage_base<map_stage<S,F>, typename result_of<F>::type>
+{
+	map_stage(const S &s, const F &f):s_(s),f_(f){}
+
+	template<typename K>
+	inline bool run(K &k) const
+	{
+		map_sink<F,K> m(f_, k);
+		return s_.run(m);
+	}
+
+	S   s_;
+	F   f_;
+};
+
+/// 只留下f(v)為true的資料< 上一個階段 , 判斷用的函式 >
+template<typename S, typename F>
+struct filter_stage : stage_base<filter_stage<S,F>, typename S::value_type>
+{
+	filter_stage(const S &s, const F &f):s_(s),f_(f){}
+
+	template<typename K>
+	inline bool run(K &k) const
+	{
+		filter_sink<F,K> m(f_, k);
+		return s_.run(m);
+	}
+
+	S   s_;
+	F   f_;
+};
+
+/// 最多只放行n筆資料，放滿後就會讓來源停下來< 上一個階段 >
+template<typename S>
+struct take_stage : stage_base<take_stage<S>, typename S::value_type>
+{
+	take_stage(const S &s, size_t n):s_(s),n_(n){}
+
+	template<typename K>
+	inline bool run(K &k) const
+	{
+		if ( n_==0 ) return false;
+
+		take_sink<K> m(n_, k);
+		return s_.run(m);
+	}
+
+	S       s_;
+	size_t  n_;
+};
+
+}//namespace _range
+
+/// 從一組iterator建立資料流
+template<typename I>
+inline _range::source<I> make_range(I first, I last)
+{
+	return _range::source<I>(first, last);
+}
+
+/// 從整個容器建立資料流
+template<typename C>
+inline _range::source<typename C::const_iterator> make_range(const C &c)
+{
+	return _range::source<typename C::const_iterator>(c.begin(), c.end());
+}
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_RANGE_HPP_
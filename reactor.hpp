@@ -0,0 +1,318 @@
+/**
+ * @file      reactor.hpp
+ * @brief     用 epoll 監看檔案描述子，就緒時呼叫對應的 handler
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::reactor r;
+ *     r.add(sock, EPOLLIN | EPOLLET, std::bind(&Session::OnReady, &session, _1, _2));
+ *     while ( running ) r.run_once(100);
+ *
+ * handler 的簽名是 void(int fd, unsigned events)，events 就是 epoll 回報的 EPOLLIN/EPOLLOUT 等旗標
+ * handler 以 inplace_function 的形式放在依 fd 編號排列的表格裡，不用查 map 也不會配置記憶體
+ * 表格按頁配置，新增 fd 時舊的 handler 不會搬家，所以 handler 裡可以放心地 add()
+ * 要邊緣觸發就在 events 加上 EPOLLET，這時 handler 必須自己把資料讀到 EAGAIN 為止
+ *
+ * handler 可以在執行途中 remove() 任何 fd，包括自己的
+ * handler 丟出的例外會直接傳給 run_once() 的呼叫端，這一批剩下的事件就不分派了，之後仍可照常使用
+ * 同一批結果裡已被移除的 fd 不會再被呼叫，即使那個編號又被新的 fd 用掉了
+ * 但是不要在 handler 裡替自己的 fd 換上新的 handler，請先 remove() 再到外面 add()
+ *
+ * 只支援 Linux
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_REACTOR_HPP_
+#define _STD_REACTOR_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif defined(__linux__)
+
+#include <cstddef>
+#include <cerrno>
+#include <stdint.h>
+#include <vector>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <inplace_function.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+/// 以epoll為基礎的事件分派器
+class reactor
+{
+	public:
+
+		enum
+		{
+			handler_capacity = 64,      // 每個handler最多能佔用的位元組
+			batch_size       = 64,      // 每次epoll_wait()最多取回幾筆結果
+			page_bits        = 8        // 每頁有2^page_bits個fd
+		};
+
+		typedef inplace_function<void(int, unsigned), handler_capacity> handler;
+
+		reactor():epfd_(epoll_create1(EPOLL_CLOEXEC)),count_(0),stop_(false),dispatching_(false){}
+
+		~reactor()
+		{
+			for ( size_t i=0 ; i<pages_.size() ; i++ )
+			{
+				delete [] pages_[i];
+			}
+
+			if ( epfd_>=0 ) close(epfd_);
+		}
+
+		/// epoll_create1()失敗的話是false
+		inline bool valid() const { return epfd_>=0; }
+
+		/// 開始監看fd，h可以是函式指標、bind()的回傳值或 function<void(int,unsigned)>
+		/// 失敗時回傳false，原因留在errno
+		template<typename T>
+		bool add(int fd, unsigned events, const T &h)
+		{
+			slot *s = prepare(fd);
+
+			if ( !s ) return false;
+
+			s->h = h;
+			return attach(fd, events, s);
+		}
+
+		bool add(int fd, unsigned events, const function<void(int, unsigned)> &h)
+		{
+			slot *s = prepare(fd);
+
+			if ( !s ) return false;
+
+			s->h.emplace< function<void(int, unsigned)> >(h);
+			return attach(fd, events, s);
+		}
+
+		/// 改變要監看的事件
+		bool modify(int fd, unsigned events)
+		{
+			slot *s = find(fd);
+
+			if ( !s )
+			{
+				errno = ENOENT;
+				return false;
+			}
+
+			epoll_event ev = make_event(fd, events, s->gen);
+			return epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev)==0;
+		}
+
+		/// 停止監看fd，請在close(fd)之前呼叫
+		bool remove(int fd)
+		{
+			slot *s = find(fd);
+
+			if ( !s )
+			{
+				errno = ENOENT;
+				return false;
+			}
+
+			epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, 0);
+			s->used = false;
+			s->gen++;                           // 同一批結果裡剩下的事件從此對不上號
+			count_--;
+
+			if ( dispatching_ )
+			{
+				dead_.push_back(fd);            // 可能正在執行它，等這批處理完再清掉
+			}
+			else
+			{
+				s->h.reset();
+			}
+
+			return true;
+		}
+
+		/// 等待最多timeout_ms毫秒(-1代表一直等)，並分派這段期間就緒的fd
+		/// 回傳呼叫了幾個handler，出錯時回傳-1
+		int run_once(int timeout_ms)
+		{
+			epoll_event evs[batch_size];
+			int n = epoll_wait(epfd_, evs, batch_size, timeout_ms);
+
+			if ( n<0 )
+			{
+				return errno==EINTR ? 0 : -1;
+			}
+
+			int called = 0;
+			dispatch_guard guard(this);
+
+			for ( int i=0 ; i<n ; i++ )
+			{
+				int      fd  = int(evs[i].data.u64 & 0xffffffffu);
+				unsigned gen = unsigned(evs[i].data.u64 >> 32);
+				slot     *s  = find(fd);
+
+				if ( !s || s->gen!=gen ) continue;      // 這批結果產生之後就被移除了
+
+				s->h(fd, evs[i].events);
+				called++;
+			}
+
+			return called;
+		}
+
+		/// 一直分派事件，直到有人呼叫stop()或者發生錯誤
+		void run()
+		{
+			stop_ = false;
+
+			while ( !stop_ )
+			{
+				if ( run_once(-1)<0 ) break;
+			}
+		}
+
+		/// 讓run()在這一批處理完之後返回，通常是在handler裡呼叫
+		inline void stop() { stop_ = true; }
+
+		/// 目前監看中的fd數量
+		inline size_t size() const { return count_; }
+
+		inline int native_handle() const { return epfd_; }
+
+	private:
+
+		reactor(const reactor&);                // 不允許複製
+		reactor& operator=(const reactor&);
+
+		// 分派期間的記號，離開run_once()時(包括handler丟出例外)一定會清掉，並釋放途中被移除的handler
+		struct dispatch_guard
+		{
+			explicit dispatch_guard(reactor *r):owner(r) { owner->dispatching_ = true; }
+
+			~dispatch_guard()
+			{
+				owner->dispatching_ = false;
+				owner->sweep();
+			}
+
+			reactor     *owner;
+		};
+
+		void sweep()
+		{
+			for ( size_t i=0 ; i<dead_.size() ; i++ )
+			{
+				slot *s = at(dead_[i]);
+
+				if ( !s->used ) s->h.reset();
+			}
+
+			dead_.clear();
+		}
+
+		struct slot
+		{
+			slot():gen(0),used(false){}
+
+			handler     h;
+			unsigned    gen;        // 每次移除就加一，用來丟掉過期的事件
+			bool        used;
+		};
+
+		// epoll_data放不下指標加上世代，所以放fd跟世代，查表只要兩次索引
+		static inline epoll_event make_event(int fd, unsigned events, unsigned gen)
+		{
+			epoll_event ev;
+			ev.events = events;
+			ev.data.u64 = uint64_t(unsigned(fd)) | (uint64_t(gen) << 32);
+			return ev;
+		}
+
+		inline slot* at(int fd) const
+		{
+			return &pages_[size_t(fd) >> page_bits][size_t(fd) & ((1u<<page_bits)-1)];
+		}
+
+		// 已登記的fd才找得到
+		inline slot* find(int fd) const
+		{
+			if ( fd<0 || (size_t(fd) >> page_bits) >= pages_.size() ) return 0;
+
+			slot *s = at(fd);
+			return s->used ? s : 0;
+		}
+
+		// 確保表格大到放得下fd，並檢查fd還沒登記過
+		slot* prepare(int fd)
+		{
+			if ( fd<0 )
+			{
+				errno = EBADF;
+				return 0;
+			}
+
+			while ( (size_t(fd) >> page_bits) >= pages_.size() )
+			{
+				pages_.push_back(new slot[size_t(1) << page_bits]);
+			}
+
+			slot *s = at(fd);
+
+			if ( s->used )
+			{
+				errno = EEXIST;
+				return 0;
+			}
+
+			return s;
+		}
+
+		bool attach(int fd, unsigned events, slot *s)
+		{
+			epoll_event ev = make_event(fd, events, s->gen);
+
+			if ( epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev)!=0 )
+			{
+				if ( dispatching_ )
+				{
+					dead_.push_back(fd);        // slot裡可能是正在執行的舊handler，這批處理完再清掉
+				}
+				else
+				{
+					s->h.reset();
+				}
+
+				return false;
+			}
+
+			s->used = true;
+			count_++;
+			return true;
+		}
+
+		int                 epfd_;
+		std::vector<slot*>  pages_;     // 每頁2^page_bits個slot，頁本身不會搬家
+		std::vector<int>    dead_;      // 分派途中被移除、等著清掉handler的fd
+		size_t              count_;
+		bool                stop_;
+		bool                dispatching_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_REACTOR_HPP_
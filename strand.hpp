@@ -0,0 +1,238 @@
+/**
+ * @file      strand.hpp
+ * @brief     讓投遞到同一個 strand 的工作依序一次只執行一個，不需要鎖
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     thread_pool pool(16);                        // 任何提供 post(const function<void()>&) 的執行器
+ *     std::strand<thread_pool> s(pool);            // 每個 session 各自一個
+ *     s.post(std::bind(&Session::OnRead, &session, n));
+ *     s.dispatch(std::bind(&Session::OnTimer, &session));
+ *
+ * 同一個 strand 上的工作保證依投遞順序執行，而且彼此不會同時執行
+ * 不同的 strand 之間互不影響，可以在執行器的不同執行緒上同時跑
+ *
+ * post() 一律排進佇列，strand 閒置時才把一次清空佇列的工作交給執行器
+ * dispatch() 在 strand 閒置時直接在呼叫端的執行緒執行，忙碌時就跟 post() 一樣
+ * 佇列是無鎖的多生產者單消費者串列，搶的只有一個計數器，不會像 mutex 那樣讓執行緒排隊睡覺
+ * 一次最多連續執行 batch_size 個工作，之後重新排回執行器，避免霸佔執行緒
+ *
+ * 工作不可以丟出例外，strand 解構之前必須確定已經沒有工作了
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_STRAND_HPP_
+#define _STD_STRAND_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <cstddef>
+#include <functional.hpp>
+#include <bind.hpp>
+#include <atomic.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _strand{
+
+// 等別的執行緒把串列接好，這段空窗只有幾個指令長
+inline void relax()
+{
+	#if defined(_WIN32)
+		SwitchToThread();
+	#else
+		sched_yield();
+	#endif
+}
+
+struct node
+{
+	node():next(0){}
+	explicit node(const function<void()> &f):task(f),next(0){}
+
+	function<void()>    task;
+	atomic<node*>       next;
+};
+
+/// 無鎖的多生產者單消費者佇列(Dmitry Vyukov的作法)，節點本身就是資料
+class queue
+{
+	public:
+
+		queue():head_(&stub_),tail_(&stub_){}
+
+		// 任何執行緒都可以呼叫
+		void push(node *n)
+		{
+			n->next.store(0, memory_order_relaxed);
+			node *prev = head_.exchange(n, memory_order_acq_rel);
+			prev->next.store(n, memory_order_release);      // 在這之前消費端看得到head卻走不過去
+		}
+
+		// 只有消費端能呼叫，串列正在被接上時也會回傳0
+		node* pop()
+		{
+			node *t    = tail_;
+			node *next = t->next.load(memory_order_acquire);
+
+			if ( t==&stub_ )
+			{
+				if ( !next ) return 0;
+
+				tail_ = next;
+				t     = next;
+				next  = next->next.load(memory_order_acquire);
+			}
+
+			if ( next )
+			{
+				tail_ = next;
+				return t;
+			}
+
+			if ( t!=head_.load(memory_order_acquire) ) return 0;
+
+			// t是最後一個節點，塞一個stub到後面才能把t拿走
+			push(&stub_);
+			next = t->next.load(memory_order_acquire);
+
+			if ( next )
+			{
+				tail_ = next;
+				return t;
+			}
+
+			return 0;
+		}
+
+	private:
+
+		queue(const queue&);
+		queue& operator=(const queue&);
+
+		atomic<node*>   head_;      // 生產端從這裡接上
+		node            *tail_;     // 消費端從這裡拿走
+		node            stub_;
+};
+
+}//namespace _strand
+
+
+/// 把工作依序串行化的執行器< 底層執行器 >
+template<typename E>
+class strand
+{
+	public:
+
+		enum
+		{
+			batch_size = 64     // 每次交給執行器之後最多連續執行幾個工作
+		};
+
+		typedef E executor_type;
+
+		explicit strand(E &ex):ex_(ex),count_(0){}
+
+		~strand()
+		{
+			_strand::node *n;
+
+			while ( (n = queue_.pop())!=0 )
+			{
+				delete n;
+			}
+		}
+
+		/// 排進佇列，由執行器的某個執行緒來執行
+		void post(const function<void()> &f)
+		{
+			queue_.push(new _strand::node(f));
+
+			if ( count_.fetch_add(1)==0 )
+			{
+				schedule();         // strand原本閒置，由我們負責叫醒它
+			}
+		}
+
+		/// strand閒置時直接在目前的執行緒執行，否則跟post()一樣
+		void dispatch(const function<void()> &f)
+		{
+			long idle = 0;
+
+			if ( !count_.compare_exchange_strong(idle, 1) )
+			{
+				post(f);
+				return;
+			}
+
+			f();
+
+			if ( count_.fetch_sub(1)!=1 )
+			{
+				schedule();         // 執行期間又有人排了工作，剩下的交給執行器
+			}
+		}
+
+		/// 還沒執行完的工作數量，包括正在執行的那個，只能拿來參考
+		inline long pending() const { return count_.load(); }
+
+		inline E& get_executor() const { return ex_; }
+
+	private:
+
+		strand(const strand&);              // 不允許複製
+		strand& operator=(const strand&);
+
+		inline void schedule()
+		{
+			ex_.post(bind(&strand::drain, this));
+		}
+
+		// 同一時間只會有一個執行緒在這裡
+		void drain()
+		{
+			for ( int i=0 ; i<batch_size ; i++ )
+			{
+				_strand::node *n;
+
+				// 計數器說有工作，就一定會接上，只是可能還要等一下
+				while ( (n = queue_.pop())==0 )
+				{
+					_strand::relax();
+				}
+
+				n->task();
+				delete n;
+
+				if ( count_.fetch_sub(1)==1 ) return;      // 佇列空了，strand回到閒置
+			}
+
+			schedule();     // 還有工作，但是先讓執行器去處理別人的
+		}
+
+		E                   &ex_;
+		_strand::queue      queue_;
+		atomic<long>        count_;     // 排隊中加上執行中的工作數量，從0變成1的人負責排程
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_STRAND_HPP_
@@ -0,0 +1,479 @@
+/**
+ * @file      task_graph.hpp
+ * @brief     依相依關係排程的工作圖，建好一次之後可以反覆執行
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::task_graph g(4);                            // 4個工作執行緒，呼叫run()的執行緒也會幫忙
+ *     size_t a = g.add(&Physics);
+ *     size_t b = g.add(std::bind(&Renderer::Cull, &renderer, camera));
+ *     size_t c = g.add(std::bind(&Renderer::Draw, &renderer));
+ *     g.precede(a, c);                                 // a做完才能做c
+ *     g.precede(b, c);
+ *     g.freeze();                                      // 固定結構，有環的話回傳false
+ *
+ *     while ( running ) g.run();                       // 每一幀跑一次，全部做完才返回
+ *
+ * freeze()把節點跟邊攤平成一個陣列，每個節點帶一個原子計數器記錄還差幾個前置工作
+ * run()只會把計數器重設回去，執行期間不會配置記憶體，也不會上鎖
+ * 前置工作都完成的節點放進無鎖的環狀佇列，工作執行緒搶著拿
+ * 做完一個節點時，第一個變成可以執行的後續節點直接在同一個執行緒接著做，不必進佇列
+ *
+ * 只有每次run()的開始與結束會用條件變數叫醒或等待工作執行緒
+ * 執行期間空閒的執行緒會一邊讓出CPU一邊等，適合短而密集的工作
+ *
+ * freeze()之後就不能再add()或precede()，節點不可以丟出例外，也不要在節點裡呼叫run()
+ * 需要 pthread
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_TASK_GRAPH_HPP_
+#define _STD_TASK_GRAPH_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#elif !defined(_WIN32)
+
+#include <cstddef>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <functional.hpp>
+#include <atomic.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+namespace _task_graph{
+
+/// 固定容量的無鎖多生產者多消費者佇列(Dmitry Vyukov的作法)，只放節點編號
+class ready_queue
+{
+	public:
+
+		ready_queue():cells_(0),mask_(0),head_(0),tail_(0){}
+		~ready_queue() { delete [] cells_; }
+
+		// 容量會調成2的次方，每次run()每個節點最多進來一次，所以不會滿
+		void init(size_t n)
+		{
+			size_t cap = 2;
+
+			while ( cap < n ) cap <<= 1;
+
+			delete [] cells_;
+			cells_ = new cell[cap];
+			mask_  = cap-1;
+		}
+
+		// 只在沒有任何執行緒使用佇列時呼叫
+		void reset()
+		{
+			for ( size_t i=0 ; i<=mask_ ; i++ )
+			{
+				cells_[i].seq.store(i, memory_order_relaxed);
+			}
+
+			head_.store(0, memory_order_relaxed);
+			tail_.store(0, memory_order_relaxed);
+		}
+
+		void push(size_t v)
+		{
+			size_t pos = tail_.load(memory_order_relaxed);
+			cell   *c;
+
+			for (;;)
+			{
+				c = &cells_[pos & mask_];
+				size_t seq = c->seq.load(memory_order_acquire);
+
+				if ( seq==pos )
+				{
+					if ( tail_.compare_exchange_weak(pos, pos+1, memory_order_relaxed) ) break;
+				}
+				else
+				{
+					pos = tail_.load(memory_order_relaxed);     // 被別人搶先了
+				}
+			}
+
+			c->data = v;
+			c->seq.store(pos+1, memory_order_release);
+		}
+
+		bool pop(size_t &v)
+		{
+			size_t pos = head_.load(memory_order_relaxed);
+			cell   *c;
+
+			for (;;)
+			{
+				c = &cells_[pos & mask_];
+				size_t seq = c->seq.load(memory_order_acquire);
+
+				if ( seq==pos+1 )
+				{
+					if ( head_.compare_exchange_weak(pos, pos+1, memory_order_relaxed) ) break;
+				}
+				else if ( seq==pos )
+				{
+					return false;       // 空的
+				}
+				else
+				{
+					pos = head_.load(memory_order_relaxed);
+				}
+			}
+
+			v = c->data;
+			c->seq.store(pos+mask_+1, memory_order_release);
+			return true;
+		}
+
+	private:
+
+		ready_queue(const ready_queue&);
+		ready_queue& operator=(const ready_queue&);
+
+		struct cell
+		{
+			atomic<size_t>  seq;        // 等於位置代表可以寫，等於位置加一代表可以讀
+			size_t          data;
+		};
+
+		cell            *cells_;
+		size_t          mask_;
+		atomic<size_t>  head_;
+		atomic<size_t>  tail_;
+};
+
+/// 攤平後的節點
+struct node
+{
+	node():preds(0),first(0),count(0){}
+
+	function<void()>    fn;
+	atomic<long>        pending;    // 這次run()還差幾個前置工作
+	long                preds;      // 前置工作的總數，每次run()拿來重設pending
+	size_t              first;      // 後續節點在succ_裡的起點
+	size_t              count;
+};
+
+}//namespace _task_graph
+
+
+/// 依相依關係把工作分派給數個執行緒的工作圖
+class task_graph
+{
+	public:
+
+		static const size_t npos = size_t(-1);
+
+		/// threads是額外的工作執行緒數量，0代表全部在呼叫run()的執行緒上做
+		explicit task_graph(size_t threads = 0)
+			:nodes_(0),count_(0),frozen_(false),gen_(0),active_(0),stop_(false),done_(0)
+		{
+			pthread_mutex_init(&lock_, 0);
+			pthread_cond_init(&start_, 0);
+			pthread_cond_init(&finish_, 0);
+
+			threads_.reserve(threads);
+
+			// 建不起來的就算了，只留下真的有在跑的，run()等待的數量也只算它們
+			for ( size_t i=0 ; i<threads ; i++ )
+			{
+				pthread_t th;
+
+				if ( pthread_create(&th, 0, &task_graph::worker_main, this)==0 )
+				{
+					threads_.push_back(th);
+				}
+			}
+		}
+
+		~task_graph()
+		{
+			pthread_mutex_lock(&lock_);
+			stop_ = true;
+			pthread_cond_broadcast(&start_);
+			pthread_mutex_unlock(&lock_);
+
+			for ( size_t i=0 ; i<threads_.size() ; i++ )
+			{
+				pthread_join(threads_[i], 0);
+			}
+
+			delete [] nodes_;
+			pthread_cond_destroy(&finish_);
+			pthread_cond_destroy(&start_);
+			pthread_mutex_destroy(&lock_);
+		}
+
+		/// 加入一個節點並回傳它的編號，freeze()之後回傳npos
+		size_t add(const function<void()> &f)
+		{
+			if ( frozen_ ) return npos;
+
+			fns_.push_back(f);
+			return fns_.size()-1;
+		}
+
+		/// 讓before做完才能開始做after，編號不對或已經freeze()時回傳false
+		bool precede(size_t before, size_t after)
+		{
+			if ( frozen_ || before>=fns_.size() || after>=fns_.size() || before==after ) return false;
+
+			edges_.push_back(edge(before, after));
+			return true;
+		}
+
+		/// 把結構攤平成陣列，之後只能run()，有環的話回傳false並維持原狀
+		bool freeze()
+		{
+			if ( frozen_ ) return true;
+
+			size_t n = fns_.size();
+			std::vector<size_t> out(n+1, 0);
+			std::vector<long>   in(n, 0);
+
+			for ( size_t i=0 ; i<edges_.size() ; i++ )
+			{
+				out[edges_[i].first+1]++;
+				in[edges_[i].second]++;
+			}
+
+			for ( size_t i=0 ; i<n ; i++ )
+			{
+				out[i+1] += out[i];         // 變成每個節點的後續節點在succ_裡的起點
+			}
+
+			std::vector<size_t> succ(edges_.size());
+			std::vector<size_t> fill(out.begin(), out.end()-1);
+
+			for ( size_t i=0 ; i<edges_.size() ; i++ )
+			{
+				succ[fill[edges_[i].first]++] = edges_[i].second;
+			}
+
+			if ( has_cycle(n, out, succ, in) ) return false;
+
+			nodes_ = new _task_graph::node[n];
+
+			for ( size_t i=0 ; i<n ; i++ )
+			{
+				nodes_[i].fn    = fns_[i];
+				nodes_[i].preds = in[i];
+				nodes_[i].first = out[i];
+				nodes_[i].count = out[i+1]-out[i];
+
+				if ( in[i]==0 ) roots_.push_back(i);
+			}
+
+			succ_.swap(succ);
+			count_ = n;
+			queue_.init(n);
+			frozen_ = true;
+
+			std::vector< function<void()> >().swap(fns_);      // 建構用的資料不再需要了
+			std::vector<edge>().swap(edges_);
+			return true;
+		}
+
+		/// 執行整張圖一次，全部做完才返回，還沒freeze()的話會先freeze()
+		bool run()
+		{
+			if ( !freeze() ) return false;
+			if ( count_==0 ) return true;
+
+			for ( size_t i=0 ; i<count_ ; i++ )
+			{
+				nodes_[i].pending.store(nodes_[i].preds, memory_order_relaxed);
+			}
+
+			queue_.reset();
+			done_.store(0, memory_order_relaxed);
+
+			for ( size_t i=0 ; i<roots_.size() ; i++ )
+			{
+				queue_.push(roots_[i]);
+			}
+
+			// 上面的重設透過這把鎖讓工作執行緒看到
+			pthread_mutex_lock(&lock_);
+			gen_++;
+			active_ = threads_.size();
+			pthread_cond_broadcast(&start_);
+			pthread_mutex_unlock(&lock_);
+
+			work();
+
+			// 等所有工作執行緒都離開work()，下次run()才能重設
+			pthread_mutex_lock(&lock_);
+
+			while ( active_ )
+			{
+				pthread_cond_wait(&finish_, &lock_);
+			}
+
+			pthread_mutex_unlock(&lock_);
+			return true;
+		}
+
+		/// 節點數量
+		inline size_t size() const { return frozen_ ? count_ : fns_.size(); }
+
+		inline bool frozen() const { return frozen_; }
+
+		/// 實際建立成功的工作執行緒數量，可能比要求的少
+		inline size_t threads() const { return threads_.size(); }
+
+	private:
+
+		task_graph(const task_graph&);              // 不允許複製
+		task_graph& operator=(const task_graph&);
+
+		struct edge
+		{
+			edge(size_t a, size_t b):first(a),second(b){}
+
+			size_t  first;
+			size_t  second;
+		};
+
+		// Kahn演算法，所有節點都排得出來就沒有環
+		static bool has_cycle(size_t n, const std::vector<size_t> &out, const std::vector<size_t> &succ, std::vector<long> in)
+		{
+			std::vector<size_t> stack;
+			size_t seen = 0;
+
+			for ( size_t i=0 ; i<n ; i++ )
+			{
+				if ( in[i]==0 ) stack.push_back(i);
+			}
+
+			while ( !stack.empty() )
+			{
+				size_t i = stack.back();
+				stack.pop_back();
+				seen++;
+
+				for ( size_t k=out[i] ; k<out[i+1] ; k++ )
+				{
+					if ( --in[succ[k]]==0 ) stack.push_back(succ[k]);
+				}
+			}
+
+			return seen!=n;
+		}
+
+		static void* worker_main(void *p)
+		{
+			static_cast<task_graph*>(p)->worker();
+			return 0;
+		}
+
+		void worker()
+		{
+			size_t my_gen = 0;
+
+			for (;;)
+			{
+				pthread_mutex_lock(&lock_);
+
+				while ( gen_==my_gen && !stop_ )
+				{
+					pthread_cond_wait(&start_, &lock_);
+				}
+
+				if ( stop_ )
+				{
+					pthread_mutex_unlock(&lock_);
+					return;
+				}
+
+				my_gen = gen_;
+				pthread_mutex_unlock(&lock_);
+
+				work();
+
+				pthread_mutex_lock(&lock_);
+
+				if ( --active_==0 ) pthread_cond_signal(&finish_);
+
+				pthread_mutex_unlock(&lock_);
+			}
+		}
+
+		// 一直拿可以做的節點來做，直到這次run()全部做完
+		void work()
+		{
+			while ( done_.load(memory_order_acquire)!=count_ )
+			{
+				size_t i;
+
+				if ( !queue_.pop(i) )
+				{
+					sched_yield();
+					continue;
+				}
+
+				while ( i!=npos )
+				{
+					_task_graph::node &n = nodes_[i];
+					size_t next = npos;
+
+					n.fn();
+
+					for ( size_t k=n.first ; k<n.first+n.count ; k++ )
+					{
+						size_t s = succ_[k];
+
+						if ( nodes_[s].pending.fetch_sub(1)==1 )
+						{
+							if ( next==npos ) next = s;     // 留一個自己做
+							else                      queue_.push(s);
+						}
+					}
+
+					done_.fetch_add(1);
+					i = next;
+				}
+			}
+		}
+
+		// 建構期間的資料
+		std::vector< function<void()> >     fns_;
+		std::vector<edge>                   edges_;
+
+		// freeze()之後的資料
+		_task_graph::node                   *nodes_;
+		size_t                              count_;
+		std::vector<size_t>                 succ_;      // 所有節點的後續節點攤平放在一起
+		std::vector<size_t>                 roots_;     // 沒有前置工作的節點
+		_task_graph::ready_queue            queue_;
+		bool                                frozen_;
+
+		// 工作執行緒
+		std::vector<pthread_t>              threads_;
+		pthread_mutex_t                     lock_;
+		pthread_cond_t                      start_;     // 新的一次run()開始了
+		pthread_cond_t                      finish_;    // 工作執行緒都離開work()了
+		size_t                              gen_;       // 第幾次run()
+		size_t                              active_;    // 還在work()裡的工作執行緒
+		bool                                stop_;
+		atomic<size_t>                      done_;      // 這次run()做完的節點數量
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_TASK_GRAPH_HPP_
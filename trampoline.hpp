@@ -0,0 +1,583 @@
+/**
+ * @file      trampoline.hpp
+ * @brief     把 function 或 bind() 的結果交給只認得 C 函式指標的函式庫
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     std::function<int(const void*, const void*)> cmp = std::bind(&Compare, _1, _2, order);
+ *     std::c_callback<int(const void*, const void*, void*)> cb(cmp);
+ *     qsort_r(base, n, size, cb.fn, cb.ctx);
+ *
+ * 簽名裡的 void* 就是C函式庫會原封不動傳回來的那個參數
+ *     c_callback       void* 放在最後面，例如 glibc 的 qsort_r
+ *     c_callback_first void* 放在最前面，例如 pthread_create、sqlite3_exec
+ *     c_callback_data  沒有void*參數，而是放在第一個參數指向的結構的 data 欄位，例如 libuv 的 handle
+ *
+ * fn 是針對目標type產生的靜態函式，ctx 就是目標物件的位址，整個過程不會配置任何記憶體
+ * 目標物件要活得比C函式庫持有這組callback的時間更久，所以建構子只收左值，拒絕暫時物件
+ * 目標若是bind()的回傳值，呼叫時只會有這一層間接呼叫
+ *
+ * 例外不可以穿過C的堆疊，目標函式請自行處理掉
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_TRAMPOLINE_HPP_
+#define _STD_TRAMPOLINE_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+/// C端看到的函式簽名，最後一個參數是void*< C端的函式簽名 >
+template<typename Sig> struct c_callback{};
+
+/// C端看到的函式簽名，第一個參數是void*< C端的函式簽名 >
+template<typename Sig> struct c_callback_first{};
+
+/// C端看到的函式簽名，第一個參數是帶有data欄位的結構指標< C端的函式簽名 >
+template<typename Sig> struct c_callback_data{};
+
+
+//---------------------------c_callback---------------------------start
+
+/// void*加上零個參數的版本
+template<typename R>
+struct c_callback<R(void*)>
+{
+	typedef R (*pointer)(void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c)
+	{
+		return (*static_cast<F*>(c))();
+	}
+};
+
+/// void*加上一個參數的版本
+template<typename R, typename A1>
+struct c_callback<R(A1, void*)>
+{
+	typedef R (*pointer)(A1, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, void *c)
+	{
+		return (*static_cast<F*>(c))(a1);
+	}
+};
+
+/// void*加上兩個參數的版本
+template<typename R, typename A1, typename A2>
+struct c_callback<R(A1, A2, void*)>
+{
+	typedef R (*pointer)(A1, A2, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2);
+	}
+};
+
+/// void*加上三個參數的版本
+template<typename R, typename A1, typename A2, typename A3>
+struct c_callback<R(A1, A2, A3, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3);
+	}
+};
+
+/// void*加上四個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4>
+struct c_callback<R(A1, A2, A3, A4, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, A4, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, A4 a4, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4);
+	}
+};
+
+/// void*加上五個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5>
+struct c_callback<R(A1, A2, A3, A4, A5, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, A4, A5, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5);
+	}
+};
+
+/// void*加上六個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+struct c_callback<R(A1, A2, A3, A4, A5, A6, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, A4, A5, A6, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6);
+	}
+};
+
+/// void*加上七個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+struct c_callback<R(A1, A2, A3, A4, A5, A6, A7, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, A4, A5, A6, A7, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6, a7);
+	}
+};
+
+/// void*加上八個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+struct c_callback<R(A1, A2, A3, A4, A5, A6, A7, A8, void*)>
+{
+	typedef R (*pointer)(A1, A2, A3, A4, A5, A6, A7, A8, void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, A8 a8, void *c)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6, a7, a8);
+	}
+};
+
+//---------------------------c_callback---------------------------end
+
+//---------------------------c_callback_first---------------------------start
+
+/// void*加上零個參數的版本
+template<typename R>
+struct c_callback_first<R(void*)>
+{
+	typedef R (*pointer)(void*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c)
+	{
+		return (*static_cast<F*>(c))();
+	}
+};
+
+/// void*加上一個參數的版本
+template<typename R, typename A1>
+struct c_callback_first<R(void*, A1)>
+{
+	typedef R (*pointer)(void*, A1);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1)
+	{
+		return (*static_cast<F*>(c))(a1);
+	}
+};
+
+/// void*加上兩個參數的版本
+template<typename R, typename A1, typename A2>
+struct c_callback_first<R(void*, A1, A2)>
+{
+	typedef R (*pointer)(void*, A1, A2);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2)
+	{
+		return (*static_cast<F*>(c))(a1, a2);
+	}
+};
+
+/// void*加上三個參數的版本
+template<typename R, typename A1, typename A2, typename A3>
+struct c_callback_first<R(void*, A1, A2, A3)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3);
+	}
+};
+
+/// void*加上四個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4>
+struct c_callback_first<R(void*, A1, A2, A3, A4)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3, A4);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3, A4 a4)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4);
+	}
+};
+
+/// void*加上五個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5>
+struct c_callback_first<R(void*, A1, A2, A3, A4, A5)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3, A4, A5);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5);
+	}
+};
+
+/// void*加上六個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+struct c_callback_first<R(void*, A1, A2, A3, A4, A5, A6)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3, A4, A5, A6);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6);
+	}
+};
+
+/// void*加上七個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+struct c_callback_first<R(void*, A1, A2, A3, A4, A5, A6, A7)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3, A4, A5, A6, A7);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6, a7);
+	}
+};
+
+/// void*加上八個參數的版本
+template<typename R, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+struct c_callback_first<R(void*, A1, A2, A3, A4, A5, A6, A7, A8)>
+{
+	typedef R (*pointer)(void*, A1, A2, A3, A4, A5, A6, A7, A8);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 跟fn一起交給C函式庫的void*
+
+	template<typename F>
+	explicit c_callback_first(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(void *c, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, A8 a8)
+	{
+		return (*static_cast<F*>(c))(a1, a2, a3, a4, a5, a6, a7, a8);
+	}
+};
+
+//---------------------------c_callback_first---------------------------end
+
+//---------------------------c_callback_data---------------------------start
+
+/// 結構指標加上零個參數的版本
+template<typename R, typename H>
+struct c_callback_data<R(H*)>
+{
+	typedef R (*pointer)(H*);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h)
+	{
+		return (*static_cast<F*>(h->data))(h);
+	}
+};
+
+/// 結構指標加上一個參數的版本
+template<typename R, typename H, typename A1>
+struct c_callback_data<R(H*, A1)>
+{
+	typedef R (*pointer)(H*, A1);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1)
+	{
+		return (*static_cast<F*>(h->data))(h, a1);
+	}
+};
+
+/// 結構指標加上兩個參數的版本
+template<typename R, typename H, typename A1, typename A2>
+struct c_callback_data<R(H*, A1, A2)>
+{
+	typedef R (*pointer)(H*, A1, A2);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2);
+	}
+};
+
+/// 結構指標加上三個參數的版本
+template<typename R, typename H, typename A1, typename A2, typename A3>
+struct c_callback_data<R(H*, A1, A2, A3)>
+{
+	typedef R (*pointer)(H*, A1, A2, A3);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2, A3 a3)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2, a3);
+	}
+};
+
+/// 結構指標加上四個參數的版本
+template<typename R, typename H, typename A1, typename A2, typename A3, typename A4>
+struct c_callback_data<R(H*, A1, A2, A3, A4)>
+{
+	typedef R (*pointer)(H*, A1, A2, A3, A4);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2, A3 a3, A4 a4)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2, a3, a4);
+	}
+};
+
+/// 結構指標加上五個參數的版本
+template<typename R, typename H, typename A1, typename A2, typename A3, typename A4, typename A5>
+struct c_callback_data<R(H*, A1, A2, A3, A4, A5)>
+{
+	typedef R (*pointer)(H*, A1, A2, A3, A4, A5);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2, a3, a4, a5);
+	}
+};
+
+/// 結構指標加上六個參數的版本
+template<typename R, typename H, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+struct c_callback_data<R(H*, A1, A2, A3, A4, A5, A6)>
+{
+	typedef R (*pointer)(H*, A1, A2, A3, A4, A5, A6);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2, a3, a4, a5, a6);
+	}
+};
+
+/// 結構指標加上七個參數的版本
+template<typename R, typename H, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+struct c_callback_data<R(H*, A1, A2, A3, A4, A5, A6, A7)>
+{
+	typedef R (*pointer)(H*, A1, A2, A3, A4, A5, A6, A7);
+
+	pointer     fn;     // 交給C函式庫的函式指標
+	void        *ctx;   // 請放進h->data
+
+	template<typename F>
+	explicit c_callback_data(F &f):fn(&thunk<F>),ctx((void*)&f){}
+
+	template<typename F>
+	static R thunk(H *h, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7)
+	{
+		return (*static_cast<F*>(h->data))(h, a1, a2, a3, a4, a5, a6, a7);
+	}
+};
+
+//---------------------------c_callback_data---------------------------end
+
+//---------------------------常見的C callback---------------------------start
+
+/// pthread_create
+typedef c_callback_first<void*(void*)>                              c_thread_callback;
+
+/// glibc的qsort_r
+typedef c_callback<int(const void*, const void*, void*)>            c_compare_callback;
+
+/// BSD的qsort_r、Windows的qsort_s
+typedef c_callback_first<int(void*, const void*, const void*)>      c_compare_callback_first;
+
+/// 只帶著void*的通知或清理函式
+typedef c_callback_first<void(void*)>                               c_void_callback;
+
+/// sqlite3_exec
+typedef c_callback_first<int(void*, int, char**, char**)>           c_row_callback;
+
+//---------------------------常見的C callback---------------------------end
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_TRAMPOLINE_HPP_
@@ -0,0 +1,415 @@
+/**
+ * @file      variant_function.hpp
+ * @brief     只能裝進固定幾種type的function，不配置記憶體也不走虛擬函式
+ * @author    ToyAuthor
+ * @copyright Public Domain
+ * <pre>
+ * 用法:
+ *     typedef BIND_TYPE_OF_HANDLER_A   HandlerA;     // 某個bind()的回傳值type
+ *     typedef void (*HandlerB)(int);
+ *
+ *     std::variant_function<void(int), HandlerA, HandlerB> f = std::bind(&Foo::OnRead, &foo, _1);
+ *     f(5);
+ *     f = &OnWrite;
+ *
+ * 可以裝的type最多12種，必須在樣板參數裡一一列出
+ * 目標物件直接存在variant_function內部，呼叫時用switch分派
+ * 每個case裡的目標type都是已知的，所以編譯器能直接把呼叫展開
+ * 塞進沒有列出的type會在編譯期失敗，呼叫空的 variant_function 會丟出 bad_function_call
+ *
+ * http://github.com/ToyAuthor/functional
+ * </pre>
+ */
+
+
+#ifndef _STD_VARIANT_FUNCTION_HPP_
+#define _STD_VARIANT_FUNCTION_HPP_
+
+// 判斷編譯器是否為C++11，是就改用標準庫吧，除非有定義FUNCTIONAL_OWN_IMPLEMENTATION
+#if __cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+
+#include <functional>
+
+#else
+
+#include <new>
+#include <functional.hpp>
+
+namespace _STD_FUNCTIONAL_NS{
+
+
+namespace _variant{
+
+/// 沒有使用到的樣板參數都會是這個type
+struct none{};
+
+template<typename A, typename B> struct is_same       { enum { value = 0 }; };
+template<typename A>             struct is_same<A,A>  { enum { value = 1 }; };
+
+// 編譯期檢查用，只有true的版本有定義
+template<bool B> struct type_must_be_listed;
+template<>       struct type_must_be_listed<true>{};
+
+template<int A, int B> struct max_of { enum { value = A>B ? A : B }; };
+
+/// 找出T在清單裡是第幾個，從1開始算，找不到就是0
+template<typename T, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9, typename T10, typename T11, typename T12>
+struct index_of
+{
+	enum { value =
+		is_same<T,T1>::value ? 1 :
+		is_same<T,T2>::value ? 2 :
+		is_same<T,T3>::value ? 3 :
+		is_same<T,T4>::value ? 4 :
+		is_same<T,T5>::value ? 5 :
+		is_same<T,T6>::value ? 6 :
+		is_same<T,T7>::value ? 7 :
+		is_same<T,T8>::value ? 8 :
+		is_same<T,T9>::value ? 9 :
+		is_same<T,T10>::value ? 10 :
+		is_same<T,T11>::value ? 11 :
+		is_same<T,T12>::value ? 12 :
+		0 };
+};
+
+/// 呼叫空的variant_function，交給function的空核心處理，丟出的例外跟統計數字都跟function一樣
+template<typename R, typename S>
+inline R empty_call(const S &s)
+{
+	return _functional::core_empty<R,S>::instance.CallFunction(s);
+}
+
+//-----------------------依照目標的type決定呼叫方式-----------------------start
+
+// bind()的回傳值直接交給eval()
+template<typename R, typename S, typename A, typename B, typename C>
+inline R call(const bind_t<A,B,C> &b, const S &s)
+{
+	return b.eval(s);
+}
+
+// 一般函式指標或其他仿函式就讓storage把參數攤開
+template<typename R, typename S, typename T>
+inline R call(const T &t, const S &s)
+{
+	return s.Do(type<R>(), t);
+}
+
+// 空著的位置
+template<typename R, typename S>
+inline R call(const none &, const S &s)
+{
+	return empty_call<R>(s);
+}
+
+//-----------------------依照目標的type決定呼叫方式-----------------------end
+
+/// 依照函式簽名提供對應的operator()，樣板原型沒有用處< 衍生類別 , 函式簽名 >
+template<typename D, typename Sig> struct call_base{};
+
+/// 零個參數版本
+template<typename D, typename R>
+struct call_base<D, R()>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R()>::type St;
+
+	inline R operator()() const
+	{
+		return static_cast<const D&>(*this).invoke(St());
+	}
+};
+
+/// 一個參數版本
+template<typename D, typename R, typename P1>
+struct call_base<D, R(P1)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1)>::type St;
+
+	inline R operator()(P1 p1) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1)));
+	}
+};
+
+/// 兩個參數版本
+template<typename D, typename R, typename P1, typename P2>
+struct call_base<D, R(P1, P2)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2)>::type St;
+
+	inline R operator()(P1 p1, P2 p2) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2)));
+	}
+};
+
+/// 三個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3>
+struct call_base<D, R(P1, P2, P3)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3)));
+	}
+};
+
+/// 四個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4>
+struct call_base<D, R(P1, P2, P3, P4)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4)));
+	}
+};
+
+/// 五個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
+struct call_base<D, R(P1, P2, P3, P4, P5)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5)));
+	}
+};
+
+/// 六個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6)));
+	}
+};
+
+/// 七個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7)));
+	}
+};
+
+/// 八個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7, P8)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8)));
+	}
+};
+
+/// 九個參數版本
+template<typename D, typename R, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+struct call_base<D, R(P1, P2, P3, P4, P5, P6, P7, P8, P9)>
+{
+	typedef R result_type;
+	typedef typename _functional::call_storage<R(P1,P2,P3,P4,P5,P6,P7,P8,P9)>::type St;
+
+	inline R operator()(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9) const
+	{
+		return static_cast<const D&>(*this).invoke(St(_functional::pass<P1>(p1), _functional::pass<P2>(p2), _functional::pass<P3>(p3), _functional::pass<P4>(p4), _functional::pass<P5>(p5), _functional::pass<P6>(p6), _functional::pass<P7>(p7), _functional::pass<P8>(p8), _functional::pass<P9>(p9)));
+	}
+};
+
+}//namespace _variant
+
+/// 只接受固定幾種type的function< 函式簽名 , 可以裝進來的type們 >
+template<typename Sig, typename T1,
+	typename T2  = _variant::none, typename T3  = _variant::none, typename T4  = _variant::none,
+	typename T5  = _variant::none, typename T6  = _variant::none, typename T7  = _variant::none,
+	typename T8  = _variant::none, typename T9  = _variant::none, typename T10 = _variant::none,
+	typename T11 = _variant::none, typename T12 = _variant::none>
+class variant_function : public _variant::call_base<variant_function<Sig, T1, T2, T3, T4, T5, T6, T7, T8, T9, T10, T11, T12>, Sig>
+{
+	public:
+
+		typedef _variant::call_base<variant_function, Sig>  base;
+		typedef typename base::result_type                  R;
+		typedef typename base::St                           St;
+
+		variant_function():index_(0){}
+
+		template<typename T>
+		variant_function(const T &t):index_(0)
+		{
+			assign(t);
+		}
+
+		variant_function(const variant_function &other):index_(0)
+		{
+			copy(other);
+		}
+
+		~variant_function(){ destroy(); }
+
+		variant_function& operator=(const variant_function &other)
+		{
+			if ( this != &other )
+			{
+				destroy();
+				copy(other);
+			}
+
+			return *this;
+		}
+
+		template<typename T>
+		variant_function& operator=(const T &t)
+		{
+			destroy();
+			assign(t);
+			return *this;
+		}
+
+		operator bool () const
+		{
+			return index_ != 0;
+		}
+
+		/// 目前裝的是清單裡的第幾個type，0代表空的
+		inline int which() const
+		{
+			return index_;
+		}
+
+		// 給call_base用的，依照type編號分派
+		template<typename S>
+		inline R invoke(const S &s) const
+		{
+			switch ( index_ )
+			{
+				case 1: return _variant::call<R>(*ptr<T1>(), s);
+				case 2: return _variant::call<R>(*ptr<T2>(), s);
+				case 3: return _variant::call<R>(*ptr<T3>(), s);
+				case 4: return _variant::call<R>(*ptr<T4>(), s);
+				case 5: return _variant::call<R>(*ptr<T5>(), s);
+				case 6: return _variant::call<R>(*ptr<T6>(), s);
+				case 7: return _variant::call<R>(*ptr<T7>(), s);
+				case 8: return _variant::call<R>(*ptr<T8>(), s);
+				case 9: return _variant::call<R>(*ptr<T9>(), s);
+				case 10: return _variant::call<R>(*ptr<T10>(), s);
+				case 11: return _variant::call<R>(*ptr<T11>(), s);
+				case 12: return _variant::call<R>(*ptr<T12>(), s);
+				default: break;
+			}
+
+			return _variant::empty_call<R>(s);
+		}
+
+	private:
+
+		enum { size = _variant::max_of<sizeof(T1),
+		              _variant::max_of<sizeof(T2),
+		              _variant::max_of<sizeof(T3),
+		              _variant::max_of<sizeof(T4),
+		              _variant::max_of<sizeof(T5),
+		              _variant::max_of<sizeof(T6),
+		              _variant::max_of<sizeof(T7),
+		              _variant::max_of<sizeof(T8),
+		              _variant::max_of<sizeof(T9),
+		              _variant::max_of<sizeof(T10),
+		              _variant::max_of<sizeof(T11), sizeof(T12)
+		              >::value>::value>::value>::value>::value>::value>::value>::value>::value>::value>::value };
+
+		template<typename T>
+		inline T* ptr() { return reinterpret_cast<T*>(&store_); }
+
+		template<typename T>
+		inline const T* ptr() const { return reinterpret_cast<const T*>(&store_); }
+
+		template<typename T>
+		void assign(const T &t)
+		{
+			enum { I = _variant::index_of<T, T1, T2, T3, T4, T5, T6, T7, T8, T9, T10, T11, T12>::value };
+
+			// T不在清單裡的話這裡會因為type_must_be_listed<false>沒有定義而編譯失敗
+			(void)sizeof(_variant::type_must_be_listed<(I != 0)>);
+
+			new (&store_) T(t);
+			index_ = I;
+		}
+
+		void copy(const variant_function &other)
+		{
+			switch ( other.index_ )
+			{
+				case 1: new (&store_) T1(*other.template ptr<T1>()); break;
+				case 2: new (&store_) T2(*other.template ptr<T2>()); break;
+				case 3: new (&store_) T3(*other.template ptr<T3>()); break;
+				case 4: new (&store_) T4(*other.template ptr<T4>()); break;
+				case 5: new (&store_) T5(*other.template ptr<T5>()); break;
+				case 6: new (&store_) T6(*other.template ptr<T6>()); break;
+				case 7: new (&store_) T7(*other.template ptr<T7>()); break;
+				case 8: new (&store_) T8(*other.template ptr<T8>()); break;
+				case 9: new (&store_) T9(*other.template ptr<T9>()); break;
+				case 10: new (&store_) T10(*other.template ptr<T10>()); break;
+				case 11: new (&store_) T11(*other.template ptr<T11>()); break;
+				case 12: new (&store_) T12(*other.template ptr<T12>()); break;
+				default: break;
+			}
+
+			index_ = other.index_;
+		}
+
+		void destroy()
+		{
+			switch ( index_ )
+			{
+				case 1: ptr<T1>()->~T1(); break;
+				case 2: ptr<T2>()->~T2(); break;
+				case 3: ptr<T3>()->~T3(); break;
+				case 4: ptr<T4>()->~T4(); break;
+				case 5: ptr<T5>()->~T5(); break;
+				case 6: ptr<T6>()->~T6(); break;
+				case 7: ptr<T7>()->~T7(); break;
+				case 8: ptr<T8>()->~T8(); break;
+				case 9: ptr<T9>()->~T9(); break;
+				case 10: ptr<T10>()->~T10(); break;
+				case 11: ptr<T11>()->~T11(); break;
+				case 12: ptr<T12>()->~T12(); break;
+				default: break;
+			}
+
+			index_ = 0;
+		}
+
+		union
+		{
+			char                    buf[size];
+			_functional::max_align  align;
+		}                           store_;     // 目標物件就放在這裡
+		int                         index_;
+};
+
+
+}//namespace _STD_FUNCTIONAL_NS
+
+
+#endif//__cplusplus > 201100L && !defined(FUNCTIONAL_OWN_IMPLEMENTATION)
+#endif//_STD_VARIANT_FUNCTION_HPP_